@@ -1,5 +1,5 @@
 import React, { useState, useRef } from 'react';
-import { useCamera } from './hooks/useCamera';
+import { useCamera, type Segment } from './hooks/useCamera';
 import { motion, useMotionValue, AnimatePresence } from 'framer-motion';
 import {
   Camera,
@@ -30,40 +30,61 @@ function cn(...inputs: ClassValue[]) {
 
 const App: React.FC = () => {
   const host = window.location.hostname;
-  const { status, segments, connected, toasts, removeToast, sendCommand, sendGimbalCommand } =
-    useCamera(`ws://${host}:8080`);
+  const {
+    status,
+    segments,
+    connected,
+    toasts,
+    removeToast,
+    sendCommand,
+    sendGimbalCommand,
+    selectTarget,
+  } = useCamera(`ws://${host}:8080`);
   const [activeTab, setActiveTab] = useState<'controls' | 'ai' | 'recordings'>('controls');
   const [invertY, setInvertY] = useState(false);
   const [zoom, setZoom] = useState(1.0);
+  const [tapToTrack, setTapToTrack] = useState(false);
 
   // Gimbal Motion Values
   const joystickX = useMotionValue(0);
   const joystickY = useMotionValue(0);
   const lastCommandTime = useRef(0);
+  const keepAlive = useRef<ReturnType<typeof setInterval> | null>(null);
 
-  const handleJoystickDrag = () => {
-    const now = Date.now();
-    if (now - lastCommandTime.current < 33) return;
-    lastCommandTime.current = now;
-
-    const x = joystickX.get();
-    const y = joystickY.get();
-
-    const pan = (x / 55) * 50;
-    let pitch = (-y / 55) * 50;
+  // Stick deflection (-1..1); the server shapes it into gimbal speed at a fixed rate
+  const sendJoystick = () => {
+    const pan = joystickX.get() / 55;
+    let pitch = -joystickY.get() / 55;
 
     if (invertY) {
       pitch = -pitch;
     }
 
-    sendGimbalCommand('gimbal-set-speed', { pitch, pan, roll: 0 });
+    sendGimbalCommand('gimbal-input', { pitch, pan });
+  };
+
+  const handleJoystickDrag = () => {
+    // Resend while the stick is held still; the server stops the gimbal when input stops
+    if (!keepAlive.current) {
+      keepAlive.current = setInterval(sendJoystick, 100);
+    }
+
+    const now = Date.now();
+    if (now - lastCommandTime.current < 33) return;
+    lastCommandTime.current = now;
+    sendJoystick();
   };
 
   const handleJoystickReset = () => {
+    if (keepAlive.current) {
+      clearInterval(keepAlive.current);
+      keepAlive.current = null;
+    }
     joystickX.set(0);
     joystickY.set(0);
     lastCommandTime.current = 0;
-    sendGimbalCommand('gimbal-stop');
+    // A centered stick ramps the gimbal down to a stop
+    sendGimbalCommand('gimbal-input', { pitch: 0, pan: 0 });
   };
 
   const handleZoom = (direction: 'in' | 'out') => {
@@ -73,6 +94,18 @@ const App: React.FC = () => {
     sendCommand('zoom-set', { zoom: newZoom });
   };
 
+  // Clicks can't reach into the player iframe, so a transparent layer over it
+  // takes them while tap-to-track is on
+  const trackOverlay = connected && tapToTrack && (
+    <div
+      className="absolute inset-0 cursor-crosshair"
+      onClick={(e) => {
+        const rect = e.currentTarget.getBoundingClientRect();
+        selectTarget((e.clientX - rect.left) / rect.width, (e.clientY - rect.top) / rect.height);
+      }}
+    />
+  );
+
   const isAIEnabled = Boolean(status?.status?.aiMode && status.status.aiMode !== 0);
 
   const handleToggleAI = () => {
@@ -84,6 +117,10 @@ const App: React.FC = () => {
     );
   };
 
+  // A proxy with a kept full-res pair exports the full-res clip
+  const exportName = (seg: Segment) =>
+    seg.type === 'proxy' && seg.linked ? seg.linked : seg.filename;
+
   const handleDownloadSegment = async (filename: string) => {
     try {
       const downloadUrl = `http://${host}:8080/api/download/${filename}`;
@@ -421,6 +458,17 @@ const App: React.FC = () => {
         >
           Deselect Target
         </button>
+        <button
+          onClick={() => setTapToTrack(!tapToTrack)}
+          className={cn(
+            'w-full py-1.5 border rounded-lg text-[10px] transition-colors',
+            tapToTrack
+              ? 'bg-blue-600/20 border-blue-500/50 text-blue-300'
+              : 'bg-white/5 hover:bg-white/10 border-white/10 text-zinc-400'
+          )}
+        >
+          {tapToTrack ? 'Tap Preview to Track: On' : 'Tap Preview to Track'}
+        </button>
       </section>
 
       {/* Gesture Controls */}
@@ -476,12 +524,12 @@ const App: React.FC = () => {
                 <div
                   className={cn(
                     'p-2 rounded-lg shrink-0',
-                    seg.type === 'video'
+                    seg.type !== 'audio'
                       ? 'bg-black/30 text-blue-500'
                       : 'bg-black/30 text-amber-500'
                   )}
                 >
-                  {seg.type === 'video' ? (
+                  {seg.type !== 'audio' ? (
                     <Video className="w-4 h-4" />
                   ) : (
                     <Mic className="w-4 h-4" />
@@ -501,6 +549,14 @@ const App: React.FC = () => {
                         Temp Buffer
                       </span>
                     )}
+                    {seg.type === 'proxy' && seg.linked && (
+                      <>
+                        <span className="w-1 h-1 rounded-full bg-zinc-700" />
+                        <span className="text-[9px] font-bold text-blue-500 uppercase tracking-widest">
+                          Full-res
+                        </span>
+                      </>
+                    )}
                     <span className="w-1 h-1 rounded-full bg-zinc-700" />
                     <span className="text-[9px] font-mono text-zinc-600">30.2s</span>
                   </div>
@@ -515,9 +571,9 @@ const App: React.FC = () => {
                   </button>
                 )}
                 <button
-                  onClick={() => handleDownloadSegment(seg.filename)}
+                  onClick={() => handleDownloadSegment(exportName(seg))}
                   className="p-2 hover:bg-emerald-500/20 text-zinc-400 hover:text-emerald-500 rounded-lg transition-colors"
-                  title="Download clip"
+                  title={exportName(seg) !== seg.filename ? 'Download full-res clip' : 'Download clip'}
                 >
                   <Save className="w-3.5 h-3.5" />
                 </button>
@@ -598,6 +654,7 @@ const App: React.FC = () => {
                   </div>
                 </div>
               )}
+              {trackOverlay}
 
               {/* HUD Overlays */}
               <div className="absolute top-4 left-4 flex flex-col gap-2 opacity-0 group-hover:opacity-100 transition-opacity">
@@ -734,6 +791,7 @@ const App: React.FC = () => {
               </div>
             </div>
           )}
+          {trackOverlay}
 
           {/* Quick Status Pills */}
           <div className="absolute bottom-3 left-3 right-3 flex gap-2 overflow-x-auto scrollbar-hide">
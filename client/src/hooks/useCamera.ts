@@ -8,10 +8,11 @@ export interface CameraStatus {
 
 export interface Segment {
   filename: string;
-  type: 'video' | 'audio';
+  type: 'video' | 'audio' | 'proxy';
   timestamp: number;
   keep: boolean;
   reason?: string;
+  linked?: string | null; // proxy <-> full-res pair (RECORD_PROFILE=dual)
 }
 
 export interface Toast {
@@ -20,14 +21,46 @@ export interface Toast {
   type: 'error' | 'success' | 'info';
 }
 
+// Segments kept in view; matches the server's getRecentSegments()
+const RECENT_SEGMENTS = 20;
+
+const isObject = (value: any) =>
+  value !== null && typeof value === 'object' && !Array.isArray(value);
+
+// Apply a JSON merge patch (RFC 7386) from /ws/status
+const applyMergePatch = (target: any, patch: any): any => {
+  if (!isObject(patch)) return patch;
+  const result = isObject(target) ? { ...target } : {};
+  for (const [key, value] of Object.entries(patch)) {
+    if (value === null) delete result[key];
+    else result[key] = applyMergePatch(result[key], value);
+  }
+  return result;
+};
+
+const mergeSegments = (prev: Segment[], rows: Segment[]) => {
+  const byName = new Map(prev.map((s) => [s.filename, s]));
+  rows.forEach((s) => byName.set(s.filename, s));
+  return [...byName.values()]
+    .sort((a, b) => b.timestamp - a.timestamp)
+    .slice(0, RECENT_SEGMENTS);
+};
+
+// Binary message types on /ws/gimbal (see server/src/index.ts)
+const MSG_SELECT_BOX = 0x01;
+// Half the side of the box drawn around a tap on the preview, normalized
+const TAP_BOX_HALF = 0.08;
+
 export const useCamera = (baseUrl: string) => {
   const [status, setStatus] = useState<CameraStatus | null>(null);
   const [segments, setSegments] = useState<Segment[]>([]);
   const [connected, setConnected] = useState(false);
   const [toasts, setToasts] = useState<Toast[]>([]);
   const ws = useRef<WebSocket | null>(null);
-  const pollTimeoutRef = useRef<number | null>(null);
   const toastIdRef = useRef(0);
+  // Commands waiting for the server to confirm their state change, by correlation id
+  const pendingCommands = useRef<Map<string, string>>(new Map());
+  const commandIdRef = useRef(0);
 
   // Derive REST API URL from base URL
   const apiUrl = baseUrl.replace('ws://', 'http://').replace(':8080', ':8080');
@@ -66,84 +99,92 @@ export const useCamera = (baseUrl: string) => {
     }
   }, [apiUrl]);
 
-  // Fetch status once on mount
-  useEffect(() => {
-    fetchStatus();
-  }, [fetchStatus]);
+  // ==================== WebSocket: Status Stream ====================
+  // One snapshot on connect, then only what changed
+  const statusUrl = baseUrl.replace(':8080', ':8080/ws/status');
+  const statusWs = useRef<WebSocket | null>(null);
 
-  // ==================== Smart Polling After Command ====================
-  const pollUntilStateMatches = useCallback(
-    async (predicate: (status: CameraStatus | null) => boolean, commandName: string) => {
-      const startTime = Date.now();
-      const TIMEOUT = 5000; // 5 seconds
-      const POLL_INTERVAL = 1000; // 1 second
-
-      const poll = async () => {
-        // Clear any existing timeout
-        if (pollTimeoutRef.current) {
-          clearTimeout(pollTimeoutRef.current);
-        }
-
-        const newStatus = await fetchStatus();
+  useEffect(() => {
+    let state: any = null;
+    let closed = false;
+    let retry: number | null = null;
 
-        if (predicate(newStatus)) {
-          // State matches expectation - success!
-          return true;
-        }
+    const connect = () => {
+      const socket = new WebSocket(statusUrl);
+      statusWs.current = socket;
 
-        if (Date.now() - startTime >= TIMEOUT) {
-          // Timeout - show error toast
-          addToast(`Failed to confirm ${commandName} - camera may not have responded`, 'error');
-          return false;
+      socket.onmessage = (event) => {
+        const { type, payload } = JSON.parse(event.data);
+        if (type === 'snapshot') {
+          state = payload.state;
+          setSegments(payload.segments || []);
+          setConnected(true);
+        } else if (type === 'delta') {
+          if (payload.state !== undefined) state = applyMergePatch(state, payload.state);
+          if (payload.segments) setSegments((prev) => mergeSegments(prev, payload.segments));
         }
+        setStatus(state?.camera ?? null);
+      };
 
-        // Keep polling
-        return new Promise<boolean>((resolve) => {
-          pollTimeoutRef.current = window.setTimeout(async () => {
-            resolve(await poll());
-          }, POLL_INTERVAL);
-        });
+      socket.onclose = () => {
+        setConnected(false);
+        if (!closed) retry = window.setTimeout(connect, 3000);
       };
+    };
 
-      return poll();
-    },
-    [fetchStatus, addToast]
-  );
+    connect();
+
+    return () => {
+      closed = true;
+      if (retry) clearTimeout(retry);
+      statusWs.current?.close();
+    };
+  }, [statusUrl]);
+
+  // The stream pushes changes; fetch only while it is down
+  const refreshStatus = useCallback(() => {
+    if (statusWs.current?.readyState !== WebSocket.OPEN) fetchStatus();
+  }, [fetchStatus]);
 
   // ==================== REST API: Send Command ====================
+  // With an expectation the server confirms the state change over the
+  // WebSocket (command-confirmed / timed-out) under a correlation id
   const sendCommand = useCallback(
     async (type: string, payload: any = {}, expectation?: { field: string; value: any }) => {
+      const id = expectation ? `${Date.now().toString(36)}-${++commandIdRef.current}` : undefined;
+      // Registered before the request: the confirmation can beat the reply
+      if (id) pendingCommands.current.set(id, type);
       try {
         const res = await fetch(`${apiUrl}/api/command`, {
           method: 'POST',
           headers: { 'Content-Type': 'application/json' },
-          body: JSON.stringify({ type, payload }),
+          body: JSON.stringify({ type, payload, id, expect: expectation }),
         });
 
         if (res.ok) {
           const data = await res.json();
 
-          // If we have an expectation, poll until it matches
-          if (expectation) {
-            pollUntilStateMatches((s) => {
-              if (!s?.status) return false;
-              return s.status[expectation.field] === expectation.value;
-            }, type);
-          } else {
-            // Just fetch once after a short delay
-            setTimeout(fetchStatus, 300);
+          if (!data.pending) {
+            if (id) pendingCommands.current.delete(id);
+            // Negative is an SDK error; 1 is a write held briefly by coalescing
+            if (expectation && typeof data.result === 'number' && data.result < 0) {
+              addToast(`Command ${type} failed`, 'error');
+            }
+            refreshStatus();
           }
 
           return data;
         } else {
+          if (id) pendingCommands.current.delete(id);
           addToast(`Command ${type} failed`, 'error');
         }
       } catch (error) {
+        if (id) pendingCommands.current.delete(id);
         console.error('Command failed:', error);
         addToast(`Command ${type} failed: ${error}`, 'error');
       }
     },
-    [apiUrl, pollUntilStateMatches, fetchStatus, addToast]
+    [apiUrl, refreshStatus, addToast]
   );
 
   // ==================== WebSocket: Gimbal Control ====================
@@ -165,6 +206,29 @@ export const useCamera = (baseUrl: string) => {
       ws.current.onerror = (err) => {
         console.error('Gimbal WebSocket error:', err);
       };
+
+      ws.current.onmessage = (event) => {
+        if (typeof event.data !== 'string') return;
+        const { type, payload } = JSON.parse(event.data);
+        if (type === 'command-confirmed' || type === 'timed-out') {
+          const command = pendingCommands.current.get(payload.id);
+          if (!command) return; // another client's command
+          pendingCommands.current.delete(payload.id);
+          if (type === 'timed-out') {
+            addToast(`Failed to confirm ${command} - camera may not have responded`, 'error');
+          }
+          refreshStatus();
+        } else if (type === 'target-selected') {
+          if (payload.error || payload.result !== 0) {
+            addToast(`Target selection failed${payload.error ? `: ${payload.error}` : ''}`);
+          } else if (!payload.selected) {
+            addToast('Target selection not supported - the camera only framed the box');
+          } else if (payload.confirmed === false) {
+            addToast('Target selection not confirmed - camera may not have responded');
+          }
+          refreshStatus();
+        }
+      };
     };
 
     connect();
@@ -173,11 +237,8 @@ export const useCamera = (baseUrl: string) => {
       if (ws.current) {
         ws.current.close();
       }
-      if (pollTimeoutRef.current) {
-        clearTimeout(pollTimeoutRef.current);
-      }
     };
-  }, [wsUrl]);
+  }, [wsUrl, addToast, refreshStatus]);
 
   // Send gimbal commands via WebSocket (low latency, no state tracking needed)
   const sendGimbalCommand = useCallback((type: string, payload: any = {}) => {
@@ -186,6 +247,19 @@ export const useCamera = (baseUrl: string) => {
     }
   }, []);
 
+  // Track whatever is under a tap on the preview (x, y normalized from the top-left)
+  const selectTarget = useCallback((x: number, y: number) => {
+    if (!ws.current || ws.current.readyState !== WebSocket.OPEN) return;
+    const clamp = (v: number) => Math.min(1, Math.max(0, v));
+    const msg = new DataView(new ArrayBuffer(17));
+    msg.setUint8(0, MSG_SELECT_BOX);
+    msg.setFloat32(1, clamp(x - TAP_BOX_HALF), true);
+    msg.setFloat32(5, clamp(y - TAP_BOX_HALF), true);
+    msg.setFloat32(9, clamp(x + TAP_BOX_HALF), true);
+    msg.setFloat32(13, clamp(y + TAP_BOX_HALF), true);
+    ws.current.send(msg.buffer);
+  }, []);
+
   return {
     status,
     segments,
@@ -194,5 +268,6 @@ export const useCamera = (baseUrl: string) => {
     removeToast,
     sendCommand, // REST API for general commands
     sendGimbalCommand, // WebSocket for gimbal only
+    selectTarget, // WebSocket, binary
   };
 };
@@ -1,4 +1,9 @@
 {
+  "variables": {
+    "whisper_dir%": "<!(node -p \"process.env.WHISPER_DIR || ''\")",
+    "with_jpeg%": "<!(node -p \"+require('fs').existsSync('/usr/include/jpeglib.h')\")",
+    "with_gstreamer%": "<!(node -p \"+(require('child_process').spawnSync('pkg-config', ['--exists', 'gstreamer-1.0', 'gstreamer-app-1.0']).status === 0)\")"
+  },
   "targets": [
     {
       "target_name": "obsbot_native",
@@ -7,7 +12,18 @@
       "cflags_cc": ["-std=c++17", "-fexceptions"],
       "sources": [
         "src/native/obsbot_addon.cpp",
-        "src/native/device_wrapper.cpp"
+        "src/native/device_wrapper.cpp",
+        "src/native/wav_reader.cpp",
+        "src/native/vad.cpp",
+        "src/native/keyword_matcher.cpp",
+        "src/native/gimbal_mover.cpp",
+        "src/native/joystick_shaper.cpp",
+        "src/native/status_watcher.cpp",
+        "src/native/shadow_registers.cpp",
+        "src/native/settings_applier.cpp",
+        "src/native/capability_cache.cpp",
+        "src/native/profile.cpp",
+        "src/native/warm_up.cpp"
       ],
       "include_dirs": [
         "<!@(node -p \"require('node-addon-api').include\")",
@@ -29,6 +45,30 @@
       ],
       "defines": ["NAPI_DISABLE_CPP_EXCEPTIONS"],
       "conditions": [
+        ["whisper_dir!=''", {
+          "sources": ["src/native/stt_worker.cpp"],
+          "defines": ["OBSBOT_WITH_WHISPER"],
+          "include_dirs": [
+            "<(whisper_dir)/include",
+            "<(whisper_dir)/ggml/include"
+          ],
+          "libraries": [
+            "-L<(whisper_dir)/build/src",
+            "-lwhisper",
+            "-Wl,-rpath,<(whisper_dir)/build/src"
+          ]
+        }],
+        ["with_jpeg==1", {
+          "sources": ["src/native/motion_detector.cpp"],
+          "defines": ["OBSBOT_WITH_JPEG"],
+          "libraries": ["-ljpeg"]
+        }],
+        ["with_gstreamer==1", {
+          "sources": ["src/native/gst_pipeline.cpp"],
+          "defines": ["OBSBOT_WITH_GSTREAMER"],
+          "cflags_cc": ["<!@(pkg-config --cflags gstreamer-1.0 gstreamer-app-1.0)"],
+          "libraries": ["<!@(pkg-config --libs gstreamer-1.0 gstreamer-app-1.0)"]
+        }],
         ["OS=='linux'", {
           "cflags": ["-fPIC"],
           "ldflags": [
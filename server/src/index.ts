@@ -2,13 +2,22 @@ import express from 'express';
 import cors from 'cors';
 import { WebSocketServer, WebSocket } from 'ws';
 import * as http from 'http';
-import { cameraService } from './services/camera';
+import { cameraService, WRITE_QUEUED } from './services/camera';
 import { ffmpegService } from './services/ffmpeg';
 import { gstreamerService } from './services/gstreamer';
 import { gstreamerSimpleService } from './services/gstreamer-simple';
 import { segmentManager } from './services/segmentManager';
 import { segmentRenamer } from './services/segmentRenamer';
 import { sttService } from './services/stt';
+import { frameTapService } from './services/frameTap';
+import { motionService } from './services/motion';
+import { snapshotService } from './services/snapshot';
+import { transcoderService } from './services/transcoder';
+import { liveViewerService } from './services/liveViewers';
+import { liveBitrateController } from './services/liveBitrate';
+import { encoderProbeService } from './services/encoderProbe';
+import { prerollService } from './services/preroll';
+import { statusStreamService } from './services/statusStream';
 import * as dotenv from 'dotenv';
 
 dotenv.config();
@@ -19,8 +28,13 @@ const AUDIO_DEVICE = process.env.AUDIO_DEVICE || 'default';
 const RTSP_URL = process.env.RTSP_URL || 'rtsp://localhost:8554/live';
 const CAPTURE_SERVICE = process.env.CAPTURE_SERVICE || 'ffmpeg';
 
-// Select capture service
-const captureService = CAPTURE_SERVICE === 'gstreamer' ? gstreamerSimpleService : ffmpegService;
+// Select capture service ('gstreamer-full' records HEVC or raw MJPEG separately from the live H.264)
+const captureService =
+  CAPTURE_SERVICE === 'gstreamer'
+    ? gstreamerSimpleService
+    : CAPTURE_SERVICE === 'gstreamer-full'
+      ? gstreamerService
+      : ffmpegService;
 
 // Express app for REST API
 const app = express();
@@ -33,12 +47,135 @@ app.use(express.json());
 app.get('/api/status', (req, res) => {
   const status = cameraService.getStatus();
   const segments = segmentManager.getRecentSegments();
-  res.json({ camera: status, segments });
+  res.json({
+    camera: status,
+    move: cameraService.getMoveState(),
+    joystick: cameraService.getJoystickStats(),
+    statusWatch: cameraService.getStatusWatchStats(),
+    writes: cameraService.getWriteStats(),
+    applySettings: cameraService.getApplyStats(),
+    warmUp: cameraService.getWarmUpStats(),
+    segments,
+    motion: motionService.getStats(),
+    transcoder: transcoderService.getStats(),
+    pipeline: captureService === gstreamerService ? gstreamerService.getStats() : null,
+    ffmpeg: captureService === ffmpegService ? ffmpegService.getStats() : null,
+    gaps: segmentManager.getRecentGaps(),
+    preroll: prerollService.getStats(),
+    encoders: encoderProbeService.getStats(),
+    live: liveViewerService.getStats(),
+    liveAbr: liveBitrateController.getStats(),
+    statusStream: statusStreamService.getStats(),
+  });
+});
+
+// GET /api/capabilities - Camera parameter ranges, from the cache (never queries the camera)
+app.get('/api/capabilities', (req, res) => {
+  const caps = cameraService.getCapabilities();
+  if (!caps) {
+    return res.status(503).json({ error: 'No camera connected' });
+  }
+  res.json(caps);
+});
+
+// GET /api/profiles - Saved camera profiles (without their data)
+app.get('/api/profiles', (req, res) => {
+  res.json(segmentManager.listProfiles());
+});
+
+// POST /api/profiles - Capture the camera's configuration. Body: { name }
+app.post('/api/profiles', async (req, res) => {
+  const name = req.body?.name;
+  if (typeof name !== 'string' || !name.trim()) {
+    return res.status(400).json({ error: 'Missing profile name' });
+  }
+  try {
+    const data = await cameraService.captureProfile();
+    segmentManager.saveProfile(name.trim(), data);
+    res.json({ success: true, name: name.trim(), size: data.length });
+  } catch (error: any) {
+    res.status(500).json({ success: false, error: error.message });
+  }
+});
+
+// POST /api/profiles/:name/restore - Write what differs from a saved profile
+app.post('/api/profiles/:name/restore', async (req, res) => {
+  const profile = segmentManager.getProfile(req.params.name);
+  if (!profile) {
+    return res.status(404).json({ error: 'Profile not found' });
+  }
+  try {
+    const result = await cameraService.restoreProfile(profile.data);
+    statusStreamService.invalidate();
+    res.json({ success: result.ok, ...result });
+  } catch (error: any) {
+    res.status(500).json({ success: false, error: error.message });
+  }
+});
+
+// DELETE /api/profiles/:name - Remove a saved profile
+app.delete('/api/profiles/:name', (req, res) => {
+  if (!segmentManager.deleteProfile(req.params.name)) {
+    return res.status(404).json({ error: 'Profile not found' });
+  }
+  res.json({ success: true });
+});
+
+// GET /api/capture/params - Encoder settings of the live and recording outputs
+app.get('/api/capture/params', (req, res) => {
+  if (captureService !== gstreamerService) {
+    return res.status(400).json({ error: 'Encoder parameters need gstreamer-full capture' });
+  }
+  res.json(gstreamerService.getParams());
+});
+
+// POST /api/capture/params - Change encoder settings at runtime
+// Body: { live?: { bitrateKbps?, keyframeInterval?, width?, height? }, recording?: { ... } }
+// Both targets are validated before either is applied.
+app.post('/api/capture/params', (req, res) => {
+  if (captureService !== gstreamerService || !gstreamerService.isInProcess()) {
+    return res.status(400).json({
+      error: 'Encoder parameters need gstreamer-full capture running in-process',
+    });
+  }
+
+  const fields = ['bitrateKbps', 'keyframeInterval', 'width', 'height'] as const;
+  const requested: Partial<Record<'live' | 'recording', Record<string, number>>> = {};
+  for (const target of ['live', 'recording'] as const) {
+    const body = req.body?.[target];
+    if (!body || typeof body !== 'object') continue;
+
+    const changes: Record<string, number> = {};
+    for (const field of fields) {
+      if (body[field] !== undefined) changes[field] = Number(body[field]);
+    }
+    try {
+      gstreamerService.checkParams(target, changes);
+    } catch (error: any) {
+      return res.status(400).json({ success: false, error: `${target}: ${error.message}` });
+    }
+    requested[target] = changes;
+  }
+
+  const results: Record<string, any> = {};
+  for (const [target, changes] of Object.entries(requested)) {
+    results[target] = gstreamerService.setParams(target as 'live' | 'recording', changes);
+  }
+  res.json({ success: true, results });
+});
+
+// POST /api/live/demand - A live stream reader is about to connect (MediaMTX runOnDemand)
+app.post('/api/live/demand', (req, res) => {
+  liveViewerService.requestDemand();
+  res.json({ success: true, live: liveViewerService.getStats() });
 });
 
 // POST /api/command - Execute a camera command
+// With { id, expect: { field, value } } the reply comes straight back with
+// pending: true, and /ws/gimbal clients get command-confirmed or timed-out
+// with that id once the camera's pushed status shows (or never shows) it.
 app.post('/api/command', async (req, res) => {
-  const { type, payload } = req.body;
+  const { type, payload, id, expect } = req.body;
 
   if (!type) {
     return res.status(400).json({ error: 'Missing command type' });
@@ -46,10 +183,20 @@ app.post('/api/command', async (req, res) => {
 
   try {
     const result = await cameraService.executeCommand(type, payload || {});
+    statusStreamService.invalidate();
 
-    // Wait for camera to update state for certain commands
-    if (['ai-set-enabled', 'ai-set-mode', 'ai-set-gesture', 'zoom-set'].includes(type)) {
-      await new Promise((resolve) => setTimeout(resolve, 300));
+    const sent = result === 0 || result === WRITE_QUEUED;
+    const confirmation =
+      id && expect && sent ? cameraService.confirmStatus(expect.field, expect.value) : null;
+    if (confirmation) {
+      confirmation.then(({ confirmed, elapsedMs }) => {
+        statusStreamService.invalidate();
+        broadcast({
+          type: confirmed ? 'command-confirmed' : 'timed-out',
+          payload: { id, type, field: expect.field, value: expect.value, elapsedMs },
+        });
+      });
+      return res.json({ success: true, result, id, pending: true });
     }
 
     // Return updated status along with result
@@ -60,6 +207,33 @@ app.post('/api/command', async (req, res) => {
   }
 });
 
+// GET /api/search?q= - Find transcripts containing the query, with word offsets
+app.get('/api/search', (req, res) => {
+  const q = typeof req.query.q === 'string' ? req.query.q : '';
+  if (!q.trim()) {
+    return res.status(400).json({ error: 'Missing query' });
+  }
+
+  const limit = Math.min(parseInt(String(req.query.limit || '50')) || 50, 500);
+  const started = Date.now();
+  const results = segmentManager.searchTranscripts(q, limit);
+  res.json({ query: q, results, elapsedMs: Date.now() - started });
+});
+
+// GET /api/snapshot - Latest camera frame, original JPEG bytes (no re-encode)
+app.get('/api/snapshot', async (req, res) => {
+  const frame = await snapshotService.capture();
+  if (!frame) {
+    return res.status(503).json({ error: 'No camera frame available' });
+  }
+
+  res.setHeader('Content-Type', 'image/jpeg');
+  res.setHeader('Cache-Control', 'no-store');
+  res.setHeader('Last-Modified', new Date(frame.timestamp).toUTCString());
+  res.setHeader('X-Frame-Timestamp', String(frame.timestamp));
+  res.send(frame.jpeg);
+});
+
 // GET /api/download/:filename - Download a segment file
 app.get('/api/download/:filename', (req, res) => {
   const { filename } = req.params;
@@ -71,7 +245,9 @@ app.get('/api/download/:filename', (req, res) => {
   let filePath: string;
 
   if (ext === '.mp4') {
-    filePath = path.join(process.cwd(), 'recordings', 'segments', filename);
+    // RECORD_PROFILE=dual proxies live next to the segments
+    const dir = filename.startsWith('proxy_') ? 'proxy' : 'segments';
+    filePath = path.join(process.cwd(), 'recordings', dir, filename);
   } else if (ext === '.wav') {
     filePath = path.join(process.cwd(), 'recordings', 'audio', filename);
   } else {
@@ -95,25 +271,77 @@ app.get('/api/download/:filename', (req, res) => {
 // ==================== HTTP + WebSocket Server ====================
 
 const server = http.createServer(app);
-const wss = new WebSocketServer({ server, path: '/ws/gimbal' });
+const wss = new WebSocketServer({ noServer: true });
+
+// Several WebSocket endpoints share the server, so upgrades are routed by path
+server.on('upgrade', (req, socket, head) => {
+  const { pathname } = new URL(req.url || '/', 'http://localhost');
+  if (pathname === '/ws/gimbal') {
+    wss.handleUpgrade(req, socket, head, (ws) => wss.emit('connection', ws, req));
+  } else if (pathname === '/ws/status') {
+    statusStreamService.handleUpgrade(req, socket, head);
+  } else {
+    socket.destroy();
+  }
+});
 
 const clients: Set<WebSocket> = new Set();
 
+function broadcast(message: { type: string; payload: any }) {
+  const data = JSON.stringify(message);
+  clients.forEach((client) => {
+    if (client.readyState === WebSocket.OPEN) client.send(data);
+  });
+}
+
+// Binary messages on /ws/gimbal: one type byte, then little-endian fields
+const MSG_SELECT_BOX = 0x01; // float32 xMin, yMin, xMax, yMax (normalized)
+
+async function handleBinaryMessage(ws: WebSocket, data: Buffer) {
+  if (data.length === 17 && data[0] === MSG_SELECT_BOX) {
+    const box = {
+      xMin: data.readFloatLE(1),
+      yMin: data.readFloatLE(5),
+      xMax: data.readFloatLE(9),
+      yMax: data.readFloatLE(13),
+    };
+    try {
+      const selection = await cameraService.selectTargetByBox(box);
+      statusStreamService.invalidate();
+      ws.send(JSON.stringify({ type: 'target-selected', payload: { box, ...selection } }));
+    } catch (error: any) {
+      ws.send(JSON.stringify({ type: 'target-selected', payload: { box, error: error.message } }));
+    }
+  }
+}
+
 wss.on('connection', (ws: WebSocket) => {
   console.log('Gimbal WebSocket client connected');
   clients.add(ws);
+  // An open client is showing the live video
+  liveViewerService.addClient();
 
-  ws.on('message', async (message: string) => {
+  ws.on('message', async (message: Buffer, isBinary: boolean) => {
     try {
-      const { type, payload } = JSON.parse(message);
+      if (isBinary) {
+        await handleBinaryMessage(ws, message);
+        return;
+      }
+      const { type, payload } = JSON.parse(message.toString());
 
-      // Only handle gimbal commands via WebSocket
-      if (type === 'gimbal-set-speed') {
+      // Only handle gimbal commands via WebSocket. Joystick and speed frames
+      // arrive many times a second and don't re-read the status; the stop
+      // that ends the move does
+      if (type === 'gimbal-input') {
+        await cameraService.executeCommand('gimbal-input', payload);
+      } else if (type === 'gimbal-set-speed') {
         await cameraService.executeCommand('gimbal-set-speed', payload);
       } else if (type === 'gimbal-stop') {
         await cameraService.executeCommand('gimbal-stop', {});
+        statusStreamService.invalidate();
       } else if (type === 'gimbal-reset') {
         await cameraService.executeCommand('gimbal-reset', {});
+        statusStreamService.invalidate();
       }
     } catch (error: any) {
       console.error('Gimbal WebSocket error:', error.message);
@@ -122,6 +350,7 @@ wss.on('connection', (ws: WebSocket) => {
 
   ws.on('close', () => {
     clients.delete(ws);
+    liveViewerService.removeClient();
     console.log('Gimbal WebSocket client disconnected');
   });
 });
@@ -132,26 +361,42 @@ server.listen(Number(PORT), '0.0.0.0', () => {
   console.log(`Server listening on all interfaces at port ${PORT}`);
   console.log(`  REST API: http://0.0.0.0:${PORT}/api/status`);
   console.log(`  Gimbal WS: ws://0.0.0.0:${PORT}/ws/gimbal`);
+  console.log(`  Status WS: ws://0.0.0.0:${PORT}/ws/status`);
 
   // Start segment renamer
   segmentRenamer.start();
+  prerollService.start();
+  liveViewerService.start();
+  liveBitrateController.start();
 
   // Start capture after a short delay
-  setTimeout(() => {
+  setTimeout(async () => {
     console.log(`Using capture service: ${CAPTURE_SERVICE}`);
+    // Pick encoders before the first start (benchmarks once per host, then cached)
+    await encoderProbeService.probe(captureService === ffmpegService ? 'ffmpeg' : 'gstreamer');
     captureService.startCapture({
       videoDevice: VIDEO_DEVICE,
       audioDevice: AUDIO_DEVICE,
       rtspUrl: RTSP_URL,
+      pcmOutput: sttService.pcmOutput,
+      frameOutput: frameTapService.frameOutput,
+      frameRate: frameTapService.frameRate,
     });
   }, 2000);
 });
 
 // Graceful shutdown
-process.on('SIGINT', () => {
+process.on('SIGINT', async () => {
   console.log('Shutting down...');
-  captureService.stopCapture();
+  // In-process pipelines must drain before exit to finalize the open segment
+  await captureService.stopCapture();
   segmentRenamer.stop();
+  prerollService.stop();
+  sttService.close();
+  frameTapService.close();
+  transcoderService.close();
+  liveViewerService.stop();
+  liveBitrateController.stop();
   cameraService.close();
   process.exit(0);
 });
@@ -0,0 +1,212 @@
+#include "capability_cache.hpp"
+#include "worker_support.hpp"
+#include <iterator>
+
+namespace {
+
+using RangeQuery = int32_t (Device::*)(Device::UvcParamRange&);
+
+// Every range the SDK reports, named as in getCapabilities
+const std::pair<const char*, RangeQuery> kRanges[] = {
+    {"zoom", &Device::cameraGetRangeZoomAbsoluteR},
+    {"focus", &Device::cameraGetRangeFocusAbsolute},
+    {"whiteBalance", &Device::cameraGetRangeWhiteBalanceR},
+    {"exposure", &Device::cameraGetRangeExposureAbsolute},
+    {"iso", &Device::cameraGetRangeMAEIsoR},
+    {"evBias", &Device::cameraGetRangePAEEvBiasR},
+    {"antiFlicker", &Device::cameraGetRangeAntiFlickR},
+    {"brightness", &Device::cameraGetRangeImageBrightnessR},
+    {"contrast", &Device::cameraGetRangeImageContrastR},
+    {"saturation", &Device::cameraGetRangeImageSaturationR},
+    {"sharpness", &Device::cameraGetRangeImageSharpR},
+    {"hue", &Device::cameraGetRangeImageHueR},
+};
+
+RangeQuery FindRange(const std::string& name) {
+    for (const auto& range : kRanges) {
+        if (name == range.first) return range.second;
+    }
+    return nullptr;
+}
+
+// False if the read failed (a USB timeout, a busy device); otherwise out is the
+// range, or nullopt when the device answered with an empty one
+bool ReadRange(Device& device, RangeQuery query, std::optional<Device::UvcParamRange>& out) {
+    Device::UvcParamRange range;
+    if ((device.*query)(range) != 0) return false;
+    out = range.max_ < range.min_ ? std::nullopt : std::optional<Device::UvcParamRange>(range);
+    return true;
+}
+
+struct BuildResult {
+    Capabilities caps;
+    std::vector<Napi::Promise::Deferred> deferreds;
+};
+
+// Resolve everyone waiting on a build on the JS thread
+void SettleBuild(Napi::Env env, Napi::Function, BuildResult* result) {
+    Napi::Object descriptor = CapabilityCache::ToObject(env, result->caps);
+    for (auto& deferred : result->deferreds) {
+        deferred.Resolve(descriptor);
+    }
+    delete result;
+}
+
+}  // namespace
+
+CapabilityCache::CapabilityCache(Napi::Env env, std::shared_ptr<Device> device)
+    : device_(std::move(device)) {
+    caps_.productType = static_cast<int>(device_->productType());
+    caps_.devVersion = device_->devVersion();
+
+    tsfn_ = MakeResultTsfn(env, "CapabilityCacheResult");
+}
+
+CapabilityCache::~CapabilityCache() {
+    stopping_ = true;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    tsfn_.Release();
+}
+
+Napi::Promise CapabilityCache::Build(Napi::Env env) {
+    auto deferred = Napi::Promise::Deferred::New(env);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (caps_.complete) {
+        deferred.Resolve(ToObject(env, caps_));
+        return deferred.Promise();
+    }
+
+    waiting_.push_back(deferred);
+    if (!building_) {
+        building_ = true;
+        RestartWorker(thread_, &CapabilityCache::Run, this);
+    }
+    return deferred.Promise();
+}
+
+std::optional<Device::UvcParamRange> CapabilityCache::Range(const std::string& name) {
+    RangeQuery query = FindRange(name);
+    if (!query) return std::nullopt;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = caps_.ranges.find(name);
+        if (it != caps_.ranges.end()) return it->second;
+        if (failures_[name] >= kMaxFailures) return std::nullopt;
+    }
+
+    std::optional<Device::UvcParamRange> range;
+    const bool answered = ReadRange(*device_, query, range);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!answered) {
+        failures_[name]++;
+        return std::nullopt;
+    }
+    caps_.ranges[name] = range;
+    caps_.complete = caps_.ranges.size() == std::size(kRanges);
+    return range;
+}
+
+bool CapabilityCache::Seed(Napi::Object descriptor) {
+    Napi::Value productType = descriptor.Get("productType");
+    Napi::Value devVersion = descriptor.Get("devVersion");
+    Napi::Value ranges = descriptor.Get("ranges");
+    if (!productType.IsNumber() || !devVersion.IsString() || !ranges.IsObject()) return false;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (productType.As<Napi::Number>().Int32Value() != caps_.productType ||
+        devVersion.As<Napi::String>().Utf8Value() != caps_.devVersion) {
+        return false;
+    }
+
+    Napi::Object obj = ranges.As<Napi::Object>();
+    for (const auto& entry : kRanges) {
+        Napi::Value value = obj.Get(entry.first);
+        if (value.IsNull()) {
+            caps_.ranges[entry.first] = std::nullopt;
+        } else if (value.IsObject()) {
+            Napi::Object r = value.As<Napi::Object>();
+            if (!r.Get("min").IsNumber() || !r.Get("max").IsNumber() ||
+                !r.Get("step").IsNumber() || !r.Get("default").IsNumber()) {
+                continue;
+            }
+            Device::UvcParamRange range;
+            range.min_ = r.Get("min").As<Napi::Number>().Int64Value();
+            range.max_ = r.Get("max").As<Napi::Number>().Int64Value();
+            range.step_ = r.Get("step").As<Napi::Number>().Int64Value();
+            range.default_ = r.Get("default").As<Napi::Number>().Int64Value();
+            range.valid_ = true;
+            caps_.ranges[entry.first] = range;
+        }
+        // Missing: not read yet when the descriptor was saved
+    }
+    caps_.complete = caps_.ranges.size() == std::size(kRanges);
+    return true;
+}
+
+Napi::Object CapabilityCache::Descriptor(Napi::Env env) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return ToObject(env, caps_);
+}
+
+Napi::Object CapabilityCache::ToObject(Napi::Env env, const Capabilities& caps) {
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("productType", caps.productType);
+    obj.Set("devVersion", caps.devVersion);
+    obj.Set("complete", caps.complete);
+
+    Napi::Object ranges = Napi::Object::New(env);
+    for (const auto& [name, range] : caps.ranges) {
+        if (!range) {
+            ranges.Set(name, env.Null());
+            continue;
+        }
+        Napi::Object r = Napi::Object::New(env);
+        r.Set("min", static_cast<double>(range->min_));
+        r.Set("max", static_cast<double>(range->max_));
+        r.Set("step", static_cast<double>(range->step_));
+        r.Set("default", static_cast<double>(range->default_));
+        ranges.Set(name, r);
+    }
+    obj.Set("ranges", ranges);
+    return obj;
+}
+
+bool CapabilityCache::Fill() {
+    for (const auto& entry : kRanges) {
+        if (stopping_) break;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (caps_.ranges.count(entry.first) || failures_[entry.first] >= kMaxFailures) {
+                continue;
+            }
+        }
+        std::optional<Device::UvcParamRange> range;
+        const bool answered = ReadRange(*device_, entry.second, range);
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (answered) {
+            caps_.ranges[entry.first] = range;
+        } else {
+            failures_[entry.first]++;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    caps_.complete = caps_.ranges.size() == std::size(kRanges);
+    return caps_.complete;
+}
+
+void CapabilityCache::Run() {
+    Fill();
+
+    auto* result = new BuildResult();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        building_ = false;
+        result->caps = caps_;
+        result->deferreds.swap(waiting_);
+    }
+    tsfn_.NonBlockingCall(result, SettleBuild);
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <napi.h>
+#include <dev/dev.hpp>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+// What a device can do: its parameter ranges, tied to the product and
+// firmware they were read from. Only ranges the device answered for are
+// listed; one maps to nullopt when the device reports it has none.
+struct Capabilities {
+    int productType = 0;
+    std::string devVersion;
+    bool complete = false;           // every range has been answered (or seeded)
+    std::map<std::string, std::optional<Device::UvcParamRange>> ranges;
+};
+
+// Parameter ranges never change for a given product and firmware, so each is
+// read from the device once. Build reads every range not known yet on a
+// background thread; Range reads a single one on demand. Seed takes ranges
+// persisted by an earlier run (see CAPABILITY_CACHE), so a known camera needs
+// no range queries at all. A read that errors says nothing about the range
+// and isn't cached; it is tried again up to kMaxFailures times.
+class CapabilityCache {
+public:
+    static constexpr int kMaxFailures = 3;
+
+    CapabilityCache(Napi::Env env, std::shared_ptr<Device> device);
+    ~CapabilityCache();
+
+    // Resolves the descriptor once every range not known yet has been tried;
+    // complete stays false while a read keeps failing
+    Napi::Promise Build(Napi::Env env);
+    // Cached range, read from the device on the caller's thread if not known yet
+    std::optional<Device::UvcParamRange> Range(const std::string& name);
+    // Reads every range not known yet on the caller's thread; true once all are
+    bool Fill();
+    // Takes a descriptor from an earlier run; false if it's for another product or firmware
+    bool Seed(Napi::Object descriptor);
+    Napi::Object Descriptor(Napi::Env env);
+
+    static Napi::Object ToObject(Napi::Env env, const Capabilities& caps);
+
+private:
+    std::shared_ptr<Device> device_;
+    std::thread thread_;
+    std::mutex mutex_;
+    Capabilities caps_;
+    std::map<std::string, int> failures_;    // errored reads of ranges not answered yet
+    std::vector<Napi::Promise::Deferred> waiting_;
+    bool building_ = false;
+    std::atomic<bool> stopping_{false};
+    Napi::ThreadSafeFunction tsfn_;
+
+    void Run();
+};
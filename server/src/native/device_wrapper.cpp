@@ -1,6 +1,52 @@
 #include "device_wrapper.hpp"
 #include <sstream>
 
+namespace {
+
+bool IsTinySeries(ObsbotProductType productType) {
+    return productType == ObsbotProdTiny2 || productType == ObsbotProdTiny2Lite ||
+           productType == ObsbotProdTinySE || productType == ObsbotProdTiny ||
+           productType == ObsbotProdTiny4k;
+}
+
+using Status = Device::CameraStatus;
+using StatusField = int (*)(const Status&);
+
+// Pushed status fields a command can be confirmed by, named as in getCameraStatus
+StatusField FindTinyStatusField(const std::string& name) {
+    static const std::pair<const char*, StatusField> fields[] = {
+        {"aiMode", [](const Status& s) { return int(s.tiny.ai_mode); }},
+        {"aiSubMode", [](const Status& s) { return int(s.tiny.ai_sub_mode); }},
+        {"hdr", [](const Status& s) { return int(s.tiny.hdr); }},
+        {"fov", [](const Status& s) { return int(s.tiny.fov); }},
+        {"zoomRatio", [](const Status& s) { return int(s.tiny.zoom_ratio); }},
+        {"antiFlicker", [](const Status& s) { return int(s.tiny.anti_flicker); }},
+        {"faceAutoFocus", [](const Status& s) { return int(s.tiny.face_auto_focus != 0); }},
+        {"autoFocus", [](const Status& s) { return int(s.tiny.auto_focus != 0); }},
+        {"imageFlipHor", [](const Status& s) { return int(s.tiny.image_flip_hor != 0); }},
+        {"aiTrackerSpeed", [](const Status& s) { return int(s.tiny.ai_tracker_speed); }},
+    };
+    for (const auto& field : fields) {
+        if (name == field.first) return field.second;
+    }
+    return nullptr;
+}
+
+// Whether a pushed status shows a selected target: ai_target on tiny, tiny4k
+// and tinySE, tracking on for the tiny2 series (whose ai_target byte is a
+// length). Other products' status has no such flag.
+StatusField TargetFlag(ObsbotProductType productType) {
+    if (productType == ObsbotProdTiny2 || productType == ObsbotProdTiny2Lite) {
+        return [](const Status& s) { return int(s.tiny.ai_mode != Device::AiWorkModeNone); };
+    }
+    if (IsTinySeries(productType)) {
+        return [](const Status& s) { return int(s.tiny.ai_target != 0); };
+    }
+    return nullptr;
+}
+
+}  // namespace
+
 Napi::FunctionReference DeviceWrapper::constructor;
 
 Napi::Object DeviceWrapper::Init(Napi::Env env, Napi::Object exports) {
@@ -19,6 +65,16 @@ Napi::Object DeviceWrapper::Init(Napi::Env env, Napi::Object exports) {
         InstanceMethod("resetGimbalPosition", &DeviceWrapper::ResetGimbalPosition),
         InstanceMethod("getGimbalState", &DeviceWrapper::GetGimbalState),
 
+        // Planned moves
+        InstanceMethod("moveTo", &DeviceWrapper::MoveTo),
+        InstanceMethod("cancelMove", &DeviceWrapper::CancelMove),
+        InstanceMethod("getMoveState", &DeviceWrapper::GetMoveState),
+
+        // Shaped joystick control
+        InstanceMethod("setJoystick", &DeviceWrapper::SetJoystick),
+        InstanceMethod("configureJoystick", &DeviceWrapper::ConfigureJoystick),
+        InstanceMethod("getJoystickStats", &DeviceWrapper::GetJoystickStats),
+
         // Presets
         InstanceMethod("addPreset", &DeviceWrapper::AddPreset),
         InstanceMethod("deletePreset", &DeviceWrapper::DeletePreset),
@@ -84,6 +140,8 @@ Napi::Object DeviceWrapper::Init(Napi::Env env, Napi::Object exports) {
         InstanceMethod("selectCentralTarget", &DeviceWrapper::SelectCentralTarget),
         InstanceMethod("selectBiggestTarget", &DeviceWrapper::SelectBiggestTarget),
         InstanceMethod("deselectTarget", &DeviceWrapper::DeselectTarget),
+        InstanceMethod("selectTargetByBox", &DeviceWrapper::SelectTargetByBox),
+        InstanceMethod("waitForTarget", &DeviceWrapper::WaitForTarget),
 
         // Device status
         InstanceMethod("setDeviceRunStatus", &DeviceWrapper::SetDeviceRunStatus),
@@ -94,6 +152,21 @@ Napi::Object DeviceWrapper::Init(Napi::Env env, Napi::Object exports) {
 
         // Camera status
         InstanceMethod("getCameraStatus", &DeviceWrapper::GetCameraStatus),
+        InstanceMethod("waitForStatus", &DeviceWrapper::WaitForStatus),
+        InstanceMethod("getStatusWatchStats", &DeviceWrapper::GetStatusWatchStats),
+        InstanceMethod("watchStatus", &DeviceWrapper::WatchStatus),
+        InstanceMethod("getKnownZoom", &DeviceWrapper::GetKnownZoom),
+        InstanceMethod("readState", &DeviceWrapper::ReadState),
+        InstanceMethod("configureWrites", &DeviceWrapper::ConfigureWrites),
+        InstanceMethod("getWriteStats", &DeviceWrapper::GetWriteStats),
+        InstanceMethod("applySettings", &DeviceWrapper::ApplySettings),
+        InstanceMethod("getApplyStats", &DeviceWrapper::GetApplyStats),
+        InstanceMethod("getCapabilities", &DeviceWrapper::GetCapabilities),
+        InstanceMethod("buildCapabilities", &DeviceWrapper::BuildCapabilities),
+        InstanceMethod("seedCapabilities", &DeviceWrapper::SeedCapabilities),
+        InstanceMethod("captureProfile", &DeviceWrapper::CaptureProfile),
+        InstanceMethod("restoreProfile", &DeviceWrapper::RestoreProfile),
+        InstanceMethod("warmUp", &DeviceWrapper::WarmUp),
     });
 
     constructor = Napi::Persistent(func);
@@ -168,6 +241,7 @@ Napi::Value DeviceWrapper::SetGimbalSpeed(const Napi::CallbackInfo& info) {
     double pan = info[1].As<Napi::Number>().DoubleValue();
     double roll = info[2].As<Napi::Number>().DoubleValue();
 
+    TakeOver(env);
     int32_t result = device_->aiSetGimbalSpeedCtrlR(pitch, pan, roll);
     return Napi::Number::New(env, result);
 }
@@ -180,6 +254,7 @@ Napi::Value DeviceWrapper::SetGimbalAngle(const Napi::CallbackInfo& info) {
     float yaw = info[1].As<Napi::Number>().FloatValue();
     float roll = info[2].As<Napi::Number>().FloatValue();
 
+    TakeOver(env);
     int32_t result = device_->aiSetGimbalMotorAngleR(pitch, yaw, roll);
     return Napi::Number::New(env, result);
 }
@@ -187,12 +262,14 @@ Napi::Value DeviceWrapper::SetGimbalAngle(const Napi::CallbackInfo& info) {
 Napi::Value DeviceWrapper::StopGimbal(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
     if (!device_) return Napi::Number::New(env, -1);
+    TakeOver(env);
     return Napi::Number::New(env, device_->aiSetGimbalStop());
 }
 
 Napi::Value DeviceWrapper::ResetGimbalPosition(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
     if (!device_) return Napi::Number::New(env, -1);
+    TakeOver(env);
     return Napi::Number::New(env, device_->gimbalRstPosR());
 }
 
@@ -204,15 +281,213 @@ Napi::Value DeviceWrapper::GetGimbalState(const Napi::CallbackInfo& info) {
     int32_t result = device_->aiGetGimbalStateR(&gimbalInfo);
 
     if (result != 0) return env.Null();
+    return GimbalStateObject(env, gimbalInfo);
+}
 
-    Napi::Object obj = Napi::Object::New(env);
-    obj.Set("pitch", gimbalInfo.pitch_euler);
-    obj.Set("yaw", gimbalInfo.yaw_euler);
-    obj.Set("roll", gimbalInfo.roll_euler);
-    obj.Set("motorPitch", gimbalInfo.pitch_motor);
-    obj.Set("motorYaw", gimbalInfo.yaw_motor);
-    obj.Set("motorRoll", gimbalInfo.roll_motor);
+// moveTo({ pitch?, yaw?, roll?, zoom?, durationMs?, maxSpeed?, maxAccel?, maxJerk?, maxZoomSpeed? })
+//   -> Promise<{ completed, reason?, durationMs, elapsedMs, ticks, lateTicks, maxLateMs }>
+// Angles are motor angles in degrees, as in the preset list; zoom is normalized.
+// Without durationMs the move is as fast as the speed (deg/s), acceleration and
+// jerk limits allow. All axes share the duration, so they start and arrive together.
+Napi::Value DeviceWrapper::MoveTo(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (!device_) {
+        Napi::Error::New(env, "No device").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Target object expected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    Napi::Object opts = info[0].As<Napi::Object>();
+    MoveRequest request;
+    auto read = [&](const char* key, double& out, bool* has = nullptr) {
+        Napi::Value value = opts.Get(key);
+        if (!value.IsNumber()) return;
+        out = value.As<Napi::Number>().DoubleValue();
+        if (has) *has = true;
+    };
+    read("pitch", request.pitch, &request.hasPitch);
+    read("yaw", request.yaw, &request.hasYaw);
+    read("roll", request.roll, &request.hasRoll);
+    read("zoom", request.zoom, &request.hasZoom);
+    read("durationMs", request.durationMs);
+    read("maxSpeed", request.maxSpeed);
+    read("maxAccel", request.maxAccel);
+    read("maxJerk", request.maxJerk);
+    read("maxZoomSpeed", request.maxZoomSpeed);
+
+    if (!request.hasPitch && !request.hasYaw && !request.hasRoll && !request.hasZoom) {
+        Napi::TypeError::New(env, "Target needs pitch, yaw, roll or zoom").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    if (!(request.durationMs >= 0) || !(request.maxSpeed > 0) || !(request.maxAccel > 0) ||
+        !(request.maxJerk > 0) || !(request.maxZoomSpeed > 0)) {
+        Napi::RangeError::New(env, "durationMs must be >= 0 and limits > 0").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    if (shaper_) shaper_->Reset();
+    if (request.hasZoom) Shadow(env).Invalidate(Register::Zoom);
+    if (!mover_) {
+        mover_ = std::make_unique<GimbalMover>(env, device_);
+    }
+    return mover_->Move(env, request);
+}
+
+// cancelMove() -> true if a move was stopped
+Napi::Value DeviceWrapper::CancelMove(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    return Napi::Boolean::New(env, mover_ && mover_->Cancel(env));
+}
+
+// getMoveState() -> { moving, progress, moves, interrupted, lateTicks, tickMs, realtime }
+Napi::Value DeviceWrapper::GetMoveState(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (!mover_) return env.Null();
+    return mover_->State(env);
+}
+
+// setJoystick(pitch, pan) -> undefined
+// Stick deflection, -1..1 per axis. Send it at least every watchdogMs while
+// the stick is off center; a centered stick ramps the gimbal down to a stop.
+Napi::Value DeviceWrapper::SetJoystick(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (!device_) return env.Undefined();
+    if (info.Length() < 2 || !info[0].IsNumber() || !info[1].IsNumber()) {
+        Napi::TypeError::New(env, "Pitch and pan numbers expected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    if (mover_) mover_->Cancel(env, false);
+    if (!shaper_) {
+        shaper_ = std::make_unique<JoystickShaper>(device_);
+        shaper_->Configure(joystickOptions_);
+    }
+    shaper_->Input(info[0].As<Napi::Number>().DoubleValue(), info[1].As<Napi::Number>().DoubleValue());
+    return env.Undefined();
+}
+
+// configureJoystick({ rateHz?, deadzone?, expo?, maxSpeed?, maxAccel?, watchdogMs? }) -> undefined
+Napi::Value DeviceWrapper::ConfigureJoystick(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Options object expected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    Napi::Object opts = info[0].As<Napi::Object>();
+    JoystickOptions options = joystickOptions_;
+    auto read = [&](const char* key, double& out) {
+        if (opts.Get(key).IsNumber()) out = opts.Get(key).As<Napi::Number>().DoubleValue();
+    };
+    double rateHz = options.rateHz;
+    double watchdogMs = options.watchdogMs;
+    read("rateHz", rateHz);
+    read("deadzone", options.deadzone);
+    read("expo", options.expo);
+    read("maxSpeed", options.maxSpeed);
+    read("maxAccel", options.maxAccel);
+    read("watchdogMs", watchdogMs);
+
+    if (!(rateHz >= 1 && rateHz <= 200) || !(options.deadzone >= 0 && options.deadzone < 1) ||
+        !(options.expo >= 0 && options.expo <= 1) || !(options.maxSpeed > 0 && options.maxSpeed <= 180) ||
+        !(options.maxAccel > 0) || !(watchdogMs >= 50)) {
+        Napi::RangeError::New(env, "Invalid joystick options").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    options.rateHz = static_cast<int>(rateHz);
+    options.watchdogMs = static_cast<int>(watchdogMs);
+
+    joystickOptions_ = options;
+    if (shaper_) shaper_->Configure(options);
+    return env.Undefined();
+}
+
+// getJoystickStats() -> { rateHz, intervalMs, inputs, commands, lateTicks, watchdogTrips, output }
+Napi::Value DeviceWrapper::GetJoystickStats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (!shaper_) return env.Null();
+    return shaper_->Stats(env);
+}
+
+void DeviceWrapper::TakeOver(Napi::Env env) {
+    if (mover_) mover_->Cancel(env, false);
+    if (shaper_) shaper_->Reset();
+}
+
+StatusWatcher& DeviceWrapper::Watcher(Napi::Env env) {
+    if (!watcher_) {
+        watcher_ = std::make_unique<StatusWatcher>(env, device_);
+    }
+    return *watcher_;
+}
+
+ShadowRegisters& DeviceWrapper::Shadow(Napi::Env env) {
+    if (shadow_) return *shadow_;
+    shadow_ = std::make_unique<ShadowRegisters>();
+    shadow_->Configure(writeWindowMs_);
+
+    // Status units differ from the setters' (zoom_ratio is 0~100), so a
+    // pushed change only drops the shadow; the next write goes through
+    if (IsTinySeries(device_->productType())) {
+        ShadowRegisters* shadow = shadow_.get();
+        Watcher(env).SetListener([shadow, last = Status{}, seen = false](const Status& s) mutable {
+            auto changed = [&](int before, int now) { return !seen || before != now; };
+            if (changed(last.tiny.zoom_ratio, s.tiny.zoom_ratio) ||
+                s.tiny.ai_mode != Device::AiWorkModeNone) {
+                shadow->Invalidate(Register::Zoom);
+            }
+            if (changed(last.tiny.hdr, s.tiny.hdr)) shadow->Invalidate(Register::Hdr);
+            if (changed(last.tiny.fov, s.tiny.fov)) shadow->Invalidate(Register::Fov);
+            if (changed(last.tiny.anti_flicker, s.tiny.anti_flicker)) {
+                shadow->Invalidate(Register::AntiFlicker);
+            }
+            if (changed(last.tiny.image_flip_hor, s.tiny.image_flip_hor)) {
+                shadow->Invalidate(Register::MirrorFlip);
+            }
+            if (s.tiny.auto_focus) shadow->Invalidate(Register::Focus);
+            last = s;
+            seen = true;
+        });
+    }
+    return *shadow_;
+}
+
+CapabilityCache& DeviceWrapper::Caps(Napi::Env env) {
+    if (!caps_) {
+        caps_ = std::make_unique<CapabilityCache>(env, device_);
+    }
+    return *caps_;
+}
+
+SettingsApplier& DeviceWrapper::Applier(Napi::Env env) {
+    if (!applier_) {
+        applier_ = std::make_unique<SettingsApplier>(env, device_, Shadow(env), Caps(env),
+                                                     IsTinySeries(device_->productType()));
+    }
+    return *applier_;
+}
+
+DeviceWarmUp& DeviceWrapper::Warmer(Napi::Env env) {
+    if (!warmUp_) {
+        warmUp_ = std::make_unique<DeviceWarmUp>(env, device_, Shadow(env), Caps(env),
+                                                 IsTinySeries(device_->productType()));
+    }
+    return *warmUp_;
+}
+
+// A cached range as { min, max, step, default }, or null if the device has none
+Napi::Value DeviceWrapper::RangeValue(Napi::Env env, const char* name) {
+    std::optional<Device::UvcParamRange> range = Caps(env).Range(name);
+    if (!range) return env.Null();
 
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("min", range->min_);
+    obj.Set("max", range->max_);
+    obj.Set("step", range->step_);
+    obj.Set("default", range->default_);
     return obj;
 }
 
@@ -223,6 +498,7 @@ Napi::Value DeviceWrapper::AddPreset(const Napi::CallbackInfo& info) {
 
     Device::PresetPosInfo presetInfo;
     int32_t result = device_->aiAddGimbalPresetR(&presetInfo);
+    if (warmUp_) warmUp_->InvalidatePresets();
 
     if (result == 0) {
         return Napi::Number::New(env, presetInfo.id);
@@ -235,6 +511,7 @@ Napi::Value DeviceWrapper::DeletePreset(const Napi::CallbackInfo& info) {
     if (!device_ || info.Length() < 1) return Napi::Number::New(env, -1);
 
     int32_t id = info[0].As<Napi::Number>().Int32Value();
+    if (warmUp_) warmUp_->InvalidatePresets();
     return Napi::Number::New(env, device_->aiDelGimbalPresetR(id));
 }
 
@@ -243,6 +520,8 @@ Napi::Value DeviceWrapper::TriggerPreset(const Napi::CallbackInfo& info) {
     if (!device_ || info.Length() < 1) return Napi::Number::New(env, -1);
 
     int32_t id = info[0].As<Napi::Number>().Int32Value();
+    TakeOver(env);
+    Shadow(env).Invalidate(Register::Zoom);
     return Napi::Number::New(env, device_->aiTrgGimbalPresetR(id));
 }
 
@@ -250,6 +529,17 @@ Napi::Value DeviceWrapper::GetPresetList(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
     if (!device_) return env.Null();
 
+    // Served from the warm-up until a preset is added or deleted
+    if (warmUp_) {
+        if (auto presets = warmUp_->Presets()) {
+            Napi::Array arr = Napi::Array::New(env, presets->size());
+            for (size_t i = 0; i < presets->size(); i++) {
+                arr[i] = PresetObject(env, (*presets)[i]);
+            }
+            return arr;
+        }
+    }
+
     Device::DevDataArray ids;
     int32_t result = device_->aiGetGimbalPresetListR(&ids);
 
@@ -257,17 +547,14 @@ Napi::Value DeviceWrapper::GetPresetList(const Napi::CallbackInfo& info) {
 
     Napi::Array arr = Napi::Array::New(env, ids.len);
     for (int32_t i = 0; i < ids.len; i++) {
-        Napi::Object preset = Napi::Object::New(env);
-        preset.Set("id", ids.data_int32[i]);
-
         Device::PresetPosInfo presetInfo;
         if (device_->aiGetGimbalPresetInfoWithIdR(&presetInfo, ids.data_int32[i]) == 0) {
-            preset.Set("pitch", presetInfo.pitch);
-            preset.Set("yaw", presetInfo.yaw);
-            preset.Set("roll", presetInfo.roll);
-            preset.Set("zoom", presetInfo.zoom);
-            preset.Set("name", std::string(presetInfo.name));
+            presetInfo.id = ids.data_int32[i];
+            arr[i] = PresetObject(env, presetInfo);
+            continue;
         }
+        Napi::Object preset = Napi::Object::New(env);
+        preset.Set("id", ids.data_int32[i]);
         arr[i] = preset;
     }
 
@@ -298,6 +585,7 @@ Napi::Value DeviceWrapper::SetBootPosition(const Napi::CallbackInfo& info) {
 Napi::Value DeviceWrapper::TriggerBootPosition(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
     if (!device_) return Napi::Number::New(env, -1);
+    Shadow(env).Invalidate(Register::Zoom);
     return Napi::Number::New(env, device_->aiTrgGimbalBootPosR(false));
 }
 
@@ -307,7 +595,8 @@ Napi::Value DeviceWrapper::SetZoom(const Napi::CallbackInfo& info) {
     if (!device_ || info.Length() < 1) return Napi::Number::New(env, -1);
 
     float zoom = info[0].As<Napi::Number>().FloatValue();
-    return Napi::Number::New(env, device_->cameraSetZoomAbsoluteR(zoom));
+    return Napi::Number::New(env, Shadow(env).Write(Register::Zoom, {zoom},
+        [device = device_, zoom] { return device->cameraSetZoomAbsoluteR(zoom); }));
 }
 
 Napi::Value DeviceWrapper::GetZoom(const Napi::CallbackInfo& info) {
@@ -316,6 +605,7 @@ Napi::Value DeviceWrapper::GetZoom(const Napi::CallbackInfo& info) {
 
     float zoom;
     if (device_->cameraGetZoomAbsoluteR(zoom) == 0) {
+        Shadow(env).Observe(Register::Zoom, {zoom});
         return Napi::Number::New(env, zoom);
     }
     return env.Null();
@@ -324,17 +614,7 @@ Napi::Value DeviceWrapper::GetZoom(const Napi::CallbackInfo& info) {
 Napi::Value DeviceWrapper::GetZoomRange(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
     if (!device_) return env.Null();
-
-    Device::UvcParamRange range;
-    if (device_->cameraGetRangeZoomAbsoluteR(range) == 0) {
-        Napi::Object obj = Napi::Object::New(env);
-        obj.Set("min", range.min_);
-        obj.Set("max", range.max_);
-        obj.Set("step", range.step_);
-        obj.Set("default", range.default_);
-        return obj;
-    }
-    return env.Null();
+    return RangeValue(env, "zoom");
 }
 
 // Focus control
@@ -343,7 +623,8 @@ Napi::Value DeviceWrapper::SetFocus(const Napi::CallbackInfo& info) {
     if (!device_ || info.Length() < 1) return Napi::Number::New(env, -1);
 
     int32_t focus = info[0].As<Napi::Number>().Int32Value();
-    return Napi::Number::New(env, device_->cameraSetFocusAbsolute(focus, false));
+    return Napi::Number::New(env, Shadow(env).Write(Register::Focus, {double(focus)},
+        [device = device_, focus] { return device->cameraSetFocusAbsolute(focus, false); }));
 }
 
 Napi::Value DeviceWrapper::GetFocus(const Napi::CallbackInfo& info) {
@@ -353,6 +634,8 @@ Napi::Value DeviceWrapper::GetFocus(const Napi::CallbackInfo& info) {
     int32_t focus;
     bool autoFocus;
     if (device_->cameraGetFocusAbsolute(focus, autoFocus) == 0) {
+        // Autofocus moves it on its own
+        if (!autoFocus) Shadow(env).Observe(Register::Focus, {double(focus)});
         return Napi::Number::New(env, focus);
     }
     return env.Null();
@@ -363,23 +646,14 @@ Napi::Value DeviceWrapper::SetFaceFocus(const Napi::CallbackInfo& info) {
     if (!device_ || info.Length() < 1) return Napi::Number::New(env, -1);
 
     bool enable = info[0].As<Napi::Boolean>().Value();
+    Shadow(env).Invalidate(Register::Focus);
     return Napi::Number::New(env, device_->cameraSetFaceFocusR(enable));
 }
 
 Napi::Value DeviceWrapper::GetFocusRange(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
     if (!device_) return env.Null();
-
-    Device::UvcParamRange range;
-    if (device_->cameraGetRangeFocusAbsolute(range) == 0) {
-        Napi::Object obj = Napi::Object::New(env);
-        obj.Set("min", range.min_);
-        obj.Set("max", range.max_);
-        obj.Set("step", range.step_);
-        obj.Set("default", range.default_);
-        return obj;
-    }
-    return env.Null();
+    return RangeValue(env, "focus");
 }
 
 Napi::Value DeviceWrapper::SetAutoFocusMode(const Napi::CallbackInfo& info) {
@@ -387,6 +661,7 @@ Napi::Value DeviceWrapper::SetAutoFocusMode(const Napi::CallbackInfo& info) {
     if (!device_ || info.Length() < 1) return Napi::Number::New(env, -1);
 
     int32_t mode = info[0].As<Napi::Number>().Int32Value();
+    Shadow(env).Invalidate(Register::Focus);
     return Napi::Number::New(env, device_->cameraSetAutoFocusModeR(
         static_cast<Device::DevAutoFocusType>(mode)));
 }
@@ -408,7 +683,10 @@ Napi::Value DeviceWrapper::SetExposureMode(const Napi::CallbackInfo& info) {
     if (!device_ || info.Length() < 1) return Napi::Number::New(env, -1);
 
     int32_t mode = info[0].As<Napi::Number>().Int32Value();
-    return Napi::Number::New(env, device_->cameraSetExposureModeR(mode));
+    // Auto modes move the exposure value
+    Shadow(env).Invalidate(Register::Exposure);
+    return Napi::Number::New(env, Shadow(env).Write(Register::ExposureMode, {double(mode)},
+        [device = device_, mode] { return device->cameraSetExposureModeR(mode); }));
 }
 
 Napi::Value DeviceWrapper::GetExposureMode(const Napi::CallbackInfo& info) {
@@ -417,6 +695,7 @@ Napi::Value DeviceWrapper::GetExposureMode(const Napi::CallbackInfo& info) {
 
     int32_t mode;
     if (device_->cameraGetExposureModeR(mode) == 0) {
+        Shadow(env).Observe(Register::ExposureMode, {double(mode)});
         return Napi::Number::New(env, mode);
     }
     return env.Null();
@@ -428,7 +707,11 @@ Napi::Value DeviceWrapper::SetExposure(const Napi::CallbackInfo& info) {
 
     int32_t exposure = info[0].As<Napi::Number>().Int32Value();
     // Set exposure with auto_enabled=false for manual control
-    return Napi::Number::New(env, device_->cameraSetExposureAbsolute(exposure, false));
+    Shadow(env).Invalidate(Register::ExposureMode);
+    return Napi::Number::New(env, Shadow(env).Write(Register::Exposure, {double(exposure)},
+        [device = device_, exposure] {
+            return device->cameraSetExposureAbsolute(exposure, false);
+        }));
 }
 
 Napi::Value DeviceWrapper::GetExposure(const Napi::CallbackInfo& info) {
@@ -438,6 +721,7 @@ Napi::Value DeviceWrapper::GetExposure(const Napi::CallbackInfo& info) {
     int32_t exposure;
     bool autoEnabled;
     if (device_->cameraGetExposureAbsolute(exposure, autoEnabled) == 0) {
+        if (!autoEnabled) Shadow(env).Observe(Register::Exposure, {double(exposure)});
         return Napi::Number::New(env, exposure);
     }
     return env.Null();
@@ -448,6 +732,7 @@ Napi::Value DeviceWrapper::SetAELock(const Napi::CallbackInfo& info) {
     if (!device_ || info.Length() < 1) return Napi::Number::New(env, -1);
 
     bool enable = info[0].As<Napi::Boolean>().Value();
+    Shadow(env).Invalidate(Register::Exposure);
     return Napi::Number::New(env, device_->cameraSetAELockR(enable));
 }
 
@@ -458,8 +743,11 @@ Napi::Value DeviceWrapper::SetWhiteBalance(const Napi::CallbackInfo& info) {
 
     int32_t type = info[0].As<Napi::Number>().Int32Value();
     int32_t param = info[1].As<Napi::Number>().Int32Value();
-    return Napi::Number::New(env, device_->cameraSetWhiteBalanceR(
-        static_cast<Device::DevWhiteBalanceType>(type), param));
+    return Napi::Number::New(env, Shadow(env).Write(Register::WhiteBalance,
+        {double(type), double(param)}, [device = device_, type, param] {
+            return device->cameraSetWhiteBalanceR(
+                static_cast<Device::DevWhiteBalanceType>(type), param);
+        }));
 }
 
 Napi::Value DeviceWrapper::GetWhiteBalance(const Napi::CallbackInfo& info) {
@@ -469,6 +757,7 @@ Napi::Value DeviceWrapper::GetWhiteBalance(const Napi::CallbackInfo& info) {
     Device::DevWhiteBalanceType wbType;
     int32_t param;
     if (device_->cameraGetWhiteBalanceR(wbType, param) == 0) {
+        Shadow(env).Observe(Register::WhiteBalance, {double(wbType), double(param)});
         Napi::Object obj = Napi::Object::New(env);
         obj.Set("type", static_cast<int32_t>(wbType));
         obj.Set("value", param);
@@ -480,17 +769,7 @@ Napi::Value DeviceWrapper::GetWhiteBalance(const Napi::CallbackInfo& info) {
 Napi::Value DeviceWrapper::GetWhiteBalanceRange(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
     if (!device_) return env.Null();
-
-    Device::UvcParamRange range;
-    if (device_->cameraGetRangeWhiteBalanceR(range) == 0) {
-        Napi::Object obj = Napi::Object::New(env);
-        obj.Set("min", range.min_);
-        obj.Set("max", range.max_);
-        obj.Set("step", range.step_);
-        obj.Set("default", range.default_);
-        return obj;
-    }
-    return env.Null();
+    return RangeValue(env, "whiteBalance");
 }
 
 // Image settings
@@ -499,7 +778,8 @@ Napi::Value DeviceWrapper::SetBrightness(const Napi::CallbackInfo& info) {
     if (!device_ || info.Length() < 1) return Napi::Number::New(env, -1);
 
     int32_t value = info[0].As<Napi::Number>().Int32Value();
-    return Napi::Number::New(env, device_->cameraSetImageBrightnessR(value));
+    return Napi::Number::New(env, Shadow(env).Write(Register::Brightness, {double(value)},
+        [device = device_, value] { return device->cameraSetImageBrightnessR(value); }));
 }
 
 Napi::Value DeviceWrapper::GetBrightness(const Napi::CallbackInfo& info) {
@@ -508,6 +788,7 @@ Napi::Value DeviceWrapper::GetBrightness(const Napi::CallbackInfo& info) {
 
     int32_t value;
     if (device_->cameraGetImageBrightnessR(value) == 0) {
+        Shadow(env).Observe(Register::Brightness, {double(value)});
         return Napi::Number::New(env, value);
     }
     return env.Null();
@@ -518,7 +799,8 @@ Napi::Value DeviceWrapper::SetContrast(const Napi::CallbackInfo& info) {
     if (!device_ || info.Length() < 1) return Napi::Number::New(env, -1);
 
     int32_t value = info[0].As<Napi::Number>().Int32Value();
-    return Napi::Number::New(env, device_->cameraSetImageContrastR(value));
+    return Napi::Number::New(env, Shadow(env).Write(Register::Contrast, {double(value)},
+        [device = device_, value] { return device->cameraSetImageContrastR(value); }));
 }
 
 Napi::Value DeviceWrapper::GetContrast(const Napi::CallbackInfo& info) {
@@ -527,6 +809,7 @@ Napi::Value DeviceWrapper::GetContrast(const Napi::CallbackInfo& info) {
 
     int32_t value;
     if (device_->cameraGetImageContrastR(value) == 0) {
+        Shadow(env).Observe(Register::Contrast, {double(value)});
         return Napi::Number::New(env, value);
     }
     return env.Null();
@@ -537,7 +820,8 @@ Napi::Value DeviceWrapper::SetSaturation(const Napi::CallbackInfo& info) {
     if (!device_ || info.Length() < 1) return Napi::Number::New(env, -1);
 
     int32_t value = info[0].As<Napi::Number>().Int32Value();
-    return Napi::Number::New(env, device_->cameraSetImageSaturationR(value));
+    return Napi::Number::New(env, Shadow(env).Write(Register::Saturation, {double(value)},
+        [device = device_, value] { return device->cameraSetImageSaturationR(value); }));
 }
 
 Napi::Value DeviceWrapper::GetSaturation(const Napi::CallbackInfo& info) {
@@ -546,6 +830,7 @@ Napi::Value DeviceWrapper::GetSaturation(const Napi::CallbackInfo& info) {
 
     int32_t value;
     if (device_->cameraGetImageSaturationR(value) == 0) {
+        Shadow(env).Observe(Register::Saturation, {double(value)});
         return Napi::Number::New(env, value);
     }
     return env.Null();
@@ -556,7 +841,8 @@ Napi::Value DeviceWrapper::SetSharpness(const Napi::CallbackInfo& info) {
     if (!device_ || info.Length() < 1) return Napi::Number::New(env, -1);
 
     int32_t value = info[0].As<Napi::Number>().Int32Value();
-    return Napi::Number::New(env, device_->cameraSetImageSharpR(value));
+    return Napi::Number::New(env, Shadow(env).Write(Register::Sharpness, {double(value)},
+        [device = device_, value] { return device->cameraSetImageSharpR(value); }));
 }
 
 Napi::Value DeviceWrapper::GetSharpness(const Napi::CallbackInfo& info) {
@@ -565,6 +851,7 @@ Napi::Value DeviceWrapper::GetSharpness(const Napi::CallbackInfo& info) {
 
     int32_t value;
     if (device_->cameraGetImageSharpR(value) == 0) {
+        Shadow(env).Observe(Register::Sharpness, {double(value)});
         return Napi::Number::New(env, value);
     }
     return env.Null();
@@ -575,7 +862,8 @@ Napi::Value DeviceWrapper::SetHue(const Napi::CallbackInfo& info) {
     if (!device_ || info.Length() < 1) return Napi::Number::New(env, -1);
 
     int32_t value = info[0].As<Napi::Number>().Int32Value();
-    return Napi::Number::New(env, device_->cameraSetImageHueR(value));
+    return Napi::Number::New(env, Shadow(env).Write(Register::Hue, {double(value)},
+        [device = device_, value] { return device->cameraSetImageHueR(value); }));
 }
 
 Napi::Value DeviceWrapper::GetHue(const Napi::CallbackInfo& info) {
@@ -584,6 +872,7 @@ Napi::Value DeviceWrapper::GetHue(const Napi::CallbackInfo& info) {
 
     int32_t value;
     if (device_->cameraGetImageHueR(value) == 0) {
+        Shadow(env).Observe(Register::Hue, {double(value)});
         return Napi::Number::New(env, value);
     }
     return env.Null();
@@ -595,7 +884,8 @@ Napi::Value DeviceWrapper::SetHDR(const Napi::CallbackInfo& info) {
     if (!device_ || info.Length() < 1) return Napi::Number::New(env, -1);
 
     int32_t mode = info[0].As<Napi::Number>().Int32Value();
-    return Napi::Number::New(env, device_->cameraSetWdrR(mode));
+    return Napi::Number::New(env, Shadow(env).Write(Register::Hdr, {double(mode)},
+        [device = device_, mode] { return device->cameraSetWdrR(mode); }));
 }
 
 Napi::Value DeviceWrapper::GetHDR(const Napi::CallbackInfo& info) {
@@ -604,6 +894,7 @@ Napi::Value DeviceWrapper::GetHDR(const Napi::CallbackInfo& info) {
 
     int32_t mode;
     if (device_->cameraGetWdrR(mode) == 0) {
+        Shadow(env).Observe(Register::Hdr, {double(mode)});
         return Napi::Number::New(env, mode);
     }
     return env.Null();
@@ -615,8 +906,10 @@ Napi::Value DeviceWrapper::SetFOV(const Napi::CallbackInfo& info) {
     if (!device_ || info.Length() < 1) return Napi::Number::New(env, -1);
 
     int32_t fov = info[0].As<Napi::Number>().Int32Value();
-    return Napi::Number::New(env, device_->cameraSetFovU(
-        static_cast<Device::FovType>(fov)));
+    return Napi::Number::New(env, Shadow(env).Write(Register::Fov, {double(fov)},
+        [device = device_, fov] {
+            return device->cameraSetFovU(static_cast<Device::FovType>(fov));
+        }));
 }
 
 // Mirror/Flip
@@ -625,7 +918,8 @@ Napi::Value DeviceWrapper::SetMirrorFlip(const Napi::CallbackInfo& info) {
     if (!device_ || info.Length() < 1) return Napi::Number::New(env, -1);
 
     int32_t mode = info[0].As<Napi::Number>().Int32Value();
-    return Napi::Number::New(env, device_->cameraSetMirrorFlipR(mode));
+    return Napi::Number::New(env, Shadow(env).Write(Register::MirrorFlip, {double(mode)},
+        [device = device_, mode] { return device->cameraSetMirrorFlipR(mode); }));
 }
 
 Napi::Value DeviceWrapper::GetMirrorFlip(const Napi::CallbackInfo& info) {
@@ -634,6 +928,7 @@ Napi::Value DeviceWrapper::GetMirrorFlip(const Napi::CallbackInfo& info) {
 
     int32_t mode;
     if (device_->cameraGetMirrorFlipR(mode) == 0) {
+        Shadow(env).Observe(Register::MirrorFlip, {double(mode)});
         return Napi::Number::New(env, mode);
     }
     return env.Null();
@@ -645,6 +940,7 @@ Napi::Value DeviceWrapper::SetAIEnabled(const Napi::CallbackInfo& info) {
     if (!device_ || info.Length() < 1) return Napi::Number::New(env, -1);
 
     bool enabled = info[0].As<Napi::Boolean>().Value();
+    Shadow(env).Invalidate(Register::Zoom);
     return Napi::Number::New(env, device_->aiSetEnabledR(enabled));
 }
 
@@ -654,6 +950,7 @@ Napi::Value DeviceWrapper::SetAIMode(const Napi::CallbackInfo& info) {
 
     int32_t mode = info[0].As<Napi::Number>().Int32Value();
     int32_t subMode = info[1].As<Napi::Number>().Int32Value();
+    Shadow(env).Invalidate(Register::Zoom);
     return Napi::Number::New(env, device_->cameraSetAiModeU(
         static_cast<Device::AiWorkModeType>(mode), subMode));
 }
@@ -672,6 +969,7 @@ Napi::Value DeviceWrapper::SetAutoZoom(const Napi::CallbackInfo& info) {
     if (!device_ || info.Length() < 1) return Napi::Number::New(env, -1);
 
     bool enabled = info[0].As<Napi::Boolean>().Value();
+    Shadow(env).Invalidate(Register::Zoom);
     return Napi::Number::New(env, device_->aiSetAiAutoZoomR(enabled));
 }
 
@@ -702,6 +1000,105 @@ Napi::Value DeviceWrapper::DeselectTarget(const Napi::CallbackInfo& info) {
     return Napi::Number::New(env, device_->aiDelSelectedTargetR());
 }
 
+// selectTargetByBox(xMin, yMin, xMax, yMax) -> { result, method, selected }
+// Box in normalized preview coordinates, 0..1 from the top-left. Tries the
+// box selection call, then the unified target selection of newer firmware,
+// then an ROI view on the box; method names the call that took it. The ROI
+// view only frames the box and tracks nothing, so selected is false for it.
+Napi::Value DeviceWrapper::SelectTargetByBox(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (!device_) return env.Null();
+    if (info.Length() < 4 || !info[0].IsNumber() || !info[1].IsNumber() ||
+        !info[2].IsNumber() || !info[3].IsNumber()) {
+        Napi::TypeError::New(env, "xMin, yMin, xMax, yMax numbers expected")
+            .ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    float box[4];
+    for (int i = 0; i < 4; i++) {
+        box[i] = info[i].As<Napi::Number>().FloatValue();
+    }
+    if (!(box[0] >= 0 && box[1] >= 0 && box[2] <= 1 && box[3] <= 1 &&
+          box[0] < box[2] && box[1] < box[3])) {
+        Napi::RangeError::New(env, "Box must lie within 0..1 with min < max")
+            .ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    // The AI takes the gimbal (and the zoom) from here
+    TakeOver(env);
+    Shadow(env).Invalidate(Register::Zoom);
+
+    // What waitForTarget compares against: a target must appear, not just be there
+    selectedBefore_.reset();
+    if (TargetFlag(device_->productType())) {
+        Watcher(env);
+        selectedBefore_ = TargetFlag(device_->productType())(device_->cameraStatus()) != 0;
+    }
+
+    const char* method = "box";
+    int32_t result = device_->aiSetSelectTargetByBox(box[0], box[1], box[2], box[3]);
+    if (result != 0) {
+        Device::DevTargetSelection selection{};
+        selection.selection_type = Device::DevTargetSelectionTypeBox;
+        selection.class_type = Device::DevTargetClassTypeCommon;
+        selection.zoom_type = Device::DevTargetZoomTypeIgnored;
+        selection.view_type = Device::DevTargetViewTypeTargetAuto;
+        selection.location.roi.x_min = box[0];
+        selection.location.roi.y_min = box[1];
+        selection.location.roi.x_max = box[2];
+        selection.location.roi.y_max = box[3];
+        method = "selection";
+        result = device_->aiSetSelectedTargetR(selection);
+    }
+    if (result != 0) {
+        method = "roi";
+        result = device_->cameraSetRoiTarget(0, Device::ROIViewTargetAuto,
+                                             box[0], box[1], box[2], box[3]);
+    }
+
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("result", result);
+    obj.Set("method", method);
+    obj.Set("selected", result == 0 && std::string(method) != "roi");
+    return obj;
+}
+
+// waitForTarget(timeoutMs = 2000) -> Promise<{ confirmed, elapsedMs, updates }>
+// Confirms the last selectTargetByBox from the pushed status (see TargetFlag):
+// the flag has to go from clear, before the selection, to set. confirmed is
+// null when that can't be seen: the product's status has no target flag, or
+// a target was already tracked before the selection.
+Napi::Value DeviceWrapper::WaitForTarget(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (!device_) {
+        Napi::Error::New(env, "No device").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    int timeoutMs = 2000;
+    if (info.Length() > 0 && info[0].IsNumber()) {
+        timeoutMs = info[0].As<Napi::Number>().Int32Value();
+    }
+
+    const StatusField flag = TargetFlag(device_->productType());
+    const bool observable = flag && selectedBefore_ == false;
+    selectedBefore_.reset();
+    if (!observable) {
+        Napi::Object unknown = Napi::Object::New(env);
+        unknown.Set("confirmed", env.Null());
+        unknown.Set("elapsedMs", 0);
+        unknown.Set("updates", 0);
+        Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+        deferred.Resolve(unknown);
+        return deferred.Promise();
+    }
+
+    return Watcher(env).WaitFor(env, [flag](const Device::CameraStatus& status) {
+        return flag(status) != 0;
+    }, timeoutMs);
+}
+
 // Device status
 Napi::Value DeviceWrapper::SetDeviceRunStatus(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
@@ -726,7 +1123,8 @@ Napi::Value DeviceWrapper::SetAntiFlicker(const Napi::CallbackInfo& info) {
     if (!device_ || info.Length() < 1) return Napi::Number::New(env, -1);
 
     int32_t mode = info[0].As<Napi::Number>().Int32Value();
-    return Napi::Number::New(env, device_->cameraSetAntiFlickR(mode));
+    return Napi::Number::New(env, Shadow(env).Write(Register::AntiFlicker, {double(mode)},
+        [device = device_, mode] { return device->cameraSetAntiFlickR(mode); }));
 }
 
 // Camera status
@@ -734,53 +1132,300 @@ Napi::Value DeviceWrapper::GetCameraStatus(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
     if (!device_) return env.Null();
 
-    Napi::Object obj = Napi::Object::New(env);
-
     auto productType = device_->productType();
-    obj.Set("productType", static_cast<int>(productType));
 
     // For tiny2 series devices, query fresh camera status
-    if (productType == ObsbotProdTiny2 || productType == ObsbotProdTiny2Lite ||
-        productType == ObsbotProdTinySE || productType == ObsbotProdTiny ||
-        productType == ObsbotProdTiny4k) {
-
-        Device::CameraStatus status;
-        // Try to get fresh status from device
-        int32_t result = device_->cameraGetCameraStatusU(status);
-        if (result == 0) {
-            obj.Set("aiMode", static_cast<int>(status.tiny.ai_mode));
-            obj.Set("aiSubMode", static_cast<int>(status.tiny.ai_sub_mode));
-            obj.Set("hdr", static_cast<int>(status.tiny.hdr));
-            obj.Set("fov", static_cast<int>(status.tiny.fov));
-            obj.Set("zoomRatio", static_cast<int>(status.tiny.zoom_ratio));
-            obj.Set("antiFlicker", static_cast<int>(status.tiny.anti_flicker));
-            obj.Set("faceAutoFocus", status.tiny.face_auto_focus != 0);
-            obj.Set("autoFocus", status.tiny.auto_focus != 0);
-            obj.Set("imageFlipHor", status.tiny.image_flip_hor != 0);
-            obj.Set("aiTrackerSpeed", static_cast<int>(status.tiny.ai_tracker_speed));
-        } else {
-            // Fall back to cached status if query fails
-            auto cachedStatus = device_->cameraStatus();
-            obj.Set("aiMode", static_cast<int>(cachedStatus.tiny.ai_mode));
-            obj.Set("aiSubMode", static_cast<int>(cachedStatus.tiny.ai_sub_mode));
-            obj.Set("hdr", static_cast<int>(cachedStatus.tiny.hdr));
-            obj.Set("fov", static_cast<int>(cachedStatus.tiny.fov));
-            obj.Set("zoomRatio", static_cast<int>(cachedStatus.tiny.zoom_ratio));
-            obj.Set("antiFlicker", static_cast<int>(cachedStatus.tiny.anti_flicker));
-            obj.Set("faceAutoFocus", cachedStatus.tiny.face_auto_focus != 0);
-            obj.Set("autoFocus", cachedStatus.tiny.auto_focus != 0);
-            obj.Set("imageFlipHor", cachedStatus.tiny.image_flip_hor != 0);
-            obj.Set("aiTrackerSpeed", static_cast<int>(cachedStatus.tiny.ai_tracker_speed));
-        }
+    Device::CameraStatus status;
+    bool tiny = IsTinySeries(productType);
+    if (tiny && device_->cameraGetCameraStatusU(status) != 0) {
+        // Fall back to cached status if query fails
+        status = device_->cameraStatus();
     }
 
     // Get AI status for gesture settings
     Device::AiStatus aiStatus;
-    if (device_->aiGetAiStatusR(&aiStatus) == 0) {
-        obj.Set("gestureTarget", aiStatus.gesture_target);
-        obj.Set("gestureZoom", aiStatus.gesture_zoom);
-        obj.Set("gestureDynamicZoom", aiStatus.gesture_dynamic_zoom);
+    bool ai = device_->aiGetAiStatusR(&aiStatus) == 0;
+
+    return CameraStatusObject(env, productType, tiny ? &status : nullptr,
+                              ai ? &aiStatus : nullptr);
+}
+
+// waitForStatus(field, value, timeoutMs = 2000) -> Promise<{ confirmed, elapsedMs, updates }>
+// Waits for a pushed status whose field (as named by getCameraStatus, booleans
+// as 0/1) equals value. Returns null when this product's status has no such field.
+Napi::Value DeviceWrapper::WaitForStatus(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (!device_) {
+        Napi::Error::New(env, "No device").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    if (info.Length() < 2 || !info[0].IsString() ||
+        !(info[1].IsNumber() || info[1].IsBoolean())) {
+        Napi::TypeError::New(env, "Field name and number or boolean value expected")
+            .ThrowAsJavaScriptException();
+        return env.Null();
     }
 
-    return obj;
+    const StatusField field = IsTinySeries(device_->productType())
+        ? FindTinyStatusField(info[0].As<Napi::String>().Utf8Value())
+        : nullptr;
+    if (!field) return env.Null();
+
+    const int value = info[1].IsBoolean() ? int(info[1].As<Napi::Boolean>().Value())
+                                          : info[1].As<Napi::Number>().Int32Value();
+    int timeoutMs = 2000;
+    if (info.Length() > 2 && info[2].IsNumber()) {
+        timeoutMs = info[2].As<Napi::Number>().Int32Value();
+    }
+
+    return Watcher(env).WaitFor(env, [field, value](const Device::CameraStatus& status) {
+        return field(status) == value;
+    }, timeoutMs);
+}
+
+// getStatusWatchStats() -> { pending, updates, confirmed, timedOut, lastConfirmMs }
+Napi::Value DeviceWrapper::GetStatusWatchStats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (!watcher_) return env.Null();
+    return watcher_->Stats(env);
+}
+
+// watchStatus(callback) -> bool
+// Calls callback with every status the camera pushes, shaped as getCameraStatus.
+// Returns false when this product pushes no camera status (not tiny series).
+Napi::Value DeviceWrapper::WatchStatus(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (!device_) return Napi::Boolean::New(env, false);
+    if (info.Length() < 1 || !info[0].IsFunction()) {
+        Napi::TypeError::New(env, "Callback expected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    const ObsbotProductType productType = device_->productType();
+    if (!IsTinySeries(productType)) return Napi::Boolean::New(env, false);
+
+    Watcher(env).Forward(env, info[0].As<Napi::Function>(),
+        [productType](Napi::Env env, const Device::CameraStatus& status) -> Napi::Value {
+            return CameraStatusObject(env, productType, &status, nullptr);
+        });
+    return Napi::Boolean::New(env, true);
+}
+
+// getKnownZoom() -> number | null, the zoom shadow register; never asks the device
+Napi::Value DeviceWrapper::GetKnownZoom(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (!device_) return env.Null();
+    const std::optional<RegisterValue> zoom = Shadow(env).Known(Register::Zoom);
+    if (!zoom) return env.Null();
+    return Napi::Number::New(env, zoom->a);
+}
+
+// readState() -> Promise<{ status, zoom, gimbal }>
+// getCameraStatus, getZoom and getGimbalState in one job on the settings thread
+Napi::Value DeviceWrapper::ReadState(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (!device_) {
+        Napi::Error::New(env, "No device").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    return Applier(env).ReadState(env);
+}
+
+// configureWrites({ windowMs }) -> undefined
+Napi::Value DeviceWrapper::ConfigureWrites(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Options object expected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    Napi::Value windowMs = info[0].As<Napi::Object>().Get("windowMs");
+    if (windowMs.IsNumber()) {
+        double ms = windowMs.As<Napi::Number>().DoubleValue();
+        if (!(ms >= 0 && ms <= 1000)) {
+            Napi::RangeError::New(env, "windowMs must be within 0..1000")
+                .ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        writeWindowMs_ = static_cast<int>(ms);
+    }
+    if (shadow_) shadow_->Configure(writeWindowMs_);
+    return env.Undefined();
+}
+
+// getWriteStats() -> { windowMs, hits, misses, coalesced, failures, hitRate, known, pending }
+Napi::Value DeviceWrapper::GetWriteStats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (!shadow_) return env.Null();
+    return shadow_->Stats(env);
+}
+
+// applySettings({ brightness?, contrast?, saturation?, sharpness?, hue?, hdr?, fov?,
+//                 mirrorFlip?, antiFlicker?, exposure?: { mode?, value?, aeLock? },
+//                 wb?: { type?, value? }, focus?: { mode?, value? } })
+//   -> Promise<{ ok, elapsedMs, results: { [field]: { result, elided?, error? } } }>
+Napi::Value DeviceWrapper::ApplySettings(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (!device_) {
+        Napi::Error::New(env, "No device").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Settings object expected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    Napi::Object settings = info[0].As<Napi::Object>();
+    SettingsRequest request;
+    std::string bad;
+    auto read = [&](Napi::Object obj, const std::string& prefix, const char* key,
+                    std::optional<int32_t>& out) {
+        Napi::Value value = obj.Get(key);
+        if (value.IsUndefined() || value.IsNull()) return;
+        if (!value.IsNumber()) {
+            bad = prefix + key;
+            return;
+        }
+        out = value.As<Napi::Number>().Int32Value();
+    };
+    auto group = [&](const char* key) -> std::optional<Napi::Object> {
+        Napi::Value value = settings.Get(key);
+        if (value.IsUndefined() || value.IsNull()) return std::nullopt;
+        if (!value.IsObject()) {
+            bad = key;
+            return std::nullopt;
+        }
+        return value.As<Napi::Object>();
+    };
+
+    read(settings, "", "brightness", request.brightness);
+    read(settings, "", "contrast", request.contrast);
+    read(settings, "", "saturation", request.saturation);
+    read(settings, "", "sharpness", request.sharpness);
+    read(settings, "", "hue", request.hue);
+    read(settings, "", "hdr", request.hdr);
+    read(settings, "", "fov", request.fov);
+    read(settings, "", "mirrorFlip", request.mirrorFlip);
+    read(settings, "", "antiFlicker", request.antiFlicker);
+    if (auto exposure = group("exposure")) {
+        read(*exposure, "exposure.", "mode", request.exposureMode);
+        read(*exposure, "exposure.", "value", request.exposure);
+        Napi::Value aeLock = exposure->Get("aeLock");
+        if (aeLock.IsBoolean()) {
+            request.aeLock = aeLock.As<Napi::Boolean>().Value();
+        } else if (!aeLock.IsUndefined() && !aeLock.IsNull()) {
+            bad = "exposure.aeLock";
+        }
+    }
+    if (auto wb = group("wb")) {
+        read(*wb, "wb.", "type", request.wbType);
+        read(*wb, "wb.", "value", request.wbValue);
+    }
+    if (auto focus = group("focus")) {
+        read(*focus, "focus.", "mode", request.focusMode);
+        read(*focus, "focus.", "value", request.focus);
+    }
+    if (!bad.empty()) {
+        Napi::TypeError::New(env, "Invalid setting: " + bad).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    return Applier(env).Apply(env, request);
+}
+
+// getApplyStats() -> { queued, batches, writes, elided, rejected, lastBatchMs }
+Napi::Value DeviceWrapper::GetApplyStats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (!applier_) return env.Null();
+    return applier_->Stats(env);
+}
+
+// getCapabilities() -> { productType, devVersion, complete, ranges: { [name]: range | null } }
+// Only what is cached; never queries the device
+Napi::Value DeviceWrapper::GetCapabilities(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (!device_) return env.Null();
+    return Caps(env).Descriptor(env);
+}
+
+// buildCapabilities() -> Promise<descriptor>, reading the missing ranges on a worker thread
+Napi::Value DeviceWrapper::BuildCapabilities(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (!device_) {
+        Napi::Error::New(env, "No device").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    return Caps(env).Build(env);
+}
+
+// seedCapabilities(descriptor) -> true if it was for this product and firmware
+Napi::Value DeviceWrapper::SeedCapabilities(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (!device_ || info.Length() < 1 || !info[0].IsObject()) {
+        return Napi::Boolean::New(env, false);
+    }
+    return Napi::Boolean::New(env, Caps(env).Seed(info[0].As<Napi::Object>()));
+}
+
+// captureProfile() -> Promise<Buffer>, the live configuration as a profile blob
+Napi::Value DeviceWrapper::CaptureProfile(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (!device_) {
+        Napi::Error::New(env, "No device").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    return Applier(env).Capture(env);
+}
+
+// restoreProfile(blob) -> Promise<{ ok, elapsedMs, unchanged, results }>
+// Writes only the fields that differ from the live configuration
+Napi::Value DeviceWrapper::RestoreProfile(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (!device_) {
+        Napi::Error::New(env, "No device").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    if (info.Length() < 1 || !info[0].IsBuffer()) {
+        Napi::TypeError::New(env, "Profile buffer expected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    Napi::Buffer<uint8_t> blob = info[0].As<Napi::Buffer<uint8_t>>();
+    Profile profile;
+    std::string error;
+    if (!DecodeProfile(blob.Data(), blob.Length(), profile, error)) {
+        Napi::Error::New(env, error).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    // Another product's presets are skipped, so the cached list stays good
+    const bool sameProduct = profile.productType == static_cast<int>(device_->productType());
+    if (warmUp_ && profile.presets && sameProduct) warmUp_->InvalidatePresets();
+    return Applier(env).Restore(env, profile);
+}
+
+// warmUp({ timeoutMs = 2000 }?)
+//   -> Promise<{ ready, durationMs, status, zoom, gimbal, presets, bootPosition,
+//                capabilities, failed, timedOut }>
+// Reads what the first dashboard load needs and fills the caches; status and
+// gimbal are shaped as getCameraStatus and getGimbalState return them
+Napi::Value DeviceWrapper::WarmUp(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (!device_) {
+        Napi::Error::New(env, "No device").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    int timeoutMs = 2000;
+    if (info.Length() > 0 && info[0].IsObject()) {
+        Napi::Value timeout = info[0].As<Napi::Object>().Get("timeoutMs");
+        if (timeout.IsNumber()) {
+            double ms = timeout.As<Napi::Number>().DoubleValue();
+            if (!(ms >= 0 && ms <= 60000)) {
+                Napi::RangeError::New(env, "timeoutMs must be within 0..60000")
+                    .ThrowAsJavaScriptException();
+                return env.Null();
+            }
+            timeoutMs = static_cast<int>(ms);
+        }
+    }
+    return Warmer(env).Start(env, timeoutMs);
 }
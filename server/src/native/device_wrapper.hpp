@@ -3,7 +3,15 @@
 #include <napi.h>
 #include <dev/devs.hpp>
 #include <dev/dev.hpp>
+#include "gimbal_mover.hpp"
+#include "joystick_shaper.hpp"
+#include "capability_cache.hpp"
+#include "settings_applier.hpp"
+#include "shadow_registers.hpp"
+#include "status_watcher.hpp"
+#include "warm_up.hpp"
 #include <memory>
+#include <optional>
 #include <string>
 #include <functional>
 
@@ -19,6 +27,25 @@ public:
 private:
     static Napi::FunctionReference constructor;
     std::shared_ptr<Device> device_;
+    std::unique_ptr<GimbalMover> mover_;   // started by the first moveTo
+    std::unique_ptr<JoystickShaper> shaper_;
+    JoystickOptions joystickOptions_;
+    std::unique_ptr<ShadowRegisters> shadow_;  // started by the first setting read or write
+    int writeWindowMs_ = 50;
+    std::unique_ptr<StatusWatcher> watcher_;   // started by the first wait; feeds shadow_
+    std::unique_ptr<CapabilityCache> caps_;    // ranges, read once per device
+    std::unique_ptr<SettingsApplier> applier_; // started by the first batch or profile job
+    std::unique_ptr<DeviceWarmUp> warmUp_;     // started by the first warmUp; caches presets
+    std::optional<bool> selectedBefore_;       // target flag before the last box selection
+
+    // Another control path takes the gimbal from a move or the joystick
+    void TakeOver(Napi::Env env);
+    StatusWatcher& Watcher(Napi::Env env);
+    ShadowRegisters& Shadow(Napi::Env env);
+    CapabilityCache& Caps(Napi::Env env);
+    SettingsApplier& Applier(Napi::Env env);
+    DeviceWarmUp& Warmer(Napi::Env env);
+    Napi::Value RangeValue(Napi::Env env, const char* name);
 
     // Device info
     Napi::Value GetDeviceName(const Napi::CallbackInfo& info);
@@ -34,6 +61,16 @@ private:
     Napi::Value ResetGimbalPosition(const Napi::CallbackInfo& info);
     Napi::Value GetGimbalState(const Napi::CallbackInfo& info);
 
+    // Planned moves
+    Napi::Value MoveTo(const Napi::CallbackInfo& info);
+    Napi::Value CancelMove(const Napi::CallbackInfo& info);
+    Napi::Value GetMoveState(const Napi::CallbackInfo& info);
+
+    // Shaped joystick control
+    Napi::Value SetJoystick(const Napi::CallbackInfo& info);
+    Napi::Value ConfigureJoystick(const Napi::CallbackInfo& info);
+    Napi::Value GetJoystickStats(const Napi::CallbackInfo& info);
+
     // Preset positions
     Napi::Value AddPreset(const Napi::CallbackInfo& info);
     Napi::Value DeletePreset(const Napi::CallbackInfo& info);
@@ -99,6 +136,8 @@ private:
     Napi::Value SelectCentralTarget(const Napi::CallbackInfo& info);
     Napi::Value SelectBiggestTarget(const Napi::CallbackInfo& info);
     Napi::Value DeselectTarget(const Napi::CallbackInfo& info);
+    Napi::Value SelectTargetByBox(const Napi::CallbackInfo& info);
+    Napi::Value WaitForTarget(const Napi::CallbackInfo& info);
 
     // Device status
     Napi::Value SetDeviceRunStatus(const Napi::CallbackInfo& info);
@@ -109,4 +148,29 @@ private:
 
     // Camera status
     Napi::Value GetCameraStatus(const Napi::CallbackInfo& info);
+    Napi::Value WaitForStatus(const Napi::CallbackInfo& info);
+    Napi::Value GetStatusWatchStats(const Napi::CallbackInfo& info);
+    Napi::Value WatchStatus(const Napi::CallbackInfo& info);
+    Napi::Value GetKnownZoom(const Napi::CallbackInfo& info);
+    Napi::Value ReadState(const Napi::CallbackInfo& info);
+
+    // Write elision
+    Napi::Value ConfigureWrites(const Napi::CallbackInfo& info);
+    Napi::Value GetWriteStats(const Napi::CallbackInfo& info);
+
+    // Batched settings
+    Napi::Value ApplySettings(const Napi::CallbackInfo& info);
+    Napi::Value GetApplyStats(const Napi::CallbackInfo& info);
+
+    // Capabilities
+    Napi::Value GetCapabilities(const Napi::CallbackInfo& info);
+    Napi::Value BuildCapabilities(const Napi::CallbackInfo& info);
+    Napi::Value SeedCapabilities(const Napi::CallbackInfo& info);
+
+    // Profiles
+    Napi::Value CaptureProfile(const Napi::CallbackInfo& info);
+    Napi::Value RestoreProfile(const Napi::CallbackInfo& info);
+
+    // Warm-up
+    Napi::Value WarmUp(const Napi::CallbackInfo& info);
 };
@@ -0,0 +1,378 @@
+#include "gimbal_mover.hpp"
+#include "worker_support.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+
+// Reference speed range of gimbalSetSpeedPositionR, deg/s
+constexpr double kMaxSpeed = 90.0;
+constexpr double kMinSpeed = 1.0;
+// Zoom acceleration and jerk limits, as multiples of its speed limit
+constexpr double kZoomAccelFactor = 4.0;
+constexpr double kZoomJerkFactor = 20.0;
+// cameraSetZoomWithSpeedAbsoluteR: 255 is the fastest zoom speed
+constexpr uint32_t kZoomSpeedMax = 255;
+
+using Clock = std::chrono::steady_clock;
+
+double MsSince(Clock::time_point start, Clock::time_point now) {
+    return std::chrono::duration<double, std::milli>(now - start).count();
+}
+
+// Resolve or reject a finished move on the JS thread
+void SettleMove(Napi::Env env, Napi::Function, MoveJob* job) {
+    if (job->error.empty()) {
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("completed", job->completed);
+        if (!job->reason.empty()) result.Set("reason", job->reason);
+        result.Set("durationMs", job->durationMs);
+        result.Set("elapsedMs", job->elapsedMs);
+        result.Set("ticks", job->ticks);
+        result.Set("lateTicks", job->lateTicks);
+        result.Set("maxLateMs", job->maxLateMs);
+        job->deferred.Resolve(result);
+    } else {
+        job->deferred.Reject(Napi::Error::New(env, job->error).Value());
+    }
+    delete job;
+}
+
+}  // namespace
+
+// ==================== SCurve ====================
+
+SCurve::SCurve(double from, double to, double durationS)
+    : from_(from), distance_(to - from), duration_(durationS) {
+    if (duration_ <= 0) return;
+    ta_ = kAccelFraction * duration_;
+    tj_ = kJerkFraction * ta_;
+    peak_ = std::fabs(distance_) / (duration_ - ta_);
+    accel_ = peak_ / (ta_ - tj_);
+    jerk_ = accel_ / tj_;
+}
+
+double SCurve::MinDuration(double distance, double maxVelocity, double maxAccel, double maxJerk) {
+    const double d = std::fabs(distance);
+    if (d <= 0) return 0;
+    const double a = kAccelFraction;
+    const double b = kJerkFraction;
+    // Peak velocity, acceleration and jerk of the fixed shape scale as d/T, d/T^2, d/T^3
+    double t = d / ((1 - a) * maxVelocity);
+    t = std::max(t, std::sqrt(d / ((1 - a) * a * (1 - b) * maxAccel)));
+    t = std::max(t, std::cbrt(d / ((1 - a) * a * a * (1 - b) * b * maxJerk)));
+    return t;
+}
+
+void SCurve::Accelerate(double t, double& p, double& v) const {
+    // Jerk up, constant acceleration, jerk down
+    const double t1 = tj_;
+    const double t2 = ta_ - tj_;
+    const double v1 = jerk_ * t1 * t1 / 2;
+    const double p1 = jerk_ * t1 * t1 * t1 / 6;
+    if (t <= t1) {
+        v = jerk_ * t * t / 2;
+        p = jerk_ * t * t * t / 6;
+        return;
+    }
+    if (t <= t2) {
+        const double u = t - t1;
+        v = v1 + accel_ * u;
+        p = p1 + v1 * u + accel_ * u * u / 2;
+        return;
+    }
+    const double u2 = t2 - t1;
+    const double v2 = v1 + accel_ * u2;
+    const double p2 = p1 + v1 * u2 + accel_ * u2 * u2 / 2;
+    const double u = std::min(t, ta_) - t2;
+    v = v2 + accel_ * u - jerk_ * u * u / 2;
+    p = p2 + v2 * u + accel_ * u * u / 2 - jerk_ * u * u * u / 6;
+}
+
+double SCurve::Position(double t) const {
+    if (duration_ <= 0 || t >= duration_) return from_ + distance_;
+    if (t <= 0) return from_;
+
+    double p, v;
+    const double sign = distance_ < 0 ? -1 : 1;
+    if (t < ta_) {
+        Accelerate(t, p, v);
+    } else if (t <= duration_ - ta_) {
+        Accelerate(ta_, p, v);
+        p += peak_ * (t - ta_);
+    } else {
+        // Deceleration mirrors acceleration
+        Accelerate(duration_ - t, p, v);
+        p = std::fabs(distance_) - p;
+    }
+    return from_ + sign * p;
+}
+
+double SCurve::Velocity(double t) const {
+    if (duration_ <= 0 || t <= 0 || t >= duration_) return 0;
+
+    double p, v;
+    const double sign = distance_ < 0 ? -1 : 1;
+    if (t < ta_) {
+        Accelerate(t, p, v);
+    } else if (t <= duration_ - ta_) {
+        v = peak_;
+    } else {
+        Accelerate(duration_ - t, p, v);
+    }
+    return sign * v;
+}
+
+// ==================== GimbalMover ====================
+
+GimbalMover::GimbalMover(Napi::Env env, std::shared_ptr<Device> device)
+    : device_(std::move(device)) {
+    tsfn_ = MakeResultTsfn(env, "GimbalMoverResult");
+
+    thread_ = std::thread(&GimbalMover::Run, this);
+}
+
+GimbalMover::~GimbalMover() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+
+    if (pending_) {
+        pending_->reason = "closed";
+        tsfn_.NonBlockingCall(pending_.release(), SettleMove);
+    }
+    tsfn_.Release();
+}
+
+Napi::Promise GimbalMover::Move(Napi::Env env, const MoveRequest& request) {
+    auto job = std::make_unique<MoveJob>(env);
+    job->request = request;
+    Napi::Promise promise = job->deferred.Promise();
+
+    std::unique_ptr<MoveJob> replaced;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        replaced = std::move(pending_);
+        pending_ = std::move(job);
+    }
+    cv_.notify_all();
+
+    // Never started; a move in flight notices pending_ and stops itself
+    if (replaced) {
+        replaced->reason = "superseded";
+        SettleMove(env, Napi::Function(), replaced.release());
+    }
+    return promise;
+}
+
+bool GimbalMover::Cancel(Napi::Env env, bool stop) {
+    std::unique_ptr<MoveJob> dropped;
+    bool active;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        active = moving_;
+        if (active) {
+            cancel_ = true;
+            stopOnCancel_ = stop;
+        }
+        dropped = std::move(pending_);
+    }
+    cv_.notify_all();
+
+    if (!dropped) return active;
+    dropped->reason = "cancelled";
+    SettleMove(env, Napi::Function(), dropped.release());
+    return true;
+}
+
+Napi::Object GimbalMover::State(Napi::Env env) {
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("moving", moving_.load());
+    obj.Set("progress", progress_.load());
+    obj.Set("moves", moves_.load());
+    obj.Set("interrupted", interrupted_.load());
+    obj.Set("lateTicks", lateTicks_.load());
+    obj.Set("tickMs", kTickMs);
+    obj.Set("realtime", realtime_.load());
+    return obj;
+}
+
+void GimbalMover::Run() {
+#ifdef __linux__
+    // Ticks should not queue behind the event loop or encoders; needs CAP_SYS_NICE,
+    // otherwise the thread runs at normal priority
+    sched_param param{};
+    param.sched_priority = 10;
+    realtime_ = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+#endif
+
+    while (true) {
+        std::unique_ptr<MoveJob> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return stopping_ || pending_ != nullptr; });
+            if (stopping_) return;
+            job = std::move(pending_);
+            cancel_ = false;
+            moving_ = true;
+        }
+
+        Execute(*job);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            moving_ = false;
+        }
+        moves_++;
+        tsfn_.NonBlockingCall(job.release(), SettleMove);
+    }
+}
+
+bool GimbalMover::Interrupted(MoveJob& job) {
+    bool stop = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) {
+            job.reason = "closed";
+            stop = true;
+        } else if (cancel_) {
+            job.reason = "cancelled";
+            stop = stopOnCancel_;
+            cancel_ = false;
+        } else if (pending_) {
+            // The next move starts from wherever this one got to
+            job.reason = "superseded";
+        } else {
+            return false;
+        }
+    }
+
+    if (stop) device_->aiSetGimbalStop();
+    interrupted_++;
+    return true;
+}
+
+void GimbalMover::Execute(MoveJob& job) {
+    const MoveRequest& req = job.request;
+    const Clock::time_point start = Clock::now();
+    progress_ = 0;
+
+    // Motor angles, the same frame the presets are stored in
+    Device::AiGimbalStateInfo state;
+    if (device_->aiGetGimbalStateR(&state) != 0) {
+        job.error = "Failed to read the gimbal position";
+        return;
+    }
+    float zoom = 0;
+    if (req.hasZoom && device_->cameraGetZoomAbsoluteR(zoom) != 0) {
+        job.error = "Failed to read the zoom";
+        return;
+    }
+
+    // Axes: pitch, yaw, roll, zoom
+    const double from[4] = {state.pitch_motor, state.yaw_motor, state.roll_motor, zoom};
+    const double to[4] = {
+        req.hasPitch ? req.pitch : from[0],
+        req.hasYaw ? req.yaw : from[1],
+        req.hasRoll ? req.roll : from[2],
+        req.hasZoom ? req.zoom : from[3],
+    };
+
+    // A requested duration only gives way to the gimbal's speed limit; otherwise
+    // the slowest axis under the requested limits sets the pace for all of them
+    const double inf = std::numeric_limits<double>::infinity();
+    double durationS = req.durationMs / 1000.0;
+    for (int i = 0; i < 4; i++) {
+        const double distance = to[i] - from[i];
+        double minS;
+        if (i == 3) {
+            const double v = req.maxZoomSpeed;
+            minS = req.durationMs > 0
+                ? 0.0
+                : SCurve::MinDuration(distance, v, v * kZoomAccelFactor, v * kZoomJerkFactor);
+        } else if (req.durationMs > 0) {
+            minS = SCurve::MinDuration(distance, kMaxSpeed, inf, inf);
+        } else {
+            const double v = std::min(req.maxSpeed, kMaxSpeed);
+            minS = SCurve::MinDuration(distance, v, req.maxAccel, req.maxJerk);
+        }
+        durationS = std::max(durationS, minS);
+    }
+    job.durationMs = durationS * 1000.0;
+
+    SCurve curves[4];
+    for (int i = 0; i < 4; i++) {
+        curves[i] = SCurve(from[i], to[i], durationS);
+    }
+
+    const auto tick = std::chrono::milliseconds(kTickMs);
+    const double tickS = kTickMs / 1000.0;
+    double sent[4] = {from[0], from[1], from[2], from[3]};
+    uint32_t sentZoom = 0;
+    Clock::time_point tickStart = start;
+
+    while (true) {
+        if (Interrupted(job)) {
+            job.elapsedMs = MsSince(start, Clock::now());
+            return;
+        }
+
+        // Where each axis should be by the next tick, and the speed that gets it there
+        const double t = std::chrono::duration<double>(tickStart - start).count() + tickS;
+        double target[4];
+        double speed[3];
+        for (int i = 0; i < 4; i++) {
+            target[i] = curves[i].Position(t);
+        }
+        for (int i = 0; i < 3; i++) {
+            speed[i] = std::clamp(std::fabs(target[i] - sent[i]) / tickS, kMinSpeed, kMaxSpeed);
+        }
+
+        device_->gimbalSetSpeedPositionR(
+            static_cast<float>(target[2]), static_cast<float>(target[0]), static_cast<float>(target[1]),
+            static_cast<float>(speed[2]), static_cast<float>(speed[0]), static_cast<float>(speed[1]));
+        if (req.hasZoom) {
+            // Ratio in hundredths; the profile, not the zoom motor, sets the pace
+            const uint32_t ratio = static_cast<uint32_t>(std::lround(target[3] * 100));
+            if (ratio != sentZoom) {
+                device_->cameraSetZoomWithSpeedAbsoluteR(ratio, kZoomSpeedMax);
+                sentZoom = ratio;
+            }
+        }
+        std::copy(target, target + 4, sent);
+        job.ticks++;
+        progress_ = durationS > 0 ? std::min(1.0, t / durationS) : 1.0;
+
+        if (t >= durationS) break;
+
+        tickStart += tick;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait_until(lock, tickStart, [this] {
+                return stopping_ || cancel_ || pending_ != nullptr;
+            });
+        }
+
+        // A late tick is caught up by the next setpoint, which is time-based
+        const double lateMs = MsSince(tickStart, Clock::now());
+        if (lateMs > kTickMs / 2.0) {
+            job.lateTicks++;
+            lateTicks_++;
+            job.maxLateMs = std::max(job.maxLateMs, lateMs);
+        }
+    }
+
+    job.completed = true;
+    job.elapsedMs = MsSince(start, Clock::now());
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <napi.h>
+#include <dev/dev.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Jerk-limited ("double S") position profile from one value to another over a
+// fixed duration. The shape is fixed: acceleration takes kAccelFraction of the
+// move at each end, and the jerk ramps take kJerkFraction of each acceleration
+// phase. Axes of any length can therefore share one duration and arrive together.
+class SCurve {
+public:
+    static constexpr double kAccelFraction = 0.3;
+    static constexpr double kJerkFraction = 0.5;
+
+    SCurve() = default;
+    SCurve(double from, double to, double durationS);
+
+    // Shortest duration that keeps velocity, acceleration and jerk within limits
+    static double MinDuration(double distance, double maxVelocity, double maxAccel, double maxJerk);
+
+    double Position(double t) const;
+    double Velocity(double t) const;
+    double PeakVelocity() const { return peak_; }
+
+private:
+    double from_ = 0;
+    double distance_ = 0;            // signed
+    double duration_ = 0;
+    double ta_ = 0;                  // acceleration phase
+    double tj_ = 0;                  // jerk ramp
+    double accel_ = 0;               // magnitudes from here on
+    double jerk_ = 0;
+    double peak_ = 0;
+
+    // Distance and speed covered t seconds into the acceleration phase
+    void Accelerate(double t, double& p, double& v) const;
+};
+
+// A move in motor angles (degrees) and normalized zoom. Unset axes hold still.
+struct MoveRequest {
+    bool hasPitch = false, hasYaw = false, hasRoll = false, hasZoom = false;
+    double pitch = 0, yaw = 0, roll = 0, zoom = 0;
+    double durationMs = 0;           // 0: as fast as the limits allow
+    double maxSpeed = 60;            // deg/s
+    double maxAccel = 120;           // deg/s^2
+    double maxJerk = 600;            // deg/s^3
+    double maxZoomSpeed = 0.5;       // normalized zoom per second
+};
+
+struct MoveJob {
+    MoveRequest request;
+    Napi::Promise::Deferred deferred;
+
+    // Results, filled in by the mover thread
+    std::string error;
+    bool completed = false;
+    std::string reason;              // why it stopped early
+    double durationMs = 0;
+    double elapsedMs = 0;
+    int ticks = 0;
+    int lateTicks = 0;
+    double maxLateMs = 0;
+
+    explicit MoveJob(Napi::Env env) : deferred(Napi::Promise::Deferred::New(env)) {}
+};
+
+// Executes planned moves on a dedicated thread at a fixed tick. Each tick the
+// gimbal is sent the profile's position one tick ahead with the speed that
+// reaches it (gimbalSetSpeedPositionR), and the zoom its next ratio at full
+// zoom speed (cameraSetZoomWithSpeedAbsoluteR), so the firmware follows the
+// S-curve instead of its own fixed-speed ramp. A new move replaces the one
+// in flight, which resolves with completed = false.
+class GimbalMover {
+public:
+    static constexpr int kTickMs = 20;
+
+    GimbalMover(Napi::Env env, std::shared_ptr<Device> device);
+    ~GimbalMover();
+
+    Napi::Promise Move(Napi::Env env, const MoveRequest& request);
+    // Stop the move in flight (and drop a queued one). stop = false leaves the
+    // gimbal to whatever command replaces the move.
+    bool Cancel(Napi::Env env, bool stop = true);
+    Napi::Object State(Napi::Env env);
+
+private:
+    std::shared_ptr<Device> device_;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::unique_ptr<MoveJob> pending_;
+    bool cancel_ = false;
+    bool stopOnCancel_ = true;
+    bool stopping_ = false;
+    Napi::ThreadSafeFunction tsfn_;
+
+    // Stats, written by the mover thread
+    std::atomic<bool> moving_{false};
+    std::atomic<bool> realtime_{false};
+    std::atomic<double> progress_{0};
+    std::atomic<int> moves_{0};
+    std::atomic<int> interrupted_{0};
+    std::atomic<int> lateTicks_{0};
+
+    void Run();
+    void Execute(MoveJob& job);
+    bool Interrupted(MoveJob& job);
+};
@@ -0,0 +1,930 @@
+#include "gst_pipeline.hpp"
+#include <gst/app/gstappsink.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+
+Napi::FunctionReference CapturePipeline::constructor;
+
+// Samples from one appsink, delivered to its JS callback
+struct AppSinkCounters {
+    GstElement* element;                // owned reference
+    std::string name;
+    Napi::ThreadSafeFunction tsfn;
+    std::atomic<uint64_t> samples{0};
+    std::atomic<uint64_t> dropped{0};   // JS was still busy with earlier samples
+};
+
+namespace {
+
+// Samples waiting for JS; beyond this the newest is dropped instead of queued
+constexpr size_t kMaxPendingSamples = 2;
+// Longest a tee pad can stay busy with one buffer before removal forces the unlink
+constexpr auto kUnlinkTimeout = std::chrono::milliseconds(1000);
+
+struct PipelineMessage {
+    std::string type;
+    std::string source;
+    std::string message;
+    std::string detail;
+};
+
+struct SampleData {
+    std::vector<uint8_t> data;
+    double ptsMs = -1;
+    double timestamp = 0;               // epoch ms on arrival
+};
+
+int64_t NowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool EnsureGstInit(std::string& error) {
+    static bool initialized = false;
+    if (initialized) return true;
+
+    GError* err = nullptr;
+    if (!gst_init_check(nullptr, nullptr, &err)) {
+        error = err ? err->message : "gst_init failed";
+        g_clear_error(&err);
+        return false;
+    }
+    initialized = true;
+    return true;
+}
+
+const char* FactoryName(GstElement* element) {
+    GstElementFactory* factory = gst_element_get_factory(element);
+    return factory ? gst_plugin_feature_get_name(GST_PLUGIN_FEATURE(factory)) : "";
+}
+
+// All elements in the bin and its children, each with a reference the caller owns
+std::vector<GstElement*> ListElements(GstBin* bin) {
+    std::vector<GstElement*> elements;
+    GstIterator* it = gst_bin_iterate_recurse(bin);
+    GValue item = G_VALUE_INIT;
+    bool done = false;
+
+    while (!done) {
+        switch (gst_iterator_next(it, &item)) {
+        case GST_ITERATOR_OK:
+            elements.push_back(GST_ELEMENT(g_value_dup_object(&item)));
+            g_value_reset(&item);
+            break;
+        case GST_ITERATOR_RESYNC:
+            // The bin changed while iterating; start over
+            for (GstElement* e : elements) gst_object_unref(e);
+            elements.clear();
+            gst_iterator_resync(it);
+            break;
+        default:
+            done = true;
+            break;
+        }
+    }
+
+    g_value_unset(&item);
+    gst_iterator_free(it);
+    return elements;
+}
+
+// gst_parse_bin_from_description takes a single string; quote values with spaces
+std::string JoinArgs(const std::vector<std::string>& args) {
+    std::string out;
+    for (const std::string& arg : args) {
+        if (!out.empty()) out += ' ';
+        if (arg.find_first_of(" \t\"") == std::string::npos) {
+            out += arg;
+            continue;
+        }
+        size_t eq = arg.find('=');
+        size_t start = eq == std::string::npos ? 0 : eq + 1;
+        out += arg.substr(0, start) + '"';
+        for (size_t i = start; i < arg.size(); i++) {
+            if (arg[i] == '"' || arg[i] == '\\') out += '\\';
+            out += arg[i];
+        }
+        out += '"';
+    }
+    return out;
+}
+
+struct UnlinkProbe {
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool done = false;
+};
+
+// Runs once the tee pad is between buffers, so the branch is cut cleanly
+GstPadProbeReturn OnTeePadIdle(GstPad* pad, GstPadProbeInfo*, gpointer data) {
+    std::shared_ptr<UnlinkProbe> probe = *static_cast<std::shared_ptr<UnlinkProbe>*>(data);
+    GstPad* peer = gst_pad_get_peer(pad);
+    if (peer) {
+        gst_pad_unlink(pad, peer);
+        gst_object_unref(peer);
+    }
+    {
+        std::lock_guard<std::mutex> lock(probe->mutex);
+        probe->done = true;
+    }
+    probe->cv.notify_all();
+    return GST_PAD_PROBE_REMOVE;
+}
+
+// Element by name with its property spec, or an error message
+GstElement* FindProperty(GstElement* pipeline, const std::string& elementName,
+                         const std::string& property, GParamSpec** pspec, std::string& error) {
+    GstElement* element = gst_bin_get_by_name(GST_BIN(pipeline), elementName.c_str());
+    if (!element) {
+        error = "No element named " + elementName;
+        return nullptr;
+    }
+    *pspec = g_object_class_find_property(G_OBJECT_GET_CLASS(element), property.c_str());
+    if (!*pspec) {
+        error = elementName + " has no property " + property;
+        gst_object_unref(element);
+        return nullptr;
+    }
+    return element;
+}
+
+void OnQueueOverrun(GstElement*, gpointer data) {
+    static_cast<QueueCounters*>(data)->overruns++;
+}
+
+// Streaming thread: copy the sample out and hand it to JS without blocking
+GstFlowReturn OnNewSample(GstAppSink* sink, gpointer data) {
+    AppSinkCounters* counters = static_cast<AppSinkCounters*>(data);
+    GstSample* sample = gst_app_sink_pull_sample(sink);
+    if (!sample) return GST_FLOW_OK;
+
+    auto frame = std::make_unique<SampleData>();
+    GstBuffer* buffer = gst_sample_get_buffer(sample);
+    if (buffer) {
+        GstMapInfo map;
+        if (gst_buffer_map(buffer, &map, GST_MAP_READ)) {
+            frame->data.assign(map.data, map.data + map.size);
+            gst_buffer_unmap(buffer, &map);
+        }
+        if (GST_BUFFER_PTS_IS_VALID(buffer)) {
+            frame->ptsMs = static_cast<double>(GST_BUFFER_PTS(buffer)) / GST_MSECOND;
+        }
+    }
+    gst_sample_unref(sample);
+
+    frame->timestamp = static_cast<double>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+    counters->samples++;
+
+    auto deliver = [](Napi::Env env, Napi::Function callback, SampleData* data) {
+        std::unique_ptr<SampleData> frame(data);
+        if (!env) return;
+        callback.Call({
+            Napi::Buffer<uint8_t>::Copy(env, frame->data.data(), frame->data.size()),
+            Napi::Number::New(env, frame->timestamp),
+            Napi::Number::New(env, frame->ptsMs),
+        });
+    };
+    if (counters->tsfn.NonBlockingCall(frame.get(), deliver) == napi_ok) {
+        frame.release();
+    } else {
+        counters->dropped++;
+    }
+    return GST_FLOW_OK;
+}
+
+void DeliverMessage(Napi::Env env, Napi::Function callback, PipelineMessage* data) {
+    std::unique_ptr<PipelineMessage> msg(data);
+    if (!env) return;
+
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("type", msg->type);
+    obj.Set("source", msg->source);
+    obj.Set("message", msg->message);
+    if (!msg->detail.empty()) obj.Set("detail", msg->detail);
+    callback.Call({obj});
+}
+
+}  // namespace
+
+Napi::Object CapturePipeline::Init(Napi::Env env, Napi::Object exports) {
+    Napi::Function func = DefineClass(env, "CapturePipeline", {
+        InstanceMethod("start", &CapturePipeline::Start),
+        InstanceMethod("sendEos", &CapturePipeline::SendEos),
+        InstanceMethod("getState", &CapturePipeline::GetState),
+        InstanceMethod("getStats", &CapturePipeline::GetStats),
+        InstanceMethod("connectAppSink", &CapturePipeline::ConnectAppSink),
+        InstanceMethod("addBranch", &CapturePipeline::AddBranch),
+        InstanceMethod("removeBranch", &CapturePipeline::RemoveBranch),
+        InstanceMethod("setProperty", &CapturePipeline::SetProperty),
+        InstanceMethod("getProperty", &CapturePipeline::GetProperty),
+        InstanceMethod("getRtcpStats", &CapturePipeline::GetRtcpStats),
+        InstanceMethod("close", &CapturePipeline::Close),
+    });
+
+    constructor = Napi::Persistent(func);
+    constructor.SuppressDestruct();
+
+    exports.Set("CapturePipeline", func);
+    return exports;
+}
+
+// new CapturePipeline(args: string[], onMessage?: ({ type, source, message, detail }) => void)
+// args are the gst-launch-1.0 pipeline arguments (without options such as -e)
+CapturePipeline::CapturePipeline(const Napi::CallbackInfo& info)
+    : Napi::ObjectWrap<CapturePipeline>(info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsArray()) {
+        Napi::TypeError::New(env, "Pipeline argument array expected").ThrowAsJavaScriptException();
+        return;
+    }
+
+    std::string error;
+    if (!EnsureGstInit(error)) {
+        Napi::Error::New(env, "GStreamer init failed: " + error).ThrowAsJavaScriptException();
+        return;
+    }
+
+    Napi::Array arr = info[0].As<Napi::Array>();
+    std::vector<std::string> args;
+    for (uint32_t i = 0; i < arr.Length(); i++) {
+        args.push_back(arr.Get(i).ToString().Utf8Value());
+    }
+    std::vector<const gchar*> argv;
+    for (const std::string& arg : args) argv.push_back(arg.c_str());
+    argv.push_back(nullptr);
+
+    // Same parser gst-launch-1.0 uses, so the argument lists stay interchangeable
+    GError* err = nullptr;
+    GstElement* element = gst_parse_launchv(argv.data(), &err);
+    if (err) {
+        std::string message = err->message;
+        g_clear_error(&err);
+        if (element) gst_object_unref(element);
+        Napi::Error::New(env, "Invalid pipeline: " + message).ThrowAsJavaScriptException();
+        return;
+    }
+    if (!element) {
+        Napi::Error::New(env, "Invalid pipeline").ThrowAsJavaScriptException();
+        return;
+    }
+
+    if (GST_IS_PIPELINE(element)) {
+        pipeline_ = element;
+    } else {
+        // A single element; give it a pipeline so it has a bus and clock
+        pipeline_ = gst_pipeline_new(nullptr);
+        gst_bin_add(GST_BIN(pipeline_), element);
+    }
+    bus_ = gst_element_get_bus(pipeline_);
+
+    if (info.Length() > 1 && info[1].IsFunction()) {
+        messageTsfn_ = Napi::ThreadSafeFunction::New(
+            env,
+            info[1].As<Napi::Function>(),
+            "CapturePipelineMessage",
+            0,
+            1
+        );
+        messageTsfn_.Unref(env);
+        hasMessageTsfn_ = true;
+    }
+
+    CollectQueues(GST_BIN(pipeline_), 0);
+    busThread_ = std::thread(&CapturePipeline::RunBus, this);
+}
+
+CapturePipeline::~CapturePipeline() {
+    Shutdown();
+}
+
+void CapturePipeline::CollectQueues(GstBin* bin, int branch) {
+    for (GstElement* element : ListElements(bin)) {
+        if (std::string(FactoryName(element)) != "queue") {
+            gst_object_unref(element);
+            continue;
+        }
+        auto counters = std::make_unique<QueueCounters>();
+        counters->element = element;
+        counters->branch = branch;
+        g_signal_connect(element, "overrun", G_CALLBACK(OnQueueOverrun), counters.get());
+        queues_.push_back(std::move(counters));
+    }
+}
+
+// Drop the counters of one branch, or of everything when branch < 0
+void CapturePipeline::ReleaseQueues(int branch) {
+    auto it = queues_.begin();
+    while (it != queues_.end()) {
+        if (branch >= 0 && (*it)->branch != branch) {
+            ++it;
+            continue;
+        }
+        g_signal_handlers_disconnect_by_data((*it)->element, it->get());
+        gst_object_unref((*it)->element);
+        it = queues_.erase(it);
+    }
+}
+
+void CapturePipeline::RunBus() {
+    const GstMessageType types = static_cast<GstMessageType>(
+        GST_MESSAGE_ERROR | GST_MESSAGE_WARNING | GST_MESSAGE_EOS |
+        GST_MESSAGE_STATE_CHANGED | GST_MESSAGE_QOS | GST_MESSAGE_ELEMENT);
+
+    while (!stopping_) {
+        GstMessage* msg = gst_bus_timed_pop_filtered(bus_, 100 * GST_MSECOND, types);
+        if (!msg) continue;
+
+        auto event = std::make_unique<PipelineMessage>();
+        event->source = GST_MESSAGE_SRC_NAME(msg);
+        bool forward = true;
+
+        switch (GST_MESSAGE_TYPE(msg)) {
+        case GST_MESSAGE_ERROR:
+        case GST_MESSAGE_WARNING: {
+            bool isError = GST_MESSAGE_TYPE(msg) == GST_MESSAGE_ERROR;
+            GError* err = nullptr;
+            gchar* debug = nullptr;
+            if (isError) {
+                gst_message_parse_error(msg, &err, &debug);
+            } else {
+                gst_message_parse_warning(msg, &err, &debug);
+            }
+            event->type = isError ? "error" : "warning";
+            event->message = err ? err->message : "";
+            event->detail = debug ? debug : "";
+            g_clear_error(&err);
+            g_free(debug);
+
+            std::lock_guard<std::mutex> lock(statsMutex_);
+            (isError ? errors_ : warnings_)++;
+            break;
+        }
+        case GST_MESSAGE_EOS:
+            event->type = "eos";
+            break;
+        case GST_MESSAGE_STATE_CHANGED: {
+            // Only the pipeline's own transitions; elements report their own too
+            if (GST_MESSAGE_SRC(msg) != GST_OBJECT(pipeline_)) {
+                forward = false;
+                break;
+            }
+            GstState oldState, newState, pending;
+            gst_message_parse_state_changed(msg, &oldState, &newState, &pending);
+            event->type = "state";
+            event->message = gst_element_state_get_name(newState);
+            event->detail = gst_element_state_get_name(oldState);
+            break;
+        }
+        case GST_MESSAGE_QOS: {
+            // Counted, not forwarded: sinks post one per late buffer. Messages
+            // still queued from a removed branch's elements are dropped
+            if (!gst_object_has_as_ancestor(GST_MESSAGE_SRC(msg), GST_OBJECT(pipeline_))) {
+                forward = false;
+                break;
+            }
+            GstFormat format;
+            guint64 processed = 0, dropped = 0;
+            gst_message_parse_qos_stats(msg, &format, &processed, &dropped);
+            std::lock_guard<std::mutex> lock(statsMutex_);
+            uint64_t& total = qosDropped_[event->source];
+            total = std::max<uint64_t>(total, dropped);
+            forward = false;
+            break;
+        }
+        case GST_MESSAGE_ELEMENT: {
+            // e.g. splitmuxsink-fragment-closed with the finished file's location
+            const GstStructure* s = gst_message_get_structure(msg);
+            if (!s) {
+                forward = false;
+                break;
+            }
+            event->type = "element";
+            event->message = gst_structure_get_name(s);
+            gchar* text = gst_structure_to_string(s);
+            event->detail = text;
+            g_free(text);
+            break;
+        }
+        default:
+            forward = false;
+            break;
+        }
+        gst_message_unref(msg);
+
+        if (forward && hasMessageTsfn_ &&
+            messageTsfn_.NonBlockingCall(event.get(), DeliverMessage) == napi_ok) {
+            event.release();
+        }
+    }
+}
+
+void CapturePipeline::Shutdown() {
+    if (closed_ || !pipeline_) return;
+    closed_ = true;
+
+    // Joins the streaming threads, so no appsink or overrun callback runs after this
+    gst_element_set_state(pipeline_, GST_STATE_NULL);
+
+    stopping_ = true;
+    if (busThread_.joinable()) {
+        busThread_.join();
+    }
+
+    // Branch bins go down with the pipeline; only our references remain
+    for (auto& [id, branch] : branches_) {
+        gst_element_release_request_pad(branch.tee, branch.teePad);
+        gst_object_unref(branch.teePad);
+        gst_object_unref(branch.sinkPad);
+        gst_object_unref(branch.tee);
+        gst_object_unref(branch.bin);
+    }
+    branches_.clear();
+    ReleaseQueues(-1);
+
+    for (auto& sink : appSinks_) {
+        sink->tsfn.Release();
+        gst_object_unref(sink->element);
+    }
+    appSinks_.clear();
+
+    if (hasMessageTsfn_) {
+        messageTsfn_.Release();
+        hasMessageTsfn_ = false;
+    }
+
+    gst_object_unref(bus_);
+    gst_object_unref(pipeline_);
+    bus_ = nullptr;
+    pipeline_ = nullptr;
+}
+
+// start() -> false if the pipeline could not go to PLAYING (e.g. device busy)
+Napi::Value CapturePipeline::Start(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (closed_) {
+        Napi::Error::New(env, "Pipeline closed").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    startedAt_ = NowMs();
+    GstStateChangeReturn ret = gst_element_set_state(pipeline_, GST_STATE_PLAYING);
+    return Napi::Boolean::New(env, ret != GST_STATE_CHANGE_FAILURE);
+}
+
+// sendEos() - finalize files; an 'eos' message follows once every sink has drained
+Napi::Value CapturePipeline::SendEos(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (closed_) return Napi::Boolean::New(env, false);
+    return Napi::Boolean::New(env, gst_element_send_event(pipeline_, gst_event_new_eos()));
+}
+
+Napi::Value CapturePipeline::GetState(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (closed_) return Napi::String::New(env, "closed");
+
+    GstState state, pending;
+    gst_element_get_state(pipeline_, &state, &pending, 0);
+    return Napi::String::New(env, gst_element_state_get_name(state));
+}
+
+// getStats() -> { state, uptimeMs, errors, warnings, queues, qosDropped, appSinks }
+Napi::Value CapturePipeline::GetStats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("state", GetState(info));
+    if (closed_) return obj;
+
+    obj.Set("uptimeMs", static_cast<double>(startedAt_ ? NowMs() - startedAt_ : 0));
+
+    Napi::Array queues = Napi::Array::New(env, queues_.size());
+    for (size_t i = 0; i < queues_.size(); i++) {
+        QueueCounters& q = *queues_[i];
+        guint buffers = 0, bytes = 0, maxBuffers = 0, maxBytes = 0;
+        guint64 time = 0, maxTime = 0;
+        gint leaky = 0;
+        g_object_get(q.element,
+            "current-level-buffers", &buffers,
+            "current-level-bytes", &bytes,
+            "current-level-time", &time,
+            "max-size-buffers", &maxBuffers,
+            "max-size-bytes", &maxBytes,
+            "max-size-time", &maxTime,
+            "leaky", &leaky,
+            nullptr);
+
+        // A queue is full when any of its limits is reached
+        double fill = 0;
+        if (maxBuffers) fill = std::max(fill, static_cast<double>(buffers) / maxBuffers);
+        if (maxBytes) fill = std::max(fill, static_cast<double>(bytes) / maxBytes);
+        if (maxTime) fill = std::max(fill, static_cast<double>(time) / maxTime);
+
+        gchar* name = gst_element_get_name(q.element);
+        Napi::Object entry = Napi::Object::New(env);
+        entry.Set("name", name);
+        entry.Set("buffers", buffers);
+        entry.Set("bytes", bytes);
+        entry.Set("timeMs", static_cast<double>(time) / GST_MSECOND);
+        entry.Set("fill", std::min(fill, 1.0));
+        entry.Set("leaky", leaky != 0);
+        entry.Set("overruns", static_cast<double>(q.overruns));
+        queues[i] = entry;
+        g_free(name);
+    }
+    obj.Set("queues", queues);
+
+    Napi::Object qos = Napi::Object::New(env);
+    {
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        for (const auto& [source, dropped] : qosDropped_) {
+            qos.Set(source, static_cast<double>(dropped));
+        }
+        obj.Set("errors", static_cast<double>(errors_));
+        obj.Set("warnings", static_cast<double>(warnings_));
+    }
+    obj.Set("qosDropped", qos);
+
+    Napi::Array sinks = Napi::Array::New(env, appSinks_.size());
+    for (size_t i = 0; i < appSinks_.size(); i++) {
+        Napi::Object entry = Napi::Object::New(env);
+        entry.Set("name", appSinks_[i]->name);
+        entry.Set("samples", static_cast<double>(appSinks_[i]->samples));
+        entry.Set("dropped", static_cast<double>(appSinks_[i]->dropped));
+        sinks[i] = entry;
+    }
+    obj.Set("appSinks", sinks);
+    return obj;
+}
+
+// connectAppSink(name, (data: Buffer, timestamp, ptsMs) => void) -> false if no such appsink
+// Samples are copied out on the streaming thread; if JS falls behind, new
+// samples are dropped rather than stalling the pipeline.
+Napi::Value CapturePipeline::ConnectAppSink(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 2 || !info[0].IsString() || !info[1].IsFunction()) {
+        Napi::TypeError::New(env, "Element name and callback expected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    if (closed_) return Napi::Boolean::New(env, false);
+
+    std::string name = info[0].As<Napi::String>().Utf8Value();
+    GstElement* element = gst_bin_get_by_name(GST_BIN(pipeline_), name.c_str());
+    if (!element) return Napi::Boolean::New(env, false);
+    if (std::string(FactoryName(element)) != "appsink") {
+        gst_object_unref(element);
+        return Napi::Boolean::New(env, false);
+    }
+
+    auto counters = std::make_unique<AppSinkCounters>();
+    counters->element = element;
+    counters->name = name;
+    counters->tsfn = Napi::ThreadSafeFunction::New(
+        env,
+        info[1].As<Napi::Function>(),
+        "CapturePipelineSample",
+        kMaxPendingSamples,
+        1
+    );
+    counters->tsfn.Unref(env);
+
+    g_object_set(element, "emit-signals", FALSE, "sync", FALSE, "max-buffers", 1u, "drop", TRUE, nullptr);
+    GstAppSinkCallbacks callbacks = {};
+    callbacks.new_sample = OnNewSample;
+    gst_app_sink_set_callbacks(GST_APP_SINK(element), &callbacks, counters.get(), nullptr);
+
+    appSinks_.push_back(std::move(counters));
+    return Napi::Boolean::New(env, true);
+}
+
+// addBranch(teeName, args: string[]) -> branch id
+// args describe a chain in gst-launch syntax whose first element has a free
+// sink pad, e.g. ['queue', '!', 'x264enc', '!', 'fakesink']. It is brought
+// up to the pipeline's state before being linked, so the tee never pushes
+// into an element that is not ready.
+Napi::Value CapturePipeline::AddBranch(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 2 || !info[0].IsString() || !info[1].IsArray()) {
+        Napi::TypeError::New(env, "Tee name and argument array expected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    if (closed_) {
+        Napi::Error::New(env, "Pipeline closed").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    std::string teeName = info[0].As<Napi::String>().Utf8Value();
+    GstElement* tee = gst_bin_get_by_name(GST_BIN(pipeline_), teeName.c_str());
+    if (!tee || std::string(FactoryName(tee)) != "tee") {
+        if (tee) gst_object_unref(tee);
+        Napi::Error::New(env, "No tee named " + teeName).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    Napi::Array arr = info[1].As<Napi::Array>();
+    std::vector<std::string> args;
+    for (uint32_t i = 0; i < arr.Length(); i++) {
+        args.push_back(arr.Get(i).ToString().Utf8Value());
+    }
+
+    GError* err = nullptr;
+    GstElement* bin = gst_parse_bin_from_description(JoinArgs(args).c_str(), TRUE, &err);
+    if (!bin || err) {
+        std::string message = err ? err->message : "parse failed";
+        g_clear_error(&err);
+        if (bin) gst_object_unref(gst_object_ref_sink(bin));
+        gst_object_unref(tee);
+        Napi::Error::New(env, "Invalid branch: " + message).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    gst_object_ref_sink(bin);
+
+    GstPad* sinkPad = gst_element_get_static_pad(bin, "sink");
+    if (!sinkPad) {
+        gst_object_unref(bin);
+        gst_object_unref(tee);
+        Napi::Error::New(env, "Branch has no free sink pad").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    gst_bin_add(GST_BIN(pipeline_), bin);
+    gst_element_sync_state_with_parent(bin);
+
+#if GST_CHECK_VERSION(1, 20, 0)
+    GstPad* teePad = gst_element_request_pad_simple(tee, "src_%u");
+#else
+    GstPad* teePad = gst_element_get_request_pad(tee, "src_%u");
+#endif
+    if (!teePad || gst_pad_link(teePad, sinkPad) != GST_PAD_LINK_OK) {
+        gst_element_set_state(bin, GST_STATE_NULL);
+        gst_bin_remove(GST_BIN(pipeline_), bin);
+        if (teePad) {
+            gst_element_release_request_pad(tee, teePad);
+            gst_object_unref(teePad);
+        }
+        gst_object_unref(sinkPad);
+        gst_object_unref(bin);
+        gst_object_unref(tee);
+        Napi::Error::New(env, "Failed to link branch to " + teeName).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    int id = nextBranch_++;
+    branches_[id] = {bin, tee, teePad, sinkPad};
+    CollectQueues(GST_BIN(bin), id);
+    return Napi::Number::New(env, id);
+}
+
+// Unlink at a buffer boundary, then shut the bin down; the rest of the
+// graph keeps running throughout
+void CapturePipeline::DetachBranch(PipelineBranch& branch) {
+    auto probe = std::make_shared<UnlinkProbe>();
+    gst_pad_add_probe(branch.teePad, GST_PAD_PROBE_TYPE_IDLE, OnTeePadIdle,
+        new std::shared_ptr<UnlinkProbe>(probe),
+        [](gpointer data) { delete static_cast<std::shared_ptr<UnlinkProbe>*>(data); });
+
+    bool unlinked;
+    {
+        std::unique_lock<std::mutex> lock(probe->mutex);
+        unlinked = probe->cv.wait_for(lock, kUnlinkTimeout, [&] { return probe->done; });
+    }
+    if (!unlinked) {
+        gst_pad_unlink(branch.teePad, branch.sinkPad);
+    }
+
+    gst_element_set_state(branch.bin, GST_STATE_NULL);
+    gst_bin_remove(GST_BIN(pipeline_), branch.bin);
+    gst_element_release_request_pad(branch.tee, branch.teePad);
+
+    // A branch added later reuses the element names (live_enc, live_sink);
+    // its QoS counts start from zero, not from this branch's total
+    {
+        std::vector<GstElement*> elements = ListElements(GST_BIN(branch.bin));
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        for (GstElement* element : elements) {
+            gchar* name = gst_element_get_name(element);
+            qosDropped_.erase(name);
+            g_free(name);
+            gst_object_unref(element);
+        }
+    }
+
+    gst_object_unref(branch.teePad);
+    gst_object_unref(branch.sinkPad);
+    gst_object_unref(branch.tee);
+    gst_object_unref(branch.bin);
+}
+
+// removeBranch(id) -> false if there is no such branch
+Napi::Value CapturePipeline::RemoveBranch(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsNumber()) {
+        Napi::TypeError::New(env, "Branch id expected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    auto it = branches_.find(info[0].As<Napi::Number>().Int32Value());
+    if (closed_ || it == branches_.end()) return Napi::Boolean::New(env, false);
+
+    DetachBranch(it->second);
+    ReleaseQueues(it->first);
+    branches_.erase(it);
+    return Napi::Boolean::New(env, true);
+}
+
+// setProperty(element, property, value) -> true if applied, false if the
+// element does not accept changes to it in its current state (most encoders
+// only take some settings before they start) or the value doesn't convert to
+// the property's type or is outside its range. Values are converted the way
+// gst-launch converts them, so enums can be given by nick.
+Napi::Value CapturePipeline::SetProperty(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 3 || !info[0].IsString() || !info[1].IsString()) {
+        Napi::TypeError::New(env, "Element name, property and value expected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    if (closed_) return Napi::Boolean::New(env, false);
+
+    std::string elementName = info[0].As<Napi::String>().Utf8Value();
+    std::string property = info[1].As<Napi::String>().Utf8Value();
+    std::string error;
+    GParamSpec* pspec = nullptr;
+    GstElement* element = FindProperty(pipeline_, elementName, property, &pspec, error);
+    if (!element) {
+        Napi::Error::New(env, error).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    if (!(pspec->flags & G_PARAM_WRITABLE)) {
+        gst_object_unref(element);
+        Napi::Error::New(env, elementName + "." + property + " is read-only").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    GstState state = GST_STATE(element);
+    bool mutableNow = state <= GST_STATE_READY ||
+        (pspec->flags & GST_PARAM_MUTABLE_PLAYING) ||
+        (state == GST_STATE_PAUSED && (pspec->flags & GST_PARAM_MUTABLE_PAUSED));
+    if (!mutableNow) {
+        gst_object_unref(element);
+        return Napi::Boolean::New(env, false);
+    }
+
+    std::string text;
+    if (info[2].IsBoolean()) {
+        text = info[2].As<Napi::Boolean>().Value() ? "true" : "false";
+    } else if (info[2].IsNumber()) {
+        double value = info[2].As<Napi::Number>().DoubleValue();
+        text = value == static_cast<double>(static_cast<int64_t>(value))
+            ? std::to_string(static_cast<int64_t>(value))
+            : std::to_string(value);
+    } else {
+        text = info[2].ToString().Utf8Value();
+    }
+
+    // gst_util_set_object_arg would drop a bad value silently. Validation
+    // returns true when it had to clamp the value into range.
+    GValue value = G_VALUE_INIT;
+    g_value_init(&value, pspec->value_type);
+    const bool valid = gst_value_deserialize(&value, text.c_str()) &&
+                       !g_param_value_validate(pspec, &value);
+    if (valid) g_object_set_property(G_OBJECT(element), property.c_str(), &value);
+    g_value_unset(&value);
+    gst_object_unref(element);
+    return Napi::Boolean::New(env, valid);
+}
+
+// getProperty(element, property) -> number | boolean | string
+Napi::Value CapturePipeline::GetProperty(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 2 || !info[0].IsString() || !info[1].IsString()) {
+        Napi::TypeError::New(env, "Element name and property expected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    if (closed_) return env.Null();
+
+    std::string elementName = info[0].As<Napi::String>().Utf8Value();
+    std::string property = info[1].As<Napi::String>().Utf8Value();
+    std::string error;
+    GParamSpec* pspec = nullptr;
+    GstElement* element = FindProperty(pipeline_, elementName, property, &pspec, error);
+    if (!element) {
+        Napi::Error::New(env, error).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    GValue value = G_VALUE_INIT;
+    g_value_init(&value, pspec->value_type);
+    g_object_get_property(G_OBJECT(element), property.c_str(), &value);
+    gst_object_unref(element);
+
+    Napi::Value result;
+    GValue number = G_VALUE_INIT;
+    g_value_init(&number, G_TYPE_DOUBLE);
+    if (G_VALUE_HOLDS_BOOLEAN(&value)) {
+        result = Napi::Boolean::New(env, g_value_get_boolean(&value));
+    } else if (G_VALUE_HOLDS_STRING(&value)) {
+        const gchar* str = g_value_get_string(&value);
+        result = str ? Napi::String::New(env, str) : env.Null();
+    } else if (!G_VALUE_HOLDS_ENUM(&value) && g_value_type_transformable(pspec->value_type, G_TYPE_DOUBLE) &&
+               g_value_transform(&value, &number)) {
+        result = Napi::Number::New(env, g_value_get_double(&number));
+    } else {
+        // Enums by nick, caps and structures as their gst-launch text
+        gchar* text = gst_value_serialize(&value);
+        result = text ? Napi::String::New(env, text) : env.Null();
+        g_free(text);
+    }
+    g_value_unset(&number);
+    g_value_unset(&value);
+    return result;
+}
+
+// getRtcpStats(element) -> [{ ssrc, fractionLost, packetsLost, jitterMs,
+// roundTripMs, packetsSent }] for each stream the element sends over RTP,
+// from the latest RTCP receiver report of the peer. Streams without a report
+// yet are left out.
+Napi::Value CapturePipeline::GetRtcpStats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Element name expected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    Napi::Array result = Napi::Array::New(env);
+    if (closed_) return result;
+
+    std::string elementName = info[0].As<Napi::String>().Utf8Value();
+    GstElement* element = gst_bin_get_by_name(GST_BIN(pipeline_), elementName.c_str());
+    if (!element) {
+        Napi::Error::New(env, "No element named " + elementName).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    // rtspclientsink and rtpbin keep their sessions in child rtpsession elements
+    std::vector<GstElement*> elements;
+    if (GST_IS_BIN(element)) elements = ListElements(GST_BIN(element));
+    gst_object_unref(element);
+
+    uint32_t count = 0;
+    for (GstElement* e : elements) {
+        if (std::string(FactoryName(e)) != "rtpsession") {
+            gst_object_unref(e);
+            continue;
+        }
+
+        GstStructure* stats = nullptr;
+        g_object_get(e, "stats", &stats, nullptr);
+        gst_object_unref(e);
+        if (!stats) continue;
+
+        // source-stats is still a GValueArray
+        const GValue* sources = gst_structure_get_value(stats, "source-stats");
+G_GNUC_BEGIN_IGNORE_DEPRECATIONS
+        GValueArray* array = sources ? static_cast<GValueArray*>(g_value_get_boxed(sources)) : nullptr;
+        guint sourceCount = array ? array->n_values : 0;
+G_GNUC_END_IGNORE_DEPRECATIONS
+
+        for (guint i = 0; i < sourceCount; i++) {
+            const GstStructure* source = gst_value_get_structure(&array->values[i]);
+            gboolean internal = FALSE, sender = FALSE, haveRb = FALSE;
+            gst_structure_get_boolean(source, "internal", &internal);
+            gst_structure_get_boolean(source, "is-sender", &sender);
+            gst_structure_get_boolean(source, "have-rb", &haveRb);
+            if (!internal || !sender || !haveRb) continue;
+
+            guint ssrc = 0, fractionLost = 0, jitter = 0, roundTrip = 0;
+            gint packetsLost = 0, clockRate = 0;
+            guint64 packetsSent = 0;
+            gst_structure_get_uint(source, "ssrc", &ssrc);
+            gst_structure_get_uint(source, "rb-fractionlost", &fractionLost);
+            gst_structure_get_int(source, "rb-packetslost", &packetsLost);
+            gst_structure_get_uint(source, "rb-jitter", &jitter);
+            gst_structure_get_uint(source, "rb-round-trip", &roundTrip);
+            gst_structure_get_int(source, "clock-rate", &clockRate);
+            gst_structure_get_uint64(source, "packets-sent", &packetsSent);
+
+            Napi::Object entry = Napi::Object::New(env);
+            entry.Set("ssrc", Napi::Number::New(env, ssrc));
+            entry.Set("fractionLost", Napi::Number::New(env, fractionLost / 256.0));  // 8-bit fixed point
+            entry.Set("packetsLost", Napi::Number::New(env, packetsLost));
+            entry.Set("jitterMs", clockRate > 0
+                ? Napi::Number::New(env, jitter * 1000.0 / clockRate) : env.Null());
+            entry.Set("roundTripMs", Napi::Number::New(env, roundTrip * 1000.0 / 65536));  // 16.16 seconds
+            entry.Set("packetsSent", Napi::Number::New(env, static_cast<double>(packetsSent)));
+            result.Set(count++, entry);
+        }
+        gst_structure_free(stats);
+    }
+    return result;
+}
+
+// close() - stop immediately (send EOS first and wait for it to finalize files)
+Napi::Value CapturePipeline::Close(const Napi::CallbackInfo& info) {
+    Shutdown();
+    return info.Env().Undefined();
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <napi.h>
+#include <gst/gst.h>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Per-queue counters updated from streaming threads
+struct QueueCounters {
+    GstElement* element;                // owned reference
+    int branch = 0;                     // 0 for the static graph
+    std::atomic<uint64_t> overruns{0};  // buffers dropped, for leaky queues
+};
+
+// Bin attached to a tee while the pipeline runs (addBranch/removeBranch)
+struct PipelineBranch {
+    GstElement* bin;                    // owned references
+    GstElement* tee;
+    GstPad* teePad;                     // request pad on the tee
+    GstPad* sinkPad;                    // ghost sink pad of the bin
+};
+
+struct AppSinkCounters;
+
+// Capture graph run inside the addon process with the GStreamer C API, built
+// from the same description gst-launch-1.0 takes. Bus messages are forwarded
+// to a JS callback from a dedicated bus thread; queue fill levels, leaky-queue
+// drops and QoS drops are available without stopping the pipeline, and
+// appsink elements can deliver samples straight to JS. Branches can be added
+// to and removed from a tee without stopping the rest of the graph, and
+// element properties changed where the element allows it while running.
+// RTCP receiver reports of RTP senders (rtspclientsink) can be read back
+// as congestion feedback.
+class CapturePipeline : public Napi::ObjectWrap<CapturePipeline> {
+public:
+    static Napi::Object Init(Napi::Env env, Napi::Object exports);
+
+    CapturePipeline(const Napi::CallbackInfo& info);
+    ~CapturePipeline();
+
+private:
+    static Napi::FunctionReference constructor;
+
+    GstElement* pipeline_ = nullptr;
+    GstBus* bus_ = nullptr;
+    std::thread busThread_;
+    std::atomic<bool> stopping_{false};
+    bool closed_ = false;
+    Napi::ThreadSafeFunction messageTsfn_;
+    bool hasMessageTsfn_ = false;
+
+    std::vector<std::unique_ptr<QueueCounters>> queues_;
+    std::vector<std::unique_ptr<AppSinkCounters>> appSinks_;
+    std::map<int, PipelineBranch> branches_;
+    int nextBranch_ = 1;
+
+    // Guarded by statsMutex_, written by the bus thread
+    std::mutex statsMutex_;
+    // Element name -> dropped buffers; a removed branch's entries are erased
+    std::map<std::string, uint64_t> qosDropped_;
+    uint64_t errors_ = 0;
+    uint64_t warnings_ = 0;
+    int64_t startedAt_ = 0;
+
+    void RunBus();
+    void CollectQueues(GstBin* bin, int branch);
+    void ReleaseQueues(int branch);
+    void DetachBranch(PipelineBranch& branch);
+    void Shutdown();
+
+    Napi::Value Start(const Napi::CallbackInfo& info);
+    Napi::Value SendEos(const Napi::CallbackInfo& info);
+    Napi::Value GetState(const Napi::CallbackInfo& info);
+    Napi::Value GetStats(const Napi::CallbackInfo& info);
+    Napi::Value ConnectAppSink(const Napi::CallbackInfo& info);
+    Napi::Value AddBranch(const Napi::CallbackInfo& info);
+    Napi::Value RemoveBranch(const Napi::CallbackInfo& info);
+    Napi::Value SetProperty(const Napi::CallbackInfo& info);
+    Napi::Value GetProperty(const Napi::CallbackInfo& info);
+    Napi::Value GetRtcpStats(const Napi::CallbackInfo& info);
+    Napi::Value Close(const Napi::CallbackInfo& info);
+};
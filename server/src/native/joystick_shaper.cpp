@@ -0,0 +1,206 @@
+#include "joystick_shaper.hpp"
+#include <algorithm>
+#include <cmath>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+
+// Longest ramp between inputs; a gap beyond it is a new gesture, not jitter
+constexpr double kMaxRampMs = 200.0;
+// Weight of each new gap in the smoothed input interval
+constexpr double kIntervalAlpha = 0.2;
+// Speeds below this count as stopped, deg/s
+constexpr double kStillSpeed = 0.01;
+
+using Clock = std::chrono::steady_clock;
+
+double MsBetween(Clock::time_point from, Clock::time_point to) {
+    return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+}  // namespace
+
+JoystickShaper::JoystickShaper(std::shared_ptr<Device> device)
+    : device_(std::move(device)) {
+    thread_ = std::thread(&JoystickShaper::Run, this);
+}
+
+JoystickShaper::~JoystickShaper() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void JoystickShaper::Configure(const JoystickOptions& options) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    options_ = options;
+}
+
+void JoystickShaper::Input(double pitch, double pan) {
+    const Clock::time_point now = Clock::now();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // Continue from wherever the previous ramp has got to
+        const double f = rampMs_ > 0 ? std::min(1.0, MsBetween(rampStart_, now) / rampMs_) : 1.0;
+        for (int i = 0; i < 2; i++) {
+            rampFrom_[i] += (rampTo_[i] - rampFrom_[i]) * f;
+        }
+        rampTo_[0] = std::clamp(pitch, -1.0, 1.0);
+        rampTo_[1] = std::clamp(pan, -1.0, 1.0);
+
+        if (hasInput_) {
+            const double gap = std::min(MsBetween(lastInput_, now), kMaxRampMs);
+            intervalMs_ += kIntervalAlpha * (gap - intervalMs_);
+        }
+        rampMs_ = intervalMs_;
+        rampStart_ = now;
+        lastInput_ = now;
+        hasInput_ = true;
+    }
+    inputs_++;
+    cv_.notify_all();
+}
+
+void JoystickShaper::Reset() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        rampFrom_[0] = rampFrom_[1] = 0;
+        rampTo_[0] = rampTo_[1] = 0;
+        hasInput_ = false;
+        reset_ = true;
+    }
+    cv_.notify_all();
+}
+
+double JoystickShaper::Shape(double input, const JoystickOptions& options) const {
+    double a = std::fabs(input);
+    if (a <= options.deadzone) return 0;
+    // Rescale so output starts from zero at the deadzone edge
+    a = (a - options.deadzone) / (1 - options.deadzone);
+    a = (1 - options.expo) * a + options.expo * a * a * a;
+    return std::copysign(std::min(a, 1.0), input);
+}
+
+Napi::Object JoystickShaper::Stats(Napi::Env env) {
+    Napi::Object obj = Napi::Object::New(env);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        obj.Set("rateHz", options_.rateHz);
+        obj.Set("intervalMs", intervalMs_);
+    }
+    obj.Set("inputs", static_cast<double>(inputs_.load()));
+    obj.Set("commands", static_cast<double>(commands_.load()));
+    obj.Set("lateTicks", static_cast<double>(lateTicks_.load()));
+    obj.Set("watchdogTrips", static_cast<double>(watchdogTrips_.load()));
+    Napi::Object output = Napi::Object::New(env);
+    output.Set("pitch", outPitch_.load());
+    output.Set("pan", outPan_.load());
+    obj.Set("output", output);
+    return obj;
+}
+
+void JoystickShaper::Run() {
+#ifdef __linux__
+    // Best effort, as for the gimbal mover: a steady rate is the point of this thread
+    sched_param param{};
+    param.sched_priority = 10;
+    pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+#endif
+
+    Clock::time_point next = Clock::now();
+    while (true) {
+        JoystickOptions options;
+        double input[2];
+        bool expired = false;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            auto idle = [this] {
+                return !moving_ && !reset_ && rampTo_[0] == 0 && rampTo_[1] == 0;
+            };
+            if (idle()) {
+                cv_.wait(lock, [&] { return stopping_ || !idle(); });
+                next = Clock::now();
+            }
+            if (stopping_) return;
+
+            if (reset_) {
+                // Another control path owns the gimbal now; send nothing
+                reset_ = false;
+                moving_ = false;
+                speed_[0] = speed_[1] = 0;
+                outPitch_ = outPan_ = 0;
+                continue;
+            }
+
+            options = options_;
+            const Clock::time_point now = Clock::now();
+            const double f = rampMs_ > 0 ? std::min(1.0, MsBetween(rampStart_, now) / rampMs_) : 1.0;
+            for (int i = 0; i < 2; i++) {
+                input[i] = rampFrom_[i] + (rampTo_[i] - rampFrom_[i]) * f;
+            }
+
+            // Input stopped arriving with the stick off center (client gone,
+            // network stall); a centered stick just ramps down by itself
+            const bool deflected = rampTo_[0] != 0 || rampTo_[1] != 0;
+            if (deflected && MsBetween(lastInput_, now) > options.watchdogMs) {
+                expired = true;
+                hasInput_ = false;
+                rampFrom_[0] = rampFrom_[1] = 0;
+                rampTo_[0] = rampTo_[1] = 0;
+            }
+        }
+
+        if (expired) {
+            device_->aiSetGimbalStop();
+            commands_++;
+            watchdogTrips_++;
+            moving_ = false;
+            speed_[0] = speed_[1] = 0;
+            outPitch_ = outPan_ = 0;
+            continue;
+        }
+
+        // Deadzone + expo, scaled to deg/s, then slew-limited
+        const double dt = 1.0 / options.rateHz;
+        const double maxStep = options.maxAccel * dt;
+        for (int i = 0; i < 2; i++) {
+            const double target = Shape(input[i], options) * options.maxSpeed;
+            speed_[i] += std::clamp(target - speed_[i], -maxStep, maxStep);
+            if (std::fabs(speed_[i]) < kStillSpeed) speed_[i] = 0;
+        }
+
+        if (speed_[0] == 0 && speed_[1] == 0) {
+            // One explicit stop when the ramp down reaches zero, then idle
+            if (moving_) {
+                device_->aiSetGimbalStop();
+                commands_++;
+                moving_ = false;
+            }
+        } else {
+            device_->aiSetGimbalSpeedCtrlR(speed_[0], speed_[1], 0);
+            commands_++;
+            moving_ = true;
+        }
+        outPitch_ = speed_[0];
+        outPan_ = speed_[1];
+
+        next += std::chrono::microseconds(1000000 / options.rateHz);
+        const Clock::time_point now = Clock::now();
+        if (now > next) {
+            // Behind (slow SDK call): skip the missed ticks instead of bursting
+            lateTicks_++;
+            next = now;
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait_until(lock, next, [this] { return stopping_ || reset_; });
+    }
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <napi.h>
+#include <dev/dev.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+struct JoystickOptions {
+    int rateHz = 50;
+    double deadzone = 0.05;          // fraction of full deflection ignored around center
+    double expo = 0.4;               // 0: linear, 1: cubic
+    double maxSpeed = 50;            // deg/s at full deflection
+    double maxAccel = 200;           // deg/s^2 slew limit on the commanded speed
+    int watchdogMs = 500;            // stop when no input arrives for this long
+};
+
+// Turns network-timed joystick input into speed commands at a steady rate.
+// Each input (pitch and pan deflection, -1..1) is ramped to over the measured
+// interval between inputs, so jittery arrival doesn't become jerky speed. The
+// ramped value goes through a deadzone and expo curve, is scaled to deg/s and
+// slew-limited, then sent with aiSetGimbalSpeedCtrlR every tick. Without input
+// for watchdogMs the gimbal is stopped with aiSetGimbalStop. The thread sleeps
+// while the stick is centered and the gimbal is still.
+class JoystickShaper {
+public:
+    explicit JoystickShaper(std::shared_ptr<Device> device);
+    ~JoystickShaper();
+
+    void Configure(const JoystickOptions& options);
+    void Input(double pitch, double pan);
+    // Drop the current motion without commanding anything, when another
+    // control path takes over the gimbal
+    void Reset();
+    Napi::Object Stats(Napi::Env env);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    std::shared_ptr<Device> device_;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopping_ = false;
+    JoystickOptions options_;
+
+    // Input ramp, guarded by mutex_
+    double rampFrom_[2] = {0, 0};    // pitch, pan
+    double rampTo_[2] = {0, 0};
+    Clock::time_point rampStart_;
+    double rampMs_ = 0;
+    Clock::time_point lastInput_;
+    double intervalMs_ = 50;         // smoothed time between inputs
+    bool hasInput_ = false;
+    bool reset_ = false;
+
+    // Output state, shaper thread only
+    double speed_[2] = {0, 0};
+    bool moving_ = false;
+
+    // Stats
+    std::atomic<long long> inputs_{0};
+    std::atomic<long long> commands_{0};
+    std::atomic<long long> lateTicks_{0};
+    std::atomic<long long> watchdogTrips_{0};
+    std::atomic<double> outPitch_{0};
+    std::atomic<double> outPan_{0};
+
+    void Run();
+    double Shape(double input, const JoystickOptions& options) const;
+};
@@ -0,0 +1,266 @@
+#include "keyword_matcher.hpp"
+#include <algorithm>
+#include <queue>
+
+Napi::FunctionReference KeywordMatcher::constructor;
+
+namespace {
+
+// Decode one code point, advancing pos; malformed input yields U+FFFD
+uint32_t DecodeUtf8(const std::string& s, size_t& pos) {
+    uint8_t c = static_cast<uint8_t>(s[pos++]);
+    if (c < 0x80) return c;
+
+    int extra = c >= 0xF0 ? 3 : c >= 0xE0 ? 2 : c >= 0xC0 ? 1 : -1;
+    if (extra < 0 || pos + extra > s.size()) return 0xFFFD;
+
+    uint32_t cp = c & (0x3F >> extra);
+    for (int i = 0; i < extra; i++) {
+        uint8_t cont = static_cast<uint8_t>(s[pos]);
+        if ((cont & 0xC0) != 0x80) return 0xFFFD;
+        cp = (cp << 6) | (cont & 0x3F);
+        pos++;
+    }
+    return cp;
+}
+
+void EncodeUtf8(uint32_t cp, std::string& out) {
+    if (cp < 0x80) {
+        out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+// Simple (1:1) case folding for the scripts transcripts are likely to use
+uint32_t FoldCase(uint32_t cp) {
+    if (cp >= 'A' && cp <= 'Z') return cp + 32;
+    if (cp < 0xC0) return cp;
+
+    // Latin-1 Supplement
+    if (cp <= 0xDE && cp != 0xD7) return cp + 32;
+
+    // Latin Extended-A: upper/lower pairs, with the parity flipping twice
+    if ((cp >= 0x100 && cp <= 0x137) || (cp >= 0x14A && cp <= 0x177)) return cp | 1;
+    if ((cp >= 0x139 && cp <= 0x148) || (cp >= 0x179 && cp <= 0x17E)) return (cp & 1) ? cp + 1 : cp;
+    if (cp == 0x178) return 0xFF;
+    if (cp == 0x17F) return 's';
+
+    // Greek
+    if (cp >= 0x391 && cp <= 0x3A9 && cp != 0x3A2) return cp + 32;
+    if (cp == 0x3C2) return 0x3C3;  // final sigma
+
+    // Cyrillic
+    if (cp >= 0x400 && cp <= 0x40F) return cp + 80;
+    if (cp >= 0x410 && cp <= 0x42F) return cp + 32;
+
+    // Fullwidth Latin
+    if (cp >= 0xFF21 && cp <= 0xFF3A) return cp + 32;
+
+    return cp;
+}
+
+bool IsWordChar(uint32_t cp) {
+    if (cp < 0x80) {
+        return (cp >= '0' && cp <= '9') || (cp >= 'a' && cp <= 'z') || (cp >= 'A' && cp <= 'Z');
+    }
+    if (cp < 0xC0 || cp == 0xD7 || cp == 0xF7) return false;           // Latin-1 punctuation
+    if (cp >= 0x2000 && cp <= 0x2BFF) return false;                     // punctuation, symbols
+    if (cp >= 0x3000 && cp <= 0x303F) return false;                     // CJK punctuation
+    if (cp >= 0xFF00 && cp <= 0xFF0F) return false;                     // fullwidth punctuation
+    if ((cp >= 0xFF1A && cp <= 0xFF20) || (cp >= 0xFF3B && cp <= 0xFF40) ||
+        (cp >= 0xFF5B && cp <= 0xFF65)) return false;
+    if (cp == 0xFFFD || cp == 0xFEFF) return false;
+    if (cp >= 0x1F000 && cp <= 0x1FAFF) return false;                   // emoji
+    return true;
+}
+
+}  // namespace
+
+std::string NormalizeForMatch(const std::string& utf8) {
+    std::string out;
+    out.reserve(utf8.size() + 2);
+    out += ' ';
+
+    size_t pos = 0;
+    while (pos < utf8.size()) {
+        uint32_t cp = DecodeUtf8(utf8, pos);
+        if (IsWordChar(cp)) {
+            EncodeUtf8(FoldCase(cp), out);
+        } else if (out.back() != ' ') {
+            out += ' ';
+        }
+    }
+
+    if (out.back() != ' ') out += ' ';
+    return out;
+}
+
+Napi::Object KeywordMatcher::Init(Napi::Env env, Napi::Object exports) {
+    Napi::Function func = DefineClass(env, "KeywordMatcher", {
+        InstanceMethod("match", &KeywordMatcher::Match),
+        InstanceMethod("getStats", &KeywordMatcher::GetStats),
+    });
+
+    constructor = Napi::Persistent(func);
+    constructor.SuppressDestruct();
+
+    exports.Set("KeywordMatcher", func);
+    return exports;
+}
+
+// new KeywordMatcher([[phrase, ...], ...]) - one phrase list per rule
+KeywordMatcher::KeywordMatcher(const Napi::CallbackInfo& info)
+    : Napi::ObjectWrap<KeywordMatcher>(info) {
+    Napi::Env env = info.Env();
+    nodes_.emplace_back();
+
+    if (info.Length() < 1 || !info[0].IsArray()) {
+        Napi::TypeError::New(env, "Array of phrase lists expected").ThrowAsJavaScriptException();
+        return;
+    }
+
+    Napi::Array rules = info[0].As<Napi::Array>();
+    rules_ = rules.Length();
+    for (uint32_t r = 0; r < rules.Length(); r++) {
+        Napi::Value rule = rules.Get(r);
+        if (!rule.IsArray()) {
+            Napi::TypeError::New(env, "Each rule must be an array of phrases").ThrowAsJavaScriptException();
+            return;
+        }
+
+        Napi::Array list = rule.As<Napi::Array>();
+        for (uint32_t i = 0; i < list.Length(); i++) {
+            Napi::Value phrase = list.Get(i);
+            if (!phrase.IsString()) continue;
+            std::string text = phrase.As<Napi::String>().Utf8Value();
+            AddPhrase(NormalizeForMatch(text), r, text);
+        }
+    }
+
+    Build();
+}
+
+int32_t KeywordMatcher::Child(int32_t node, uint8_t byte) const {
+    const auto& next = nodes_[node].next;
+    auto it = std::lower_bound(next.begin(), next.end(), byte,
+        [](const std::pair<uint8_t, int32_t>& edge, uint8_t b) { return edge.first < b; });
+    return (it != next.end() && it->first == byte) ? it->second : -1;
+}
+
+void KeywordMatcher::AddPhrase(const std::string& normalized, uint32_t rule, const std::string& original) {
+    // Blank or punctuation-only phrases normalize to a single space
+    if (normalized.size() < 3) return;
+
+    int32_t node = 0;
+    for (char ch : normalized) {
+        uint8_t byte = static_cast<uint8_t>(ch);
+        int32_t child = Child(node, byte);
+        if (child < 0) {
+            child = static_cast<int32_t>(nodes_.size());
+            nodes_.emplace_back();
+            auto& next = nodes_[node].next;
+            auto it = std::lower_bound(next.begin(), next.end(), byte,
+                [](const std::pair<uint8_t, int32_t>& edge, uint8_t b) { return edge.first < b; });
+            next.insert(it, {byte, child});
+        }
+        node = child;
+    }
+
+    nodes_[node].outputs.push_back(static_cast<int32_t>(phrases_.size()));
+    phrases_.push_back({rule, original});
+}
+
+// Breadth-first pass computing failure and dictionary-suffix links
+void KeywordMatcher::Build() {
+    std::queue<int32_t> pending;
+    for (const auto& edge : nodes_[0].next) {
+        nodes_[edge.second].fail = 0;
+        pending.push(edge.second);
+    }
+
+    while (!pending.empty()) {
+        int32_t node = pending.front();
+        pending.pop();
+
+        for (const auto& edge : nodes_[node].next) {
+            int32_t fail = nodes_[node].fail;
+            while (fail != 0 && Child(fail, edge.first) < 0) {
+                fail = nodes_[fail].fail;
+            }
+            int32_t target = Child(fail, edge.first);
+            int32_t child = edge.second;
+            nodes_[child].fail = (target >= 0 && target != child) ? target : 0;
+
+            int32_t f = nodes_[child].fail;
+            nodes_[child].dictLink = nodes_[f].outputs.empty() ? nodes_[f].dictLink : f;
+            pending.push(child);
+        }
+    }
+}
+
+// match(text) -> [{ rule, phrase }], at most one entry per rule
+Napi::Value KeywordMatcher::Match(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "String expected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    std::string text = NormalizeForMatch(info[0].As<Napi::String>().Utf8Value());
+    std::vector<int32_t> firstHit(rules_, -1);
+    size_t hits = 0;
+
+    int32_t node = 0;
+    for (char ch : text) {
+        uint8_t byte = static_cast<uint8_t>(ch);
+        while (node != 0 && Child(node, byte) < 0) {
+            node = nodes_[node].fail;
+        }
+        int32_t child = Child(node, byte);
+        node = child < 0 ? 0 : child;
+
+        int32_t out = nodes_[node].outputs.empty() ? nodes_[node].dictLink : node;
+        for (; out >= 0; out = nodes_[out].dictLink) {
+            for (int32_t phrase : nodes_[out].outputs) {
+                int32_t& slot = firstHit[phrases_[phrase].rule];
+                if (slot < 0) {
+                    slot = phrase;
+                    hits++;
+                }
+            }
+        }
+    }
+
+    Napi::Array result = Napi::Array::New(env, hits);
+    uint32_t index = 0;
+    for (size_t rule = 0; rule < rules_; rule++) {
+        if (firstHit[rule] < 0) continue;
+        Napi::Object hit = Napi::Object::New(env);
+        hit.Set("rule", static_cast<double>(rule));
+        hit.Set("phrase", phrases_[firstHit[rule]].text);
+        result[index++] = hit;
+    }
+    return result;
+}
+
+Napi::Value KeywordMatcher::GetStats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("rules", static_cast<double>(rules_));
+    obj.Set("phrases", static_cast<double>(phrases_.size()));
+    obj.Set("nodes", static_cast<double>(nodes_.size()));
+    return obj;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <napi.h>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Lowercase (simple Unicode case folding for Latin, Greek and Cyrillic) and
+// collapse every run of non-word characters into one space, padded at both
+// ends. Matching " phrase " against the normalized text is then word-boundary
+// aware and ignores punctuation: "Oh, my GOD!" contains " oh my god ".
+std::string NormalizeForMatch(const std::string& utf8);
+
+// Aho-Corasick automaton over many keyword phrases grouped into rules. One
+// pass over a transcript finds every rule with a matching phrase, regardless
+// of how many phrases are loaded.
+class KeywordMatcher : public Napi::ObjectWrap<KeywordMatcher> {
+public:
+    static Napi::Object Init(Napi::Env env, Napi::Object exports);
+
+    KeywordMatcher(const Napi::CallbackInfo& info);
+
+private:
+    static Napi::FunctionReference constructor;
+
+    struct Node {
+        std::vector<std::pair<uint8_t, int32_t>> next;  // sorted by byte
+        int32_t fail = 0;
+        std::vector<int32_t> outputs;   // phrases ending here
+        int32_t dictLink = -1;          // nearest node on the fail chain with outputs
+    };
+
+    struct Phrase {
+        uint32_t rule;
+        std::string text;       // as given in the config
+    };
+
+    std::vector<Node> nodes_;
+    std::vector<Phrase> phrases_;
+    size_t rules_ = 0;
+
+    int32_t Child(int32_t node, uint8_t byte) const;
+    void AddPhrase(const std::string& normalized, uint32_t rule, const std::string& original);
+    void Build();
+
+    Napi::Value Match(const Napi::CallbackInfo& info);
+    Napi::Value GetStats(const Napi::CallbackInfo& info);
+};
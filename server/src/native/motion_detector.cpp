@@ -0,0 +1,330 @@
+#include "motion_detector.hpp"
+#include <algorithm>
+#include <chrono>
+#include <csetjmp>
+#include <cstdio>
+#include <jpeglib.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define OBSBOT_MOTION_SSE2 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define OBSBOT_MOTION_NEON 1
+#endif
+
+Napi::FunctionReference MotionDetector::constructor;
+
+namespace {
+
+struct JpegError {
+    jpeg_error_mgr mgr;
+    jmp_buf jump;
+    char message[JMSG_LENGTH_MAX];
+};
+
+void OnJpegError(j_common_ptr cinfo) {
+    JpegError* err = reinterpret_cast<JpegError*>(cinfo->err);
+    (*cinfo->err->format_message)(cinfo, err->message);
+    longjmp(err->jump, 1);
+}
+
+// Count unmasked pixels that differ from the background by more than
+// threshold, and move the background 1/2^shift of the way towards the frame.
+size_t DiffAndLearn(const uint8_t* frame, int16_t* background, const uint8_t* mask,
+                    size_t count, int threshold, int shift) {
+    size_t i = 0;
+    size_t changed = 0;
+#if defined(OBSBOT_MOTION_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i thr = _mm_set1_epi16(static_cast<int16_t>(threshold));
+    const __m128i sh = _mm_cvtsi32_si128(shift);
+    for (; i < (count & ~size_t(7)); i += 8) {
+        __m128i f = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(frame + i)), zero);
+        __m128i m = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(mask + i));
+        m = _mm_unpacklo_epi8(m, m);
+        __m128i bg = _mm_loadu_si128(reinterpret_cast<const __m128i*>(background + i));
+
+        __m128i b = _mm_srai_epi16(bg, 4);
+        __m128i diff = _mm_max_epi16(_mm_sub_epi16(f, b), _mm_sub_epi16(b, f));
+        __m128i hit = _mm_and_si128(_mm_cmpgt_epi16(diff, thr), m);
+        // Two movemask bits per 16-bit lane
+        changed += static_cast<size_t>(__builtin_popcount(_mm_movemask_epi8(hit))) / 2;
+
+        bg = _mm_add_epi16(bg, _mm_sra_epi16(_mm_sub_epi16(_mm_slli_epi16(f, 4), bg), sh));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(background + i), bg);
+    }
+#elif defined(OBSBOT_MOTION_NEON)
+    const int16x8_t thr = vdupq_n_s16(static_cast<int16_t>(threshold));
+    const int16x8_t sh = vdupq_n_s16(static_cast<int16_t>(-shift));
+    uint32x4_t acc = vdupq_n_u32(0);
+    for (; i < (count & ~size_t(7)); i += 8) {
+        int16x8_t f = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(frame + i)));
+        uint16x8_t m = vreinterpretq_u16_s16(vmovl_s8(vreinterpret_s8_u8(vld1_u8(mask + i))));
+        int16x8_t bg = vld1q_s16(background + i);
+
+        int16x8_t diff = vabdq_s16(f, vshrq_n_s16(bg, 4));
+        uint16x8_t hit = vandq_u16(vcgtq_s16(diff, thr), m);
+        acc = vpadalq_u16(acc, vshrq_n_u16(hit, 15));
+
+        bg = vaddq_s16(bg, vshlq_s16(vsubq_s16(vshlq_n_s16(f, 4), bg), sh));
+        vst1q_s16(background + i, bg);
+    }
+    changed = vgetq_lane_u32(acc, 0) + vgetq_lane_u32(acc, 1) +
+              vgetq_lane_u32(acc, 2) + vgetq_lane_u32(acc, 3);
+#endif
+    for (; i < count; i++) {
+        int f = frame[i];
+        int diff = f - (background[i] >> 4);
+        if (mask[i] && (diff > threshold || -diff > threshold)) changed++;
+        background[i] = static_cast<int16_t>(background[i] + (((f << 4) - background[i]) >> shift));
+    }
+    return changed;
+}
+
+class MotionJob : public Napi::AsyncWorker {
+public:
+    MotionJob(Napi::Env env, MotionDetector* detector, Napi::Object self, std::vector<uint8_t> jpeg)
+        : Napi::AsyncWorker(env),
+          detector_(detector),
+          self_(Napi::Persistent(self)),
+          jpeg_(std::move(jpeg)),
+          deferred_(Napi::Promise::Deferred::New(env)) {}
+
+    Napi::Promise GetPromise() { return deferred_.Promise(); }
+
+protected:
+    void Execute() override {
+        std::string error;
+        if (!detector_->Analyze(jpeg_, result_, error)) {
+            SetError(error);
+        }
+    }
+
+    void OnOK() override {
+        Napi::Env env = Env();
+        detector_->Finish();
+
+        Napi::Object obj = Napi::Object::New(env);
+        obj.Set("motion", result_.motion);
+        obj.Set("lightingChange", result_.lightingChange);
+        obj.Set("score", result_.score);
+        obj.Set("width", result_.width);
+        obj.Set("height", result_.height);
+        obj.Set("decodeUs", result_.decodeUs);
+        obj.Set("elapsedUs", result_.elapsedUs);
+        deferred_.Resolve(obj);
+    }
+
+    void OnError(const Napi::Error& error) override {
+        detector_->Finish();
+        deferred_.Reject(error.Value());
+    }
+
+private:
+    MotionDetector* detector_;
+    Napi::ObjectReference self_;    // keeps the detector alive while queued
+    std::vector<uint8_t> jpeg_;
+    Napi::Promise::Deferred deferred_;
+    MotionResult result_;
+};
+
+}  // namespace
+
+Napi::Object MotionDetector::Init(Napi::Env env, Napi::Object exports) {
+    Napi::Function func = DefineClass(env, "MotionDetector", {
+        InstanceMethod("process", &MotionDetector::Process),
+        InstanceMethod("reset", &MotionDetector::Reset),
+        InstanceMethod("getStats", &MotionDetector::GetStats),
+    });
+
+    constructor = Napi::Persistent(func);
+    constructor.SuppressDestruct();
+
+    exports.Set("MotionDetector", func);
+    return exports;
+}
+
+// new MotionDetector({ threshold?, minArea?, maxArea?, learnShift?, masks?: [{ x, y, w, h }] })
+MotionDetector::MotionDetector(const Napi::CallbackInfo& info)
+    : Napi::ObjectWrap<MotionDetector>(info) {
+    if (info.Length() < 1 || !info[0].IsObject()) return;
+
+    Napi::Object opts = info[0].As<Napi::Object>();
+    if (opts.Get("threshold").IsNumber()) {
+        options_.threshold = std::clamp(opts.Get("threshold").As<Napi::Number>().Int32Value(), 1, 255);
+    }
+    if (opts.Get("minArea").IsNumber()) {
+        options_.minArea = opts.Get("minArea").As<Napi::Number>().FloatValue();
+    }
+    if (opts.Get("maxArea").IsNumber()) {
+        options_.maxArea = opts.Get("maxArea").As<Napi::Number>().FloatValue();
+    }
+    if (opts.Get("learnShift").IsNumber()) {
+        options_.learnShift = std::clamp(opts.Get("learnShift").As<Napi::Number>().Int32Value(), 1, 10);
+    }
+
+    if (opts.Get("masks").IsArray()) {
+        Napi::Array masks = opts.Get("masks").As<Napi::Array>();
+        for (uint32_t i = 0; i < masks.Length(); i++) {
+            if (!masks.Get(i).IsObject()) continue;
+            Napi::Object rect = masks.Get(i).As<Napi::Object>();
+            auto coord = [&](const char* key) {
+                return rect.Get(key).IsNumber() ? rect.Get(key).As<Napi::Number>().FloatValue() : 0.0f;
+            };
+            const MotionMask mask{coord("x"), coord("y"), coord("w"), coord("h")};
+            if (!(mask.w > 0) || !(mask.h > 0)) {
+                Napi::RangeError::New(info.Env(), "Mask width and height must be positive")
+                    .ThrowAsJavaScriptException();
+                return;
+            }
+            masks_.push_back(mask);
+        }
+    }
+}
+
+void MotionDetector::Resize(int width, int height) {
+    width_ = width;
+    height_ = height;
+    size_t count = static_cast<size_t>(width) * height;
+    luma_.assign(count, 0);
+    background_.assign(count, 0);
+    mask_.assign(count, 0xFF);
+    hasBackground_ = false;
+
+    for (const MotionMask& m : masks_) {
+        int x0 = std::clamp(static_cast<int>(m.x * width), 0, width);
+        int y0 = std::clamp(static_cast<int>(m.y * height), 0, height);
+        int x1 = std::clamp(static_cast<int>((m.x + m.w) * width + 0.5f), 0, width);
+        int y1 = std::clamp(static_cast<int>((m.y + m.h) * height + 0.5f), 0, height);
+        // Never left of or above the start, whatever the rectangle says
+        x1 = std::max(x1, x0);
+        y1 = std::max(y1, y0);
+        for (int y = y0; y < y1; y++) {
+            std::fill(mask_.begin() + y * width + x0, mask_.begin() + y * width + x1, 0);
+        }
+    }
+    activePixels_ = static_cast<size_t>(std::count(mask_.begin(), mask_.end(), 0xFF));
+}
+
+bool MotionDetector::Decode(const std::vector<uint8_t>& jpeg, std::string& error) {
+    jpeg_decompress_struct cinfo;
+    JpegError err;
+    cinfo.err = jpeg_std_error(&err.mgr);
+    err.mgr.error_exit = OnJpegError;
+
+    if (setjmp(err.jump)) {
+        error = err.message;
+        jpeg_destroy_decompress(&cinfo);
+        return false;
+    }
+
+    jpeg_create_decompress(&cinfo);
+    jpeg_mem_src(&cinfo, jpeg.data(), static_cast<unsigned long>(jpeg.size()));
+    jpeg_read_header(&cinfo, TRUE);
+
+    // 1/8 scale: each 8x8 block becomes one pixel from its DC coefficient
+    cinfo.scale_num = 1;
+    cinfo.scale_denom = 8;
+    cinfo.out_color_space = JCS_GRAYSCALE;
+    cinfo.dct_method = JDCT_IFAST;
+    cinfo.do_fancy_upsampling = FALSE;
+    jpeg_start_decompress(&cinfo);
+
+    int width = static_cast<int>(cinfo.output_width);
+    int height = static_cast<int>(cinfo.output_height);
+    if (width != width_ || height != height_) {
+        Resize(width, height);
+    }
+
+    while (cinfo.output_scanline < cinfo.output_height) {
+        JSAMPROW row = luma_.data() + static_cast<size_t>(cinfo.output_scanline) * width;
+        jpeg_read_scanlines(&cinfo, &row, 1);
+    }
+
+    jpeg_finish_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+    return true;
+}
+
+bool MotionDetector::Analyze(const std::vector<uint8_t>& jpeg, MotionResult& result, std::string& error) {
+    auto started = std::chrono::steady_clock::now();
+
+    if (!Decode(jpeg, error)) return false;
+    auto decoded = std::chrono::steady_clock::now();
+
+    size_t count = luma_.size();
+    if (!hasBackground_ || resetPending_) {
+        for (size_t i = 0; i < count; i++) {
+            background_[i] = static_cast<int16_t>(luma_[i] << 4);
+        }
+        hasBackground_ = true;
+        resetPending_ = false;
+    } else {
+        size_t changed = DiffAndLearn(luma_.data(), background_.data(), mask_.data(), count,
+                                      options_.threshold, options_.learnShift);
+        result.score = activePixels_ ? static_cast<float>(changed) / activePixels_ : 0.0f;
+
+        if (result.score > options_.maxArea) {
+            // Lights switched or exposure jumped: start over from this frame
+            result.lightingChange = true;
+            resetPending_ = true;
+        } else {
+            result.motion = result.score >= options_.minArea;
+        }
+    }
+
+    result.width = width_;
+    result.height = height_;
+    result.decodeUs = std::chrono::duration<double, std::micro>(decoded - started).count();
+    result.elapsedUs = std::chrono::duration<double, std::micro>(
+        std::chrono::steady_clock::now() - started).count();
+
+    frames_++;
+    if (result.motion) motionFrames_++;
+    decodeUsTotal_ += static_cast<uint64_t>(result.decodeUs);
+    return true;
+}
+
+// process(jpeg: Buffer) -> Promise<result>, or null if the previous frame is still being analyzed
+Napi::Value MotionDetector::Process(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsBuffer()) {
+        Napi::TypeError::New(env, "JPEG Buffer expected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    if (busy_.exchange(true)) {
+        skipped_++;
+        return env.Null();
+    }
+
+    Napi::Buffer<uint8_t> buffer = info[0].As<Napi::Buffer<uint8_t>>();
+    std::vector<uint8_t> jpeg(buffer.Data(), buffer.Data() + buffer.Length());
+
+    MotionJob* job = new MotionJob(env, this, Value(), std::move(jpeg));
+    Napi::Promise promise = job->GetPromise();
+    job->Queue();
+    return promise;
+}
+
+// Re-learn the background from the next frame (e.g. after the gimbal moved)
+Napi::Value MotionDetector::Reset(const Napi::CallbackInfo& info) {
+    resetPending_ = true;
+    return info.Env().Undefined();
+}
+
+Napi::Value MotionDetector::GetStats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    uint64_t frames = frames_;
+
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("frames", static_cast<double>(frames));
+    obj.Set("skipped", static_cast<double>(skipped_));
+    obj.Set("motionFrames", static_cast<double>(motionFrames_));
+    obj.Set("avgDecodeUs", frames ? static_cast<double>(decodeUsTotal_) / frames : 0.0);
+    obj.Set("width", width_);
+    obj.Set("height", height_);
+    return obj;
+}
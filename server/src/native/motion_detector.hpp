@@ -0,0 +1,74 @@
+#pragma once
+
+#include <napi.h>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct MotionOptions {
+    int threshold = 20;         // luma difference counted as change
+    float minArea = 0.005f;     // changed fraction reported as motion
+    float maxArea = 0.6f;       // above this assume a lighting change and re-learn
+    int learnShift = 4;         // background learns 1/2^n of each frame
+};
+
+// Excluded region, normalized 0..1 so it is independent of resolution
+struct MotionMask {
+    float x, y, w, h;
+};
+
+struct MotionResult {
+    bool motion = false;
+    bool lightingChange = false;
+    float score = 0.0f;         // changed fraction of unmasked pixels
+    int width = 0;
+    int height = 0;
+    double decodeUs = 0;
+    double elapsedUs = 0;
+};
+
+// Motion detector for MJPEG frames. Each JPEG is decoded straight to 1/8
+// scale luma with libjpeg-turbo DCT scaling (only the DC coefficients are
+// used), then compared against an adaptive background with SSE2/NEON.
+// Frames are processed on the libuv pool, one at a time; frames arriving
+// while one is in flight are skipped.
+class MotionDetector : public Napi::ObjectWrap<MotionDetector> {
+public:
+    static Napi::Object Init(Napi::Env env, Napi::Object exports);
+
+    MotionDetector(const Napi::CallbackInfo& info);
+
+    // Worker thread
+    bool Analyze(const std::vector<uint8_t>& jpeg, MotionResult& result, std::string& error);
+    void Finish() { busy_ = false; }
+
+private:
+    static Napi::FunctionReference constructor;
+
+    MotionOptions options_;
+    std::vector<MotionMask> masks_;
+
+    // Model state, touched only by the single in-flight job
+    int width_ = 0;
+    int height_ = 0;
+    std::vector<uint8_t> luma_;
+    std::vector<int16_t> background_;   // luma << 4
+    std::vector<uint8_t> mask_;         // 0xFF = analyzed, 0 = masked out
+    size_t activePixels_ = 0;
+    bool hasBackground_ = false;
+    std::atomic<bool> resetPending_{false};
+
+    std::atomic<bool> busy_{false};
+    std::atomic<uint64_t> frames_{0};
+    std::atomic<uint64_t> skipped_{0};
+    std::atomic<uint64_t> motionFrames_{0};
+    std::atomic<uint64_t> decodeUsTotal_{0};
+
+    bool Decode(const std::vector<uint8_t>& jpeg, std::string& error);
+    void Resize(int width, int height);
+
+    Napi::Value Process(const Napi::CallbackInfo& info);
+    Napi::Value Reset(const Napi::CallbackInfo& info);
+    Napi::Value GetStats(const Napi::CallbackInfo& info);
+};
@@ -2,6 +2,17 @@
 #include <dev/devs.hpp>
 #include <dev/dev.hpp>
 #include "device_wrapper.hpp"
+#include "keyword_matcher.hpp"
+#include "vad.hpp"
+#ifdef OBSBOT_WITH_WHISPER
+#include "stt_worker.hpp"
+#endif
+#ifdef OBSBOT_WITH_JPEG
+#include "motion_detector.hpp"
+#endif
+#ifdef OBSBOT_WITH_GSTREAMER
+#include "gst_pipeline.hpp"
+#endif
 #include <thread>
 #include <chrono>
 #include <mutex>
@@ -222,6 +233,22 @@ Napi::Object CreateDeviceStatuses(Napi::Env env) {
 Napi::Object Init(Napi::Env env, Napi::Object exports) {
     // Initialize DeviceWrapper class
     DeviceWrapper::Init(env, exports);
+    KeywordMatcher::Init(env, exports);
+
+#ifdef OBSBOT_WITH_WHISPER
+    // Optional: only present when built against whisper.cpp (WHISPER_DIR)
+    SttWorker::Init(env, exports);
+#endif
+
+#ifdef OBSBOT_WITH_JPEG
+    // Optional: only present when libjpeg(-turbo) headers were found
+    MotionDetector::Init(env, exports);
+#endif
+
+#ifdef OBSBOT_WITH_GSTREAMER
+    // Optional: only present when GStreamer development files were found
+    CapturePipeline::Init(env, exports);
+#endif
 
     // Export functions
     exports.Set("initialize", Napi::Function::New(env, Initialize));
@@ -230,6 +257,7 @@ Napi::Object Init(Napi::Env env, Napi::Object exports) {
     exports.Set("getDevices", Napi::Function::New(env, GetDevices));
     exports.Set("getDeviceBySerialNumber", Napi::Function::New(env, GetDeviceBySerialNumber));
     exports.Set("waitForDevices", Napi::Function::New(env, WaitForDevices));
+    exports.Set("analyzeVoiceActivity", Napi::Function::New(env, AnalyzeVoiceActivity));
 
     // Export enums
     exports.Set("ProductTypes", CreateProductTypes(env));
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Fixed-capacity ring of mono float samples addressed by absolute sample
+// index, so readers can ask for "samples [from, to)" without tracking wrap.
+class PcmRing {
+public:
+    explicit PcmRing(size_t capacity) : buf_(capacity) {}
+
+    void Push(const float* samples, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            buf_[(end_ + i) % buf_.size()] = samples[i];
+        }
+        end_ += static_cast<int64_t>(count);
+    }
+
+    // Absolute index one past the newest sample
+    int64_t End() const { return end_; }
+
+    // Absolute index of the oldest sample still retained
+    int64_t Begin() const { return std::max<int64_t>(0, end_ - static_cast<int64_t>(buf_.size())); }
+
+    // Copy [from, to) into out, clamped to the retained range
+    void Copy(int64_t from, int64_t to, std::vector<float>& out) const {
+        from = std::max(from, Begin());
+        to = std::min(to, end_);
+        out.clear();
+        if (to <= from) return;
+        out.reserve(static_cast<size_t>(to - from));
+        for (int64_t i = from; i < to; i++) {
+            out.push_back(buf_[static_cast<size_t>(i % static_cast<int64_t>(buf_.size()))]);
+        }
+    }
+
+    void Clear() { end_ = 0; }
+
+private:
+    std::vector<float> buf_;
+    int64_t end_ = 0;
+};
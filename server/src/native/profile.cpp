@@ -0,0 +1,292 @@
+#include "profile.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+const char kMagic[4] = {'O', 'B', 'P', 'F'};
+
+enum Tag : uint8_t {
+    kBrightness = 1,
+    kContrast,
+    kSaturation,
+    kSharpness,
+    kHue,
+    kExposureMode,
+    kExposure,
+    kWhiteBalance,           // type, value
+    kHdr,
+    kFov,
+    kAntiFlicker,
+    kMirrorFlip,
+    kAiMode,                 // mode, sub-mode
+    kPresetList,             // empty; the preset list was captured (and may be empty)
+    kPreset,                 // one ProfilePosition
+    kBootPosition,
+};
+
+// Positions closer than this are the same; the firmware rounds what it stores
+constexpr float kAngleTolerance = 0.05f;
+constexpr float kZoomTolerance = 0.005f;
+constexpr size_t kMaxName = 63;
+
+class Writer {
+public:
+    std::vector<uint8_t> bytes;
+
+    void Record(Tag tag, const std::vector<uint8_t>& payload) {
+        bytes.push_back(tag);
+        bytes.push_back(static_cast<uint8_t>(payload.size()));
+        bytes.insert(bytes.end(), payload.begin(), payload.end());
+    }
+    void Int(Tag tag, const std::optional<int32_t>& value) {
+        if (!value) return;
+        std::vector<uint8_t> payload;
+        PutInt(payload, *value);
+        Record(tag, payload);
+    }
+    void Pair(Tag tag, const std::optional<int32_t>& a, const std::optional<int32_t>& b) {
+        if (!a) return;
+        std::vector<uint8_t> payload;
+        PutInt(payload, *a);
+        PutInt(payload, b.value_or(0));
+        Record(tag, payload);
+    }
+    void Position(Tag tag, const ProfilePosition& pos) {
+        std::vector<uint8_t> payload;
+        PutInt(payload, pos.id);
+        for (float f : {pos.pitch, pos.yaw, pos.roll, pos.zoom}) {
+            uint32_t bits;
+            std::memcpy(&bits, &f, sizeof bits);
+            PutInt(payload, static_cast<int32_t>(bits));
+        }
+        const size_t n = std::min(pos.name.size(), kMaxName);
+        payload.insert(payload.end(), pos.name.begin(), pos.name.begin() + n);
+        Record(tag, payload);
+    }
+
+    static void PutInt(std::vector<uint8_t>& out, int32_t value) {
+        const uint32_t v = static_cast<uint32_t>(value);
+        for (int i = 0; i < 4; i++) out.push_back(static_cast<uint8_t>(v >> (8 * i)));
+    }
+};
+
+int32_t GetInt(const uint8_t* p) {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++) v |= static_cast<uint32_t>(p[i]) << (8 * i);
+    return static_cast<int32_t>(v);
+}
+
+float GetFloat(const uint8_t* p) {
+    const uint32_t bits = static_cast<uint32_t>(GetInt(p));
+    float f;
+    std::memcpy(&f, &bits, sizeof f);
+    return f;
+}
+
+bool ReadPosition(const uint8_t* p, size_t len, ProfilePosition& pos) {
+    if (len < 20) return false;
+    pos.id = GetInt(p);
+    pos.pitch = GetFloat(p + 4);
+    pos.yaw = GetFloat(p + 8);
+    pos.roll = GetFloat(p + 12);
+    pos.zoom = GetFloat(p + 16);
+    pos.name.assign(reinterpret_cast<const char*>(p + 20), len - 20);
+    return true;
+}
+
+ProfilePosition FromPreset(const Device::PresetPosInfo& info) {
+    ProfilePosition pos;
+    pos.id = info.id;
+    pos.pitch = info.pitch;
+    pos.yaw = info.yaw;
+    pos.roll = info.roll;
+    pos.zoom = info.zoom;
+    pos.name.assign(info.name, strnlen(info.name, sizeof info.name));
+    return pos;
+}
+
+}  // namespace
+
+Device::PresetPosInfo ToPresetInfo(const ProfilePosition& pos) {
+    Device::PresetPosInfo info = {};
+    info.id = pos.id;
+    info.pitch = pos.pitch;
+    info.yaw = pos.yaw;
+    info.roll = pos.roll;
+    info.zoom = pos.zoom;
+    const size_t n = std::min(pos.name.size(), kMaxName);
+    std::memcpy(info.name, pos.name.data(), n);
+    info.name_len = static_cast<int32_t>(n);
+    return info;
+}
+
+bool ProfilePosition::operator==(const ProfilePosition& other) const {
+    return id == other.id && name == other.name &&
+           std::fabs(pitch - other.pitch) < kAngleTolerance &&
+           std::fabs(yaw - other.yaw) < kAngleTolerance &&
+           std::fabs(roll - other.roll) < kAngleTolerance &&
+           std::fabs(zoom - other.zoom) < kZoomTolerance;
+}
+
+std::vector<uint8_t> EncodeProfile(const Profile& profile) {
+    Writer w;
+    w.bytes.assign(kMagic, kMagic + sizeof kMagic);
+    w.bytes.push_back(kProfileVersion);
+    w.bytes.push_back(static_cast<uint8_t>(profile.productType));
+
+    w.Int(kBrightness, profile.brightness);
+    w.Int(kContrast, profile.contrast);
+    w.Int(kSaturation, profile.saturation);
+    w.Int(kSharpness, profile.sharpness);
+    w.Int(kHue, profile.hue);
+    w.Int(kExposureMode, profile.exposureMode);
+    w.Int(kExposure, profile.exposure);
+    w.Pair(kWhiteBalance, profile.wbType, profile.wbValue);
+    w.Int(kHdr, profile.hdr);
+    w.Int(kFov, profile.fov);
+    w.Int(kAntiFlicker, profile.antiFlicker);
+    w.Int(kMirrorFlip, profile.mirrorFlip);
+    w.Pair(kAiMode, profile.aiMode, profile.aiSubMode);
+    if (profile.presets) {
+        w.Record(kPresetList, {});
+        for (const ProfilePosition& preset : *profile.presets) {
+            w.Position(kPreset, preset);
+        }
+    }
+    if (profile.bootPosition) {
+        w.Position(kBootPosition, *profile.bootPosition);
+    }
+    return std::move(w.bytes);
+}
+
+bool DecodeProfile(const uint8_t* data, size_t size, Profile& profile, std::string& error) {
+    if (size < 6 || std::memcmp(data, kMagic, sizeof kMagic) != 0) {
+        error = "Not a camera profile";
+        return false;
+    }
+    if (data[4] > kProfileVersion) {
+        error = "Profile version " + std::to_string(data[4]) + " is newer than this server reads";
+        return false;
+    }
+    profile = Profile();
+    profile.productType = data[5];
+
+    size_t at = 6;
+    while (at < size) {
+        if (size - at < 2 || size - at - 2 < data[at + 1]) {
+            error = "Truncated profile";
+            return false;
+        }
+        const uint8_t tag = data[at];
+        const size_t len = data[at + 1];
+        const uint8_t* p = data + at + 2;
+        at += 2 + len;
+
+        std::optional<int32_t>* single = nullptr;
+        switch (tag) {
+            case kBrightness: single = &profile.brightness; break;
+            case kContrast: single = &profile.contrast; break;
+            case kSaturation: single = &profile.saturation; break;
+            case kSharpness: single = &profile.sharpness; break;
+            case kHue: single = &profile.hue; break;
+            case kExposureMode: single = &profile.exposureMode; break;
+            case kExposure: single = &profile.exposure; break;
+            case kHdr: single = &profile.hdr; break;
+            case kFov: single = &profile.fov; break;
+            case kAntiFlicker: single = &profile.antiFlicker; break;
+            case kMirrorFlip: single = &profile.mirrorFlip; break;
+            case kWhiteBalance:
+                if (len < 8) break;
+                profile.wbType = GetInt(p);
+                profile.wbValue = GetInt(p + 4);
+                break;
+            case kAiMode:
+                if (len < 8) break;
+                profile.aiMode = GetInt(p);
+                profile.aiSubMode = GetInt(p + 4);
+                break;
+            case kPresetList:
+                if (!profile.presets) profile.presets.emplace();
+                break;
+            case kPreset: {
+                ProfilePosition pos;
+                if (!ReadPosition(p, len, pos)) break;
+                if (!profile.presets) profile.presets.emplace();
+                profile.presets->push_back(pos);
+                break;
+            }
+            case kBootPosition: {
+                ProfilePosition pos;
+                if (ReadPosition(p, len, pos)) profile.bootPosition = pos;
+                break;
+            }
+            default:
+                break;           // written by a newer build
+        }
+        if (single && len >= 4) *single = GetInt(p);
+    }
+    return true;
+}
+
+Profile ReadProfile(Device& device, bool tinySeries) {
+    Profile profile;
+    profile.productType = static_cast<int>(device.productType());
+
+    auto read = [&device](std::optional<int32_t>& out, int32_t (Device::*get)(int32_t&)) {
+        int32_t value;
+        if ((device.*get)(value) == 0) out = value;
+    };
+    read(profile.brightness, &Device::cameraGetImageBrightnessR);
+    read(profile.contrast, &Device::cameraGetImageContrastR);
+    read(profile.saturation, &Device::cameraGetImageSaturationR);
+    read(profile.sharpness, &Device::cameraGetImageSharpR);
+    read(profile.hue, &Device::cameraGetImageHueR);
+    read(profile.exposureMode, &Device::cameraGetExposureModeR);
+    read(profile.hdr, &Device::cameraGetWdrR);
+    read(profile.antiFlicker, &Device::cameraGetAntiFlickR);
+    read(profile.mirrorFlip, &Device::cameraGetMirrorFlipR);
+
+    int32_t shutter;
+    bool autoExposure;
+    if (device.cameraGetExposureAbsolute(shutter, autoExposure) == 0 && !autoExposure) {
+        profile.exposure = shutter;
+    }
+
+    Device::DevWhiteBalanceType wbType;
+    int32_t wbValue;
+    if (device.cameraGetWhiteBalanceR(wbType, wbValue) == 0) {
+        profile.wbType = static_cast<int32_t>(wbType);
+        profile.wbValue = wbValue;
+    }
+
+    // FOV and AI mode have no getters; the tiny series reports them in its status
+    Device::CameraStatus status;
+    if (tinySeries && device.cameraGetCameraStatusU(status) == 0) {
+        profile.fov = status.tiny.fov;
+        profile.aiMode = status.tiny.ai_mode;
+        profile.aiSubMode = status.tiny.ai_sub_mode;
+    }
+
+    Device::DevDataArray ids;
+    if (device.aiGetGimbalPresetListR(&ids) == 0) {
+        profile.presets.emplace();
+        for (int32_t i = 0; i < ids.len; i++) {
+            Device::PresetPosInfo info = {};
+            if (device.aiGetGimbalPresetInfoWithIdR(&info, ids.data_int32[i]) != 0) {
+                // A partial list would have restore delete the presets it missed
+                profile.presets.reset();
+                break;
+            }
+            profile.presets->push_back(FromPreset(info));
+        }
+    }
+
+    Device::PresetPosInfo boot = {};
+    if (device.aiGetGimbalBootPosR(&boot) == 0) {
+        profile.bootPosition = FromPreset(boot);
+        profile.bootPosition->id = 0;
+    }
+    return profile;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <dev/dev.hpp>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+// A gimbal preset or the boot position
+struct ProfilePosition {
+    int32_t id = 0;
+    float pitch = 0, yaw = 0, roll = 0, zoom = 0;
+    std::string name;
+
+    bool operator==(const ProfilePosition& other) const;
+    bool operator!=(const ProfilePosition& other) const { return !(*this == other); }
+};
+
+// A camera's configuration. Fields the camera didn't report when captured
+// are unset, and restoring leaves them alone.
+struct Profile {
+    int productType = 0;
+    std::optional<int32_t> brightness, contrast, saturation, sharpness, hue;
+    std::optional<int32_t> exposureMode;
+    std::optional<int32_t> exposure;                 // manual exposure only
+    std::optional<int32_t> wbType, wbValue;
+    std::optional<int32_t> hdr, fov, antiFlicker, mirrorFlip;
+    std::optional<int32_t> aiMode, aiSubMode;
+    std::optional<std::vector<ProfilePosition>> presets;
+    std::optional<ProfilePosition> bootPosition;
+};
+
+// Blob layout: "OBPF", format version (u8), product type (u8), then records of
+// tag (u8), length (u8) and that many bytes of little-endian payload. Readers
+// skip tags they don't know, so fields can be added without a new version.
+constexpr uint8_t kProfileVersion = 1;
+
+std::vector<uint8_t> EncodeProfile(const Profile& profile);
+// False, with error set, if the blob is not a profile this build can read
+bool DecodeProfile(const uint8_t* data, size_t size, Profile& profile, std::string& error);
+// Read the live configuration; blocks on the device, so call it off the JS thread.
+// FOV and AI mode are only read from the tiny series' status.
+Profile ReadProfile(Device& device, bool tinySeries);
+Device::PresetPosInfo ToPresetInfo(const ProfilePosition& pos);
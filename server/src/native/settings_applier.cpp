@@ -0,0 +1,468 @@
+#include "settings_applier.hpp"
+#include "worker_support.hpp"
+#include "warm_up.hpp"
+#include <algorithm>
+#include <chrono>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double MsSince(Clock::time_point start, Clock::time_point now) {
+    return std::chrono::duration<double, std::milli>(now - start).count();
+}
+
+// Resolve or reject a finished batch on the JS thread
+void SettleBatch(Napi::Env env, Napi::Function, SettingsJob* job) {
+    if (job->closed) {
+        job->deferred.Reject(Napi::Error::New(env, "Device closed").Value());
+        delete job;
+        return;
+    }
+    if (job->kind == SettingsJob::Kind::Capture) {
+        const std::vector<uint8_t>& blob = job->blob;
+        job->deferred.Resolve(Napi::Buffer<uint8_t>::Copy(env, blob.data(), blob.size()));
+        delete job;
+        return;
+    }
+    if (job->kind == SettingsJob::Kind::ReadState) {
+        Napi::Object state = Napi::Object::New(env);
+        state.Set("status", CameraStatusObject(env, job->productType,
+                                               job->status ? &*job->status : nullptr,
+                                               job->ai ? &*job->ai : nullptr));
+        state.Set("zoom", job->zoom ? Napi::Number::New(env, *job->zoom) : env.Null());
+        state.Set("gimbal", job->gimbal ? Napi::Value(GimbalStateObject(env, *job->gimbal))
+                                        : env.Null());
+        job->deferred.Resolve(state);
+        delete job;
+        return;
+    }
+
+    bool ok = true;
+    Napi::Object results = Napi::Object::New(env);
+    for (const SettingResult& r : job->results) {
+        Napi::Object field = Napi::Object::New(env);
+        field.Set("result", r.result);
+        if (r.error.empty()) {
+            field.Set("elided", r.elided);
+        } else {
+            field.Set("error", r.error);
+        }
+        results.Set(r.field, field);
+        ok = ok && r.result == 0 && r.error.empty();
+    }
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("ok", ok);
+    result.Set("elapsedMs", job->elapsedMs);
+    result.Set("results", results);
+    if (job->kind == SettingsJob::Kind::Restore) {
+        result.Set("unchanged", job->unchanged);
+        result.Set("otherProduct", job->otherProduct);
+    }
+    job->deferred.Resolve(result);
+    delete job;
+}
+
+}  // namespace
+
+SettingsApplier::SettingsApplier(Napi::Env env, std::shared_ptr<Device> device,
+                                 ShadowRegisters& shadow, CapabilityCache& caps,
+                                 bool tinySeries)
+    : device_(std::move(device)), shadow_(shadow), caps_(caps), tinySeries_(tinySeries) {
+    tsfn_ = MakeResultTsfn(env, "SettingsApplierResult");
+
+    thread_ = std::thread(&SettingsApplier::Run, this);
+}
+
+SettingsApplier::~SettingsApplier() {
+    std::deque<std::unique_ptr<SettingsJob>> dropped;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        dropped.swap(queue_);
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+
+    for (auto& job : dropped) {
+        job->closed = true;
+        tsfn_.NonBlockingCall(job.release(), SettleBatch);
+    }
+    tsfn_.Release();
+}
+
+Napi::Promise SettingsApplier::Apply(Napi::Env env, const SettingsRequest& request) {
+    auto job = std::make_unique<SettingsJob>(env);
+    job->request = request;
+    return Enqueue(std::move(job));
+}
+
+Napi::Promise SettingsApplier::Capture(Napi::Env env) {
+    auto job = std::make_unique<SettingsJob>(env);
+    job->kind = SettingsJob::Kind::Capture;
+    return Enqueue(std::move(job));
+}
+
+Napi::Promise SettingsApplier::ReadState(Napi::Env env) {
+    auto job = std::make_unique<SettingsJob>(env);
+    job->kind = SettingsJob::Kind::ReadState;
+    return Enqueue(std::move(job));
+}
+
+Napi::Promise SettingsApplier::Restore(Napi::Env env, const Profile& profile) {
+    auto job = std::make_unique<SettingsJob>(env);
+    job->kind = SettingsJob::Kind::Restore;
+    job->profile = profile;
+    return Enqueue(std::move(job));
+}
+
+Napi::Promise SettingsApplier::Enqueue(std::unique_ptr<SettingsJob> job) {
+    Napi::Promise promise = job->deferred.Promise();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.push_back(std::move(job));
+    }
+    cv_.notify_all();
+    return promise;
+}
+
+Napi::Object SettingsApplier::Stats(Napi::Env env) {
+    Napi::Object obj = Napi::Object::New(env);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        obj.Set("queued", static_cast<double>(queue_.size()));
+    }
+    obj.Set("batches", batches_.load());
+    obj.Set("writes", writes_.load());
+    obj.Set("elided", elided_.load());
+    obj.Set("rejected", rejected_.load());
+    obj.Set("lastBatchMs", lastBatchMs_.load());
+    return obj;
+}
+
+void SettingsApplier::Run() {
+    while (true) {
+        std::unique_ptr<SettingsJob> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+            if (stopping_) return;
+            job = std::move(queue_.front());
+            queue_.pop_front();
+        }
+
+        const Clock::time_point start = Clock::now();
+        switch (job->kind) {
+            case SettingsJob::Kind::Apply:
+                Execute(*job);
+                break;
+            case SettingsJob::Kind::Capture:
+                job->blob = EncodeProfile(ReadProfile(*device_, tinySeries_));
+                break;
+            case SettingsJob::Kind::Restore:
+                RestoreProfile(*job);
+                break;
+            case SettingsJob::Kind::ReadState:
+                ReadLiveState(*job);
+                break;
+        }
+        job->elapsedMs = MsSince(start, Clock::now());
+        if (job->kind != SettingsJob::Kind::ReadState) {
+            batches_++;
+            lastBatchMs_ = job->elapsedMs;
+        }
+        tsfn_.NonBlockingCall(job.release(), SettleBatch);
+    }
+}
+
+void SettingsApplier::Execute(SettingsJob& job) {
+    const SettingsRequest& req = job.request;
+    const std::shared_ptr<Device> device = device_;
+
+    // Sensor modes first: a FOV or HDR change can reset the image pipeline
+    if (req.fov) {
+        const int32_t v = *req.fov;
+        Write(job, "fov", Register::Fov, {double(v)}, [device, v] {
+            return device->cameraSetFovU(static_cast<Device::FovType>(v));
+        });
+    }
+    if (req.hdr) {
+        const int32_t v = *req.hdr;
+        Write(job, "hdr", Register::Hdr, {double(v)}, [device, v] {
+            return device->cameraSetWdrR(v);
+        });
+    }
+    if (req.antiFlicker &&
+        InRange(job, "antiFlicker", "antiFlicker", *req.antiFlicker)) {
+        const int32_t v = *req.antiFlicker;
+        Write(job, "antiFlicker", Register::AntiFlicker, {double(v)}, [device, v] {
+            return device->cameraSetAntiFlickR(v);
+        });
+    }
+    if (req.mirrorFlip) {
+        const int32_t v = *req.mirrorFlip;
+        Write(job, "mirrorFlip", Register::MirrorFlip, {double(v)}, [device, v] {
+            return device->cameraSetMirrorFlipR(v);
+        });
+    }
+
+    // The exposure value only holds in the mode it was set for
+    bool exposureModeFailed = false;
+    if (req.exposureMode) {
+        const int32_t v = *req.exposureMode;
+        shadow_.Invalidate(Register::Exposure);
+        const int32_t r = Write(job, "exposure.mode", Register::ExposureMode, {double(v)},
+            [device, v] { return device->cameraSetExposureModeR(v); });
+        exposureModeFailed = r != 0;
+    }
+    if (req.exposure) {
+        if (exposureModeFailed) {
+            Skip(job, "exposure.value", "exposure.mode failed");
+        } else if (InRange(job, "exposure.value", "exposure", *req.exposure)) {
+            const int32_t v = *req.exposure;
+            shadow_.Invalidate(Register::ExposureMode);
+            Write(job, "exposure.value", Register::Exposure, {double(v)}, [device, v] {
+                return device->cameraSetExposureAbsolute(v, false);
+            });
+        }
+    }
+    if (req.aeLock) {
+        shadow_.Invalidate(Register::Exposure);
+        const int32_t r = device->cameraSetAELockR(*req.aeLock);
+        job.results.push_back({"exposure.aeLock", r, false, ""});
+        writes_++;
+    }
+
+    if (req.wbType || req.wbValue) {
+        // A value alone means manual white balance; manual without a value
+        // keeps the temperature the camera is at
+        const int32_t type = req.wbType.value_or(Device::DevWhiteBalanceManual);
+        const bool manual = type == Device::DevWhiteBalanceManual;
+        std::optional<int32_t> param = req.wbValue;
+        if (manual && !param) {
+            Device::DevWhiteBalanceType currentType;
+            int32_t current;
+            const auto known = shadow_.Known(Register::WhiteBalance);
+            if (known && known->a == Device::DevWhiteBalanceManual) {
+                param = static_cast<int32_t>(known->b);
+            } else if (device->cameraGetWhiteBalanceR(currentType, current) == 0) {
+                param = current;
+            }
+        }
+        if (manual && !param) {
+            Skip(job, "wb", "wb.value needed, current value unreadable");
+        } else if (!manual || InRange(job, "wb", "whiteBalance", *param)) {
+            const int32_t value = param.value_or(0);
+            Write(job, "wb", Register::WhiteBalance, {double(type), double(value)},
+                [device, type, value] {
+                    return device->cameraSetWhiteBalanceR(
+                        static_cast<Device::DevWhiteBalanceType>(type), value);
+                });
+        }
+    }
+
+    struct ImageSetting {
+        const char* field;
+        const std::optional<int32_t>& value;
+        Register reg;
+        int32_t (Device::*set)(int32_t);
+    };
+    const ImageSetting image[] = {
+        {"brightness", req.brightness, Register::Brightness, &Device::cameraSetImageBrightnessR},
+        {"contrast", req.contrast, Register::Contrast, &Device::cameraSetImageContrastR},
+        {"saturation", req.saturation, Register::Saturation, &Device::cameraSetImageSaturationR},
+        {"sharpness", req.sharpness, Register::Sharpness, &Device::cameraSetImageSharpR},
+        {"hue", req.hue, Register::Hue, &Device::cameraSetImageHueR},
+    };
+    for (const ImageSetting& s : image) {
+        if (!s.value || !InRange(job, s.field, s.field, *s.value)) continue;
+        const int32_t v = *s.value;
+        const auto set = s.set;
+        Write(job, s.field, s.reg, {double(v)}, [device, set, v] { return ((*device).*set)(v); });
+    }
+
+    // Manual focus only sticks once autofocus is off
+    bool focusModeFailed = false;
+    if (req.focusMode) {
+        shadow_.Invalidate(Register::Focus);
+        const int32_t r = device->cameraSetAutoFocusModeR(
+            static_cast<Device::DevAutoFocusType>(*req.focusMode));
+        job.results.push_back({"focus.mode", r, false, ""});
+        writes_++;
+        focusModeFailed = r != 0;
+    }
+    if (req.focus) {
+        if (focusModeFailed) {
+            Skip(job, "focus.value", "focus.mode failed");
+        } else if (InRange(job, "focus.value", "focus", *req.focus)) {
+            const int32_t v = *req.focus;
+            Write(job, "focus.value", Register::Focus, {double(v)}, [device, v] {
+                return device->cameraSetFocusAbsolute(v, false);
+            });
+        }
+    }
+}
+
+void SettingsApplier::ReadLiveState(SettingsJob& job) {
+    // A full read starts the shadow over. Zoom is read again below, and stays
+    // known meanwhile for the status stream.
+    for (size_t i = 0; i < static_cast<size_t>(Register::Count); i++) {
+        const Register reg = static_cast<Register>(i);
+        if (reg != Register::Zoom) shadow_.Invalidate(reg);
+    }
+    job.productType = device_->productType();
+    if (tinySeries_) {
+        Device::CameraStatus status;
+        // Fall back to the last pushed status if the query fails
+        if (device_->cameraGetCameraStatusU(status) != 0) status = device_->cameraStatus();
+        job.status = status;
+    }
+    Device::AiStatus ai;
+    if (device_->aiGetAiStatusR(&ai) == 0) job.ai = ai;
+    float zoom;
+    if (device_->cameraGetZoomAbsoluteR(zoom) == 0) {
+        shadow_.Observe(Register::Zoom, {zoom});
+        job.zoom = zoom;
+    }
+    Device::AiGimbalStateInfo gimbal;
+    if (device_->aiGetGimbalStateR(&gimbal) == 0) job.gimbal = gimbal;
+}
+
+void SettingsApplier::RestoreProfile(SettingsJob& job) {
+    Profile want = job.profile;
+    const Profile live = ReadProfile(*device_, tinySeries_);
+    const std::shared_ptr<Device> device = device_;
+
+    // FOV and AI mode values, preset ids and gimbal angles mean something
+    // else on another product: skip them, restore only the common settings
+    if (want.productType != static_cast<int>(device_->productType())) {
+        job.otherProduct = true;
+        const std::string error =
+            "Captured on another product (type " + std::to_string(want.productType) + ")";
+        auto skip = [&](const char* field, auto& value) {
+            if (!value) return;
+            Skip(job, field, error);
+            value.reset();
+        };
+        skip("fov", want.fov);
+        skip("aiMode", want.aiMode);
+        want.aiSubMode.reset();
+        skip("presets", want.presets);
+        skip("bootPosition", want.bootPosition);
+    }
+
+    // Settings Execute knows how to order: queue the ones that differ
+    SettingsRequest& req = job.request;
+    auto diff = [&job](const std::optional<int32_t>& target, const std::optional<int32_t>& current,
+                       std::optional<int32_t>& out) {
+        if (!target) return;
+        if (current == target) {
+            job.unchanged++;
+        } else {
+            out = target;
+        }
+    };
+    diff(want.fov, live.fov, req.fov);
+    diff(want.hdr, live.hdr, req.hdr);
+    diff(want.antiFlicker, live.antiFlicker, req.antiFlicker);
+    diff(want.mirrorFlip, live.mirrorFlip, req.mirrorFlip);
+    diff(want.exposureMode, live.exposureMode, req.exposureMode);
+    diff(want.exposure, live.exposure, req.exposure);
+    diff(want.brightness, live.brightness, req.brightness);
+    diff(want.contrast, live.contrast, req.contrast);
+    diff(want.saturation, live.saturation, req.saturation);
+    diff(want.sharpness, live.sharpness, req.sharpness);
+    diff(want.hue, live.hue, req.hue);
+    if (want.wbType) {
+        // The value only matters for manual white balance
+        const bool manual = *want.wbType == Device::DevWhiteBalanceManual;
+        if (live.wbType == want.wbType && (!manual || live.wbValue == want.wbValue)) {
+            job.unchanged++;
+        } else {
+            req.wbType = want.wbType;
+            req.wbValue = want.wbValue;
+        }
+    }
+    Execute(job);
+
+    // Presets: update or add the profile's, delete the ones it doesn't have.
+    // Left alone if either list couldn't be read in full.
+    if (want.presets && live.presets) {
+        auto byId = [](int32_t id) {
+            return [id](const ProfilePosition& p) { return p.id == id; };
+        };
+        for (const ProfilePosition& preset : *want.presets) {
+            auto it = std::find_if(live.presets->begin(), live.presets->end(), byId(preset.id));
+            if (it != live.presets->end() && *it == preset) {
+                job.unchanged++;
+                continue;
+            }
+            Device::PresetPosInfo info = ToPresetInfo(preset);
+            const int32_t r = it != live.presets->end() ? device->aiUpdGimbalPresetR(&info)
+                                                         : device->aiAddGimbalPresetR(&info);
+            job.results.push_back({"presets." + std::to_string(preset.id), r, false, ""});
+            writes_++;
+        }
+        for (const ProfilePosition& preset : *live.presets) {
+            if (std::any_of(want.presets->begin(), want.presets->end(), byId(preset.id))) continue;
+            const int32_t r = device->aiDelGimbalPresetR(preset.id);
+            job.results.push_back({"presets." + std::to_string(preset.id), r, false, ""});
+            writes_++;
+        }
+    }
+
+    if (want.bootPosition) {
+        if (live.bootPosition == want.bootPosition) {
+            job.unchanged++;
+        } else {
+            const int32_t r = device->aiSetGimbalBootPosR(ToPresetInfo(*want.bootPosition));
+            job.results.push_back({"bootPosition", r, false, ""});
+            writes_++;
+        }
+    }
+
+    // Last, so tracking doesn't start while the rest is still being written
+    if (want.aiMode) {
+        if (live.aiMode == want.aiMode && live.aiSubMode == want.aiSubMode) {
+            job.unchanged++;
+        } else {
+            shadow_.Invalidate(Register::Zoom);
+            const int32_t r = device->cameraSetAiModeU(
+                static_cast<Device::AiWorkModeType>(*want.aiMode), want.aiSubMode.value_or(0));
+            job.results.push_back({"aiMode", r, false, ""});
+            writes_++;
+        }
+    }
+}
+
+bool SettingsApplier::InRange(SettingsJob& job, const char* field, const char* range,
+                              int32_t value) {
+    const std::optional<Device::UvcParamRange> limits = caps_.Range(range);
+    // Not reported: let the camera decide
+    if (!limits || (value >= limits->min_ && value <= limits->max_)) return true;
+    Skip(job, field, "out of range " + std::to_string(limits->min_) + ".." +
+                         std::to_string(limits->max_));
+    return false;
+}
+
+int32_t SettingsApplier::Write(SettingsJob& job, const char* field, Register reg,
+                               const RegisterValue& value, ShadowRegisters::Writer write) {
+    bool elided = false;
+    const int32_t result = shadow_.WriteNow(reg, value, std::move(write), &elided);
+    job.results.push_back({field, result, elided, ""});
+    if (elided) {
+        elided_++;
+    } else {
+        writes_++;
+    }
+    return result;
+}
+
+void SettingsApplier::Skip(SettingsJob& job, const char* field, const std::string& error) {
+    job.results.push_back({field, -1, false, error});
+    rejected_++;
+}
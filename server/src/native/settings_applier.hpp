@@ -0,0 +1,117 @@
+#pragma once
+
+#include <napi.h>
+#include <dev/dev.hpp>
+#include "capability_cache.hpp"
+#include "profile.hpp"
+#include "shadow_registers.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Settings to apply in one batch. Unset fields are left alone.
+struct SettingsRequest {
+    std::optional<int32_t> fov, hdr, antiFlicker, mirrorFlip;
+    std::optional<int32_t> exposureMode, exposure;
+    std::optional<bool> aeLock;
+    std::optional<int32_t> wbType, wbValue;
+    std::optional<int32_t> brightness, contrast, saturation, sharpness, hue;
+    std::optional<int32_t> focusMode, focus;
+};
+
+struct SettingResult {
+    std::string field;               // as named in applySettings, e.g. "exposure.mode"
+    int32_t result = 0;
+    bool elided = false;             // the camera already held the value
+    std::string error;               // rejected or skipped before reaching the camera
+};
+
+struct SettingsJob {
+    enum class Kind { Apply, Capture, Restore, ReadState };
+
+    Kind kind = Kind::Apply;
+    SettingsRequest request;         // Apply; Restore fills in the fields that differ
+    Profile profile;                 // Restore
+    Napi::Promise::Deferred deferred;
+
+    // Results, filled in by the applier thread
+    std::vector<SettingResult> results;
+    std::vector<uint8_t> blob;       // Capture
+    int unchanged = 0;               // Restore: fields that already matched
+    bool otherProduct = false;       // Restore: captured on another product
+    // ReadState: what the status stream shows; unset when the read failed
+    ObsbotProductType productType = ObsbotProductType{};
+    std::optional<Device::CameraStatus> status;
+    std::optional<Device::AiStatus> ai;
+    std::optional<float> zoom;
+    std::optional<Device::AiGimbalStateInfo> gimbal;
+    double elapsedMs = 0;
+    bool closed = false;             // dropped unapplied when the device went away
+
+    explicit SettingsJob(Napi::Env env) : deferred(Napi::Promise::Deferred::New(env)) {}
+};
+
+// Applies batches of camera settings on a dedicated thread, so a whole look
+// costs the JS thread one call and one Promise instead of a blocking USB
+// round trip per setting. Writes go out in dependency order (FOV and HDR
+// first, exposure mode before the exposure value, focus mode before focus)
+// and through the shadow registers, so values the camera already holds are
+// skipped. Values are checked against the device's ranges from the
+// capability cache. Batches run one after another in the order submitted.
+// Profile capture and restore run as jobs on the same thread, so a restore
+// is one job however many fields it touches, and so do the status stream's
+// state reads, which then never block the JS thread.
+class SettingsApplier {
+public:
+    SettingsApplier(Napi::Env env, std::shared_ptr<Device> device, ShadowRegisters& shadow,
+                    CapabilityCache& caps, bool tinySeries);
+    ~SettingsApplier();
+
+    // Resolves { ok, elapsedMs, results: { [field]: { result, elided } | { result, error } } }
+    Napi::Promise Apply(Napi::Env env, const SettingsRequest& request);
+    // Resolves the live configuration as a profile blob (Buffer)
+    Napi::Promise Capture(Napi::Env env);
+    // Resolves { status, zoom, gimbal }, shaped as getCameraStatus, getZoom and getGimbalState
+    Napi::Promise ReadState(Napi::Env env);
+    // Reads the live configuration and writes only the fields that differ from
+    // profile; resolves like Apply, plus { unchanged }
+    Napi::Promise Restore(Napi::Env env, const Profile& profile);
+    Napi::Object Stats(Napi::Env env);
+
+private:
+    std::shared_ptr<Device> device_;
+    ShadowRegisters& shadow_;
+    CapabilityCache& caps_;
+    bool tinySeries_;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::unique_ptr<SettingsJob>> queue_;
+    bool stopping_ = false;
+    Napi::ThreadSafeFunction tsfn_;
+
+    // Stats
+    std::atomic<int> batches_{0};
+    std::atomic<int> writes_{0};
+    std::atomic<int> elided_{0};
+    std::atomic<int> rejected_{0};
+    std::atomic<double> lastBatchMs_{0};
+
+    void Run();
+    Napi::Promise Enqueue(std::unique_ptr<SettingsJob> job);
+    void Execute(SettingsJob& job);
+    void RestoreProfile(SettingsJob& job);
+    void ReadLiveState(SettingsJob& job);
+    // Checks a field's value against its range, recording it as rejected if outside
+    bool InRange(SettingsJob& job, const char* field, const char* range, int32_t value);
+    int32_t Write(SettingsJob& job, const char* field, Register reg, const RegisterValue& value,
+                  ShadowRegisters::Writer write);
+    void Skip(SettingsJob& job, const char* field, const std::string& error);
+};
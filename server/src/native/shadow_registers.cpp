@@ -0,0 +1,219 @@
+#include "shadow_registers.hpp"
+#include <algorithm>
+
+ShadowRegisters::ShadowRegisters() {
+    thread_ = std::thread(&ShadowRegisters::Run, this);
+}
+
+ShadowRegisters::~ShadowRegisters() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+
+    // The last value of a slider still counts
+    for (Entry& entry : entries_) {
+        if (entry.pending && entry.pendingWrite) {
+            entry.pendingWrite();
+        }
+    }
+}
+
+void ShadowRegisters::Configure(int windowMs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    windowMs_ = std::max(windowMs, 0);
+}
+
+int32_t ShadowRegisters::Write(Register reg, const RegisterValue& value, Writer write) {
+    Entry& entry = entries_[static_cast<size_t>(reg)];
+    unsigned generation;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (Fresh(entry, Clock::now()) && !entry.inFlight && entry.value == value) {
+            // Back to the value that holds: a queued write is moot too
+            if (entry.pending) {
+                entry.pending = false;
+                entry.pendingWrite = nullptr;
+                coalesced_++;
+            }
+            hits_++;
+            return 0;
+        }
+
+        const Clock::time_point now = Clock::now();
+        if (entry.pending || entry.inFlight ||
+            now - entry.lastWrite < std::chrono::milliseconds(windowMs_)) {
+            if (entry.pending) coalesced_++;
+            entry.pending = true;
+            entry.pendingValue = value;
+            entry.pendingWrite = std::move(write);
+            cv_.notify_all();
+            return kQueued;
+        }
+        entry.lastWrite = now;
+        entry.inFlight = true;
+        generation = entry.generation;
+    }
+
+    int32_t result = 0;
+    Send(entry, value, write, generation, &result);
+    return result;
+}
+
+int32_t ShadowRegisters::WriteNow(Register reg, const RegisterValue& value, Writer write,
+                                  bool* elided) {
+    Entry& entry = entries_[static_cast<size_t>(reg)];
+    unsigned generation;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [&entry] { return !entry.inFlight; });
+        if (entry.pending) {
+            entry.pending = false;
+            entry.pendingWrite = nullptr;
+            coalesced_++;
+        }
+        *elided = Fresh(entry, Clock::now()) && entry.value == value;
+        if (*elided) {
+            hits_++;
+            return 0;
+        }
+        entry.lastWrite = Clock::now();
+        entry.inFlight = true;
+        generation = entry.generation;
+    }
+
+    int32_t result = 0;
+    Send(entry, value, write, generation, &result);
+    return result;
+}
+
+void ShadowRegisters::Observe(Register reg, const RegisterValue& value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry& entry = entries_[static_cast<size_t>(reg)];
+    // A write in flight or queued is about to change it anyway
+    if (entry.pending || entry.inFlight) return;
+    entry.known = true;
+    entry.value = value;
+    entry.knownAt = Clock::now();
+}
+
+void ShadowRegisters::Invalidate(Register reg) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry& entry = entries_[static_cast<size_t>(reg)];
+    entry.known = false;
+    entry.generation++;
+}
+
+void ShadowRegisters::InvalidateAll() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (Entry& entry : entries_) {
+        entry.known = false;
+        entry.generation++;
+    }
+}
+
+std::optional<RegisterValue> ShadowRegisters::Known(Register reg) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const Entry& entry = entries_[static_cast<size_t>(reg)];
+    if (!Fresh(entry, Clock::now())) return std::nullopt;
+    return entry.value;
+}
+
+Napi::Object ShadowRegisters::Stats(Napi::Env env) {
+    Napi::Object obj = Napi::Object::New(env);
+    int known = 0;
+    int pending = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const Clock::time_point now = Clock::now();
+        for (const Entry& entry : entries_) {
+            known += Fresh(entry, now);
+            pending += entry.pending;
+        }
+        obj.Set("windowMs", windowMs_);
+    }
+    const long long hits = hits_.load();
+    const long long misses = misses_.load();
+    obj.Set("hits", static_cast<double>(hits));
+    obj.Set("misses", static_cast<double>(misses));
+    obj.Set("coalesced", static_cast<double>(coalesced_.load()));
+    obj.Set("failures", static_cast<double>(failures_.load()));
+    obj.Set("flushFailures", static_cast<double>(flushFailures_.load()));
+    obj.Set("hitRate", hits + misses > 0 ? static_cast<double>(hits) / (hits + misses) : 0.0);
+    obj.Set("known", known);
+    obj.Set("pending", pending);
+    return obj;
+}
+
+bool ShadowRegisters::Fresh(const Entry& entry, Clock::time_point now) {
+    return entry.known && now - entry.knownAt < std::chrono::milliseconds(kKnownForMs);
+}
+
+void ShadowRegisters::Send(Entry& entry, const RegisterValue& value, const Writer& write,
+                           unsigned generation, int32_t* result) {
+    const int32_t r = write();
+    misses_++;
+    if (r != 0) {
+        failures_++;
+        if (!result) flushFailures_++;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // Unknown after a failure: the device may or may not have taken it.
+        // Invalidated while the write was out: something else may have moved
+        // it since, so it stays unknown.
+        if (entry.generation == generation) {
+            entry.known = r == 0;
+            entry.value = value;
+            entry.knownAt = Clock::now();
+        }
+        entry.inFlight = false;
+    }
+    // A write queued meanwhile can go once its window ends
+    cv_.notify_all();
+    if (result) *result = r;
+}
+
+void ShadowRegisters::Run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        // Wait for the earliest pending write's window to end
+        Clock::time_point due = Clock::time_point::max();
+        Entry* next = nullptr;
+        for (Entry& entry : entries_) {
+            if (!entry.pending || entry.inFlight) continue;
+            const Clock::time_point at = entry.lastWrite + std::chrono::milliseconds(windowMs_);
+            if (at < due) {
+                due = at;
+                next = &entry;
+            }
+        }
+        if (stopping_) return;
+
+        if (!next) {
+            cv_.wait(lock);
+            continue;
+        }
+        if (Clock::now() < due) {
+            cv_.wait_until(lock, due);
+            continue;
+        }
+
+        Writer write = std::move(next->pendingWrite);
+        const RegisterValue value = next->pendingValue;
+        next->pending = false;
+        next->pendingWrite = nullptr;
+        next->lastWrite = Clock::now();
+        next->inFlight = true;
+        const unsigned generation = next->generation;
+
+        lock.unlock();
+        Send(*next, value, write, generation, nullptr);
+        lock.lock();
+    }
+}
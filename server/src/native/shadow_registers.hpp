@@ -0,0 +1,110 @@
+#pragma once
+
+#include <napi.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+// Device settings mirrored by ShadowRegisters
+enum class Register {
+    Zoom,
+    Focus,
+    ExposureMode,
+    Exposure,
+    WhiteBalance,
+    Brightness,
+    Contrast,
+    Saturation,
+    Sharpness,
+    Hue,
+    Hdr,
+    Fov,
+    MirrorFlip,
+    AntiFlicker,
+    Count
+};
+
+// A register's value; white balance uses both (type, param), the rest only a
+struct RegisterValue {
+    double a = 0;
+    double b = 0;
+
+    bool operator==(const RegisterValue& other) const { return a == other.a && b == other.b; }
+    bool operator!=(const RegisterValue& other) const { return !(*this == other); }
+};
+
+// Last known value of each writable setting, so writes that change nothing
+// never reach the device. Values come from successful writes and from reads;
+// anything that may change a setting behind our back (AI zoom, autofocus, a
+// preset) drops it with Invalidate, and the next write goes through. The
+// picture settings have no such signal, since the device pushes no change to
+// them, so every value is also forgotten kKnownForMs after it was learned, and
+// all of them on a reconnect or a full state read (InvalidateAll).
+// Writes to one register closer together than windowMs are coalesced: the
+// first goes out at once, later ones wait for the window to end and only the
+// latest of them is sent, from a flush thread.
+class ShadowRegisters {
+public:
+    using Writer = std::function<int32_t()>;
+    // Write's result for a write held by coalescing; the SDK itself only
+    // returns 0 and -1. Failed flushes show in Stats as flushFailures.
+    static constexpr int32_t kQueued = 1;
+    static constexpr int kKnownForMs = 5000;
+
+    ShadowRegisters();
+    ~ShadowRegisters();
+
+    void Configure(int windowMs);
+    // Returns the device result, 0 when the write was elided, or kQueued
+    int32_t Write(Register reg, const RegisterValue& value, Writer write);
+    // Same, but never held: sends at once (after a write in flight) and drops a
+    // queued one, for callers that need the device result
+    int32_t WriteNow(Register reg, const RegisterValue& value, Writer write, bool* elided);
+    void Observe(Register reg, const RegisterValue& value);
+    void Invalidate(Register reg);
+    void InvalidateAll();
+    // The register's value if known, without asking the device
+    std::optional<RegisterValue> Known(Register reg);
+    Napi::Object Stats(Napi::Env env);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry {
+        bool known = false;
+        RegisterValue value;
+        Clock::time_point knownAt;       // when value was learned
+        Clock::time_point lastWrite;
+        bool inFlight = false;           // a write is with the device right now
+        unsigned generation = 0;         // bumped by Invalidate
+        bool pending = false;
+        RegisterValue pendingValue;
+        Writer pendingWrite;
+    };
+
+    std::array<Entry, static_cast<size_t>(Register::Count)> entries_;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopping_ = false;
+    int windowMs_ = 50;
+
+    // Stats
+    std::atomic<long long> hits_{0};         // elided, value already held
+    std::atomic<long long> misses_{0};       // sent to the device
+    std::atomic<long long> coalesced_{0};    // replaced by a later value before being sent
+    std::atomic<long long> failures_{0};
+    std::atomic<long long> flushFailures_{0};  // of those, queued writes sent later
+
+    // Whether the entry's value can still be trusted; under mutex_
+    static bool Fresh(const Entry& entry, Clock::time_point now);
+    void Send(Entry& entry, const RegisterValue& value, const Writer& write, unsigned generation,
+              int32_t* result);
+    void Run();
+};
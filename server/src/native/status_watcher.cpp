@@ -0,0 +1,230 @@
+#include "status_watcher.hpp"
+#include "worker_support.hpp"
+#include <algorithm>
+#include <map>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double MsSince(Clock::time_point start, Clock::time_point now) {
+    return std::chrono::duration<double, std::milli>(now - start).count();
+}
+
+// The SDK keeps one status callback per device, and getDevices() hands out a
+// new wrapper (and watcher) for the same device on every call. Watchers share
+// the registration, so one going away can't switch off another's updates.
+// Only the JS thread registers and unregisters; the lock keeps a watcher from
+// being destroyed while a status is being delivered to it.
+std::mutex gWatchersMutex;
+std::map<Device*, std::vector<StatusWatcher*>> gWatchers;
+
+// Resolve a finished wait on the JS thread
+void SettleWait(Napi::Env env, Napi::Function, StatusWait* wait) {
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("confirmed", wait->confirmed);
+    result.Set("elapsedMs", wait->elapsedMs);
+    result.Set("updates", wait->updates);
+    wait->deferred.Resolve(result);
+    delete wait;
+}
+
+}  // namespace
+
+StatusWatcher::StatusWatcher(Napi::Env env, std::shared_ptr<Device> device)
+    : device_(std::move(device)) {
+    tsfn_ = MakeResultTsfn(env, "StatusWatcherResult");
+
+    thread_ = std::thread(&StatusWatcher::Run, this);
+
+    bool first;
+    {
+        std::lock_guard<std::mutex> lock(gWatchersMutex);
+        auto& watchers = gWatchers[device_.get()];
+        first = watchers.empty();
+        watchers.push_back(this);
+    }
+    if (first) {
+        device_->setDevStatusCallbackFunc(&StatusWatcher::OnStatus, device_.get());
+        device_->enableDevStatusCallback(true);
+    }
+}
+
+StatusWatcher::~StatusWatcher() {
+    bool last;
+    {
+        std::lock_guard<std::mutex> lock(gWatchersMutex);
+        auto& watchers = gWatchers[device_.get()];
+        watchers.erase(std::remove(watchers.begin(), watchers.end(), this), watchers.end());
+        last = watchers.empty();
+        if (last) gWatchers.erase(device_.get());
+    }
+    if (last) {
+        device_->enableDevStatusCallback(false);
+        device_->setDevStatusCallbackFunc([](void*, const void*) {}, nullptr);
+    }
+
+    std::list<std::unique_ptr<StatusWait>> open;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        open.swap(waits_);
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+
+    for (auto& wait : open) {
+        Settle(std::move(wait), false);
+    }
+    tsfn_.Release();
+    if (forward_) forward_.Release();
+}
+
+void StatusWatcher::OnStatus(void* param, const void* data) {
+    if (!param || !data) return;
+    const auto& status = *static_cast<const Device::CameraStatus*>(data);
+    std::lock_guard<std::mutex> lock(gWatchersMutex);
+    auto it = gWatchers.find(static_cast<Device*>(param));
+    if (it == gWatchers.end()) return;
+    for (StatusWatcher* watcher : it->second) {
+        watcher->Update(status);
+    }
+}
+
+Napi::Promise StatusWatcher::WaitFor(Napi::Env env, StatusPredicate match, int timeoutMs) {
+    auto wait = std::make_unique<StatusWait>(env);
+    wait->match = std::move(match);
+    wait->start = Clock::now();
+    wait->deadline = wait->start + std::chrono::milliseconds(std::max(timeoutMs, 0));
+    Napi::Promise promise = wait->deferred.Promise();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        waits_.push_back(std::move(wait));
+    }
+    cv_.notify_all();
+    device_->nextRefreshDevStatus();
+    return promise;
+}
+
+Napi::Object StatusWatcher::Stats(Napi::Env env) {
+    Napi::Object obj = Napi::Object::New(env);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        obj.Set("pending", static_cast<double>(waits_.size()));
+    }
+    obj.Set("updates", static_cast<double>(updates_.load()));
+    obj.Set("confirmed", static_cast<double>(confirmed_.load()));
+    obj.Set("timedOut", static_cast<double>(timedOut_.load()));
+    obj.Set("lastConfirmMs", lastConfirmMs_.load());
+    return obj;
+}
+
+void StatusWatcher::SetListener(std::function<void(const Device::CameraStatus&)> listener) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    listener_ = std::move(listener);
+}
+
+void StatusWatcher::Forward(Napi::Env env, Napi::Function callback, StatusConverter convert) {
+    Napi::ThreadSafeFunction forward = Napi::ThreadSafeFunction::New(
+        env,
+        callback,
+        "StatusWatcherForward",
+        0,
+        1
+    );
+    forward.Unref(env);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::swap(forward_, forward);
+        convert_ = std::move(convert);
+    }
+    if (forward) forward.Release();
+}
+
+void StatusWatcher::Update(const Device::CameraStatus& status) {
+    updates_++;
+    std::list<std::unique_ptr<StatusWait>> matched;
+    std::function<void(const Device::CameraStatus&)> listener;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        listener = listener_;
+        if (forward_) {
+            StatusConverter convert = convert_;
+            auto* copy = new Device::CameraStatus(status);
+            auto deliver = [convert](Napi::Env env, Napi::Function callback,
+                                     Device::CameraStatus* pushed) {
+                callback.Call({convert(env, *pushed)});
+                delete pushed;
+            };
+            const napi_status queued = forward_.NonBlockingCall(copy, deliver);
+            if (queued != napi_ok) delete copy;
+        }
+        for (auto it = waits_.begin(); it != waits_.end();) {
+            (*it)->updates++;
+            if ((*it)->match(status)) {
+                matched.push_back(std::move(*it));
+                it = waits_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    for (auto& wait : matched) {
+        Settle(std::move(wait), true);
+    }
+    if (listener) listener(status);
+}
+
+void StatusWatcher::Settle(std::unique_ptr<StatusWait> wait, bool confirmed) {
+    wait->confirmed = confirmed;
+    wait->elapsedMs = MsSince(wait->start, Clock::now());
+    if (confirmed) {
+        confirmed_++;
+        lastConfirmMs_ = wait->elapsedMs;
+    } else {
+        timedOut_++;
+    }
+    tsfn_.NonBlockingCall(wait.release(), SettleWait);
+}
+
+void StatusWatcher::Run() {
+    while (true) {
+        std::list<std::unique_ptr<StatusWait>> expired;
+        bool refresh = false;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return stopping_ || !waits_.empty(); });
+            if (stopping_) return;
+
+            // Wake for the next refresh or the earliest deadline, whichever comes first
+            Clock::time_point wake = Clock::now() + std::chrono::milliseconds(kRefreshMs);
+            for (const auto& wait : waits_) {
+                wake = std::min(wake, wait->deadline);
+            }
+            cv_.wait_until(lock, wake, [this] { return stopping_; });
+            if (stopping_) return;
+
+            const Clock::time_point now = Clock::now();
+            for (auto it = waits_.begin(); it != waits_.end();) {
+                if ((*it)->deadline <= now) {
+                    expired.push_back(std::move(*it));
+                    it = waits_.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+            refresh = !waits_.empty();
+        }
+
+        for (auto& wait : expired) {
+            Settle(std::move(wait), false);
+        }
+        if (refresh) {
+            device_->nextRefreshDevStatus();
+        }
+    }
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <napi.h>
+#include <dev/dev.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Tells whether a pushed camera status shows the state a command asked for
+using StatusPredicate = std::function<bool(const Device::CameraStatus&)>;
+// Turns a pushed camera status into the object handed to JS
+using StatusConverter = std::function<Napi::Value(Napi::Env, const Device::CameraStatus&)>;
+
+struct StatusWait {
+    StatusPredicate match;
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::time_point deadline;
+    Napi::Promise::Deferred deferred;
+
+    // Results, filled in when the wait settles
+    bool confirmed = false;
+    double elapsedMs = 0;
+    int updates = 0;                 // statuses seen while waiting
+
+    explicit StatusWait(Napi::Env env) : deferred(Napi::Promise::Deferred::New(env)) {}
+};
+
+// Watches the SDK's pushed camera status (DevStatusCallback) so a command can
+// be confirmed by the state it changes instead of a fixed sleep and a re-read.
+// The SDK fetches status every two or three seconds; while a wait is open the
+// next fetch is pulled forward with nextRefreshDevStatus every kRefreshMs, so
+// a change usually shows up within a few hundred milliseconds.
+class StatusWatcher {
+public:
+    static constexpr int kRefreshMs = 150;
+
+    StatusWatcher(Napi::Env env, std::shared_ptr<Device> device);
+    ~StatusWatcher();
+
+    // Resolves { confirmed, elapsedMs, updates } with the first status pushed
+    // after this call that matches, or with confirmed = false after timeoutMs
+    Napi::Promise WaitFor(Napi::Env env, StatusPredicate match, int timeoutMs);
+    Napi::Object Stats(Napi::Env env);
+    // Called with every pushed status, on the SDK's thread
+    void SetListener(std::function<void(const Device::CameraStatus&)> listener);
+    // Calls callback on the JS thread with every pushed status, converted;
+    // replaces an earlier callback
+    void Forward(Napi::Env env, Napi::Function callback, StatusConverter convert);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    std::shared_ptr<Device> device_;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::list<std::unique_ptr<StatusWait>> waits_;
+    std::function<void(const Device::CameraStatus&)> listener_;
+    bool stopping_ = false;
+    Napi::ThreadSafeFunction tsfn_;
+    Napi::ThreadSafeFunction forward_;   // set by Forward
+    StatusConverter convert_;
+
+    // Stats
+    std::atomic<long long> updates_{0};
+    std::atomic<long long> confirmed_{0};
+    std::atomic<long long> timedOut_{0};
+    std::atomic<double> lastConfirmMs_{0};
+
+    // The device's SDK callback; param is the Device, and every watcher on it gets the status
+    static void OnStatus(void* param, const void* data);
+    void Update(const Device::CameraStatus& status);
+    void Settle(std::unique_ptr<StatusWait> wait, bool confirmed);
+    void Run();
+};
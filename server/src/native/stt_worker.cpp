@@ -0,0 +1,550 @@
+#include "stt_worker.hpp"
+#include "worker_support.hpp"
+#include <whisper.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+Napi::FunctionReference SttWorker::constructor;
+
+namespace {
+
+Napi::Array WordsToArray(Napi::Env env, const std::vector<SttWord>& words, double offsetMs) {
+    Napi::Array arr = Napi::Array::New(env, words.size());
+    for (size_t i = 0; i < words.size(); i++) {
+        Napi::Object word = Napi::Object::New(env);
+        word.Set("start", offsetMs + words[i].startMs);
+        word.Set("end", offsetMs + words[i].endMs);
+        word.Set("text", words[i].text);
+        arr[i] = word;
+    }
+    return arr;
+}
+
+// Resolve or reject a finished job on the JS thread
+void SettleJob(Napi::Env env, Napi::Function, SttJob* job) {
+    if (job->ok) {
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("text", job->text);
+
+        Napi::Array segments = Napi::Array::New(env, job->segments.size());
+        for (size_t i = 0; i < job->segments.size(); i++) {
+            Napi::Object seg = Napi::Object::New(env);
+            seg.Set("start", static_cast<double>(job->segments[i].startMs));
+            seg.Set("end", static_cast<double>(job->segments[i].endMs));
+            seg.Set("text", job->segments[i].text);
+            seg.Set("words", WordsToArray(env, job->segments[i].words, 0));
+            segments[i] = seg;
+        }
+        result.Set("segments", segments);
+        result.Set("elapsedMs", job->elapsedMs);
+        job->deferred.Resolve(result);
+    } else {
+        job->deferred.Reject(Napi::Error::New(env, job->error).Value());
+    }
+    delete job;
+}
+
+// Deliver a live transcript to the stream callback on the JS thread
+void DeliverStreamEvent(Napi::Env env, Napi::Function callback, SttStreamEvent* event) {
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("type", event->final ? "final" : "partial");
+    obj.Set("utterance", static_cast<double>(event->utterance));
+    obj.Set("text", event->text);
+    obj.Set("start", event->startMs);
+    obj.Set("end", event->endMs);
+    if (event->final) {
+        obj.Set("words", WordsToArray(env, event->words, event->startMs));
+    }
+    obj.Set("elapsedMs", event->elapsedMs);
+    callback.Call({obj});
+    delete event;
+}
+
+// 32 ms gating frames
+constexpr size_t kVadFrame = VoiceActivityDetector::kFrameSize;
+
+// Audio kept before the first voiced frame so word onsets aren't clipped
+constexpr int64_t kPrerollSamples = kSttSampleRate * 3 / 10;
+
+std::string Trim(const std::string& s) {
+    size_t start = s.find_first_not_of(" \t\r\n");
+    if (start == std::string::npos) return "";
+    size_t end = s.find_last_not_of(" \t\r\n");
+    return s.substr(start, end - start + 1);
+}
+
+}  // namespace
+
+Napi::Object SttWorker::Init(Napi::Env env, Napi::Object exports) {
+    Napi::Function func = DefineClass(env, "SttWorker", {
+        InstanceMethod("transcribe", &SttWorker::Transcribe),
+        InstanceMethod("startStream", &SttWorker::StartStream),
+        InstanceMethod("pushPcm", &SttWorker::PushPcm),
+        InstanceMethod("stopStream", &SttWorker::StopStream),
+        InstanceMethod("getStats", &SttWorker::GetStats),
+        InstanceMethod("close", &SttWorker::Close),
+    });
+
+    constructor = Napi::Persistent(func);
+    constructor.SuppressDestruct();
+
+    exports.Set("SttWorker", func);
+    return exports;
+}
+
+// new SttWorker({ model, threads?, queueSize?, language? })
+SttWorker::SttWorker(const Napi::CallbackInfo& info)
+    : Napi::ObjectWrap<SttWorker>(info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Options object expected").ThrowAsJavaScriptException();
+        return;
+    }
+
+    Napi::Object opts = info[0].As<Napi::Object>();
+    if (!opts.Get("model").IsString()) {
+        Napi::TypeError::New(env, "options.model must be a path string").ThrowAsJavaScriptException();
+        return;
+    }
+
+    modelPath_ = opts.Get("model").As<Napi::String>().Utf8Value();
+    language_ = opts.Get("language").IsString() ? opts.Get("language").As<Napi::String>().Utf8Value() : "en";
+    if (opts.Get("threads").IsNumber()) {
+        threads_ = std::max(1, opts.Get("threads").As<Napi::Number>().Int32Value());
+    }
+    if (opts.Get("queueSize").IsNumber()) {
+        maxQueue_ = static_cast<size_t>(std::max(1, opts.Get("queueSize").As<Napi::Number>().Int32Value()));
+    }
+
+    tsfn_ = MakeResultTsfn(env, "SttWorkerResult");
+
+    thread_ = std::thread(&SttWorker::Run, this);
+}
+
+SttWorker::~SttWorker() {
+    Stop();
+}
+
+void SttWorker::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) return;
+        stopping_ = true;
+    }
+    cv_.notify_all();
+
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+
+    // Reject anything that never ran
+    for (auto& job : queue_) {
+        job->ok = false;
+        job->error = "STT worker closed";
+        tsfn_.NonBlockingCall(job.release(), SettleJob);
+    }
+    queue_.clear();
+
+    if (ctx_) {
+        whisper_free(ctx_);
+        ctx_ = nullptr;
+    }
+
+    tsfn_.Release();
+    if (streaming_) {
+        streaming_ = false;
+        streamTsfn_.Release();
+    }
+}
+
+void SttWorker::Run() {
+    // Load the model once; it stays resident for the lifetime of the worker
+    whisper_context_params cparams = whisper_context_default_params();
+    ctx_ = whisper_init_from_file_with_params(modelPath_.c_str(), cparams);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        loaded_ = ctx_ != nullptr;
+        if (!loaded_) loadError_ = "Failed to load whisper model: " + modelPath_;
+    }
+
+    while (true) {
+        std::unique_ptr<SttJob> job;
+        bool streamWork = false;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            auto streamReady = [this] {
+                return streaming_ && ring_.End() - vadPos_ >= static_cast<int64_t>(kVadFrame);
+            };
+            cv_.wait(lock, [&] { return stopping_ || !queue_.empty() || streamReady(); });
+            if (stopping_) return;
+
+            // Live audio takes priority over queued files
+            if (streamReady()) {
+                streamWork = true;
+            } else {
+                job = std::move(queue_.front());
+                queue_.pop_front();
+            }
+            busy_ = true;
+        }
+
+        if (streamWork) {
+            ProcessStream();
+        } else {
+            Process(*job);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            busy_ = false;
+        }
+        if (job) {
+            tsfn_.NonBlockingCall(job.release(), SettleJob);
+        }
+    }
+}
+
+bool SttWorker::RunWhisper(const std::vector<float>& samples, bool singleSegment,
+                           std::string& text, std::vector<SttSegment>* segments, std::string& error) {
+    if (!ctx_) {
+        error = "Whisper model not loaded";
+        return false;
+    }
+
+    whisper_full_params params = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+    params.n_threads = threads_;
+    params.language = language_.c_str();
+    params.print_progress = false;
+    params.print_realtime = false;
+    params.print_timestamps = false;
+    params.print_special = false;
+    params.no_context = true;
+    params.single_segment = singleSegment;
+    // Word timing is only needed when the caller keeps segments
+    params.token_timestamps = segments != nullptr;
+
+    if (whisper_full(ctx_, params, samples.data(), static_cast<int>(samples.size())) != 0) {
+        error = "whisper_full failed";
+        return false;
+    }
+
+    int nSegments = whisper_full_n_segments(ctx_);
+    for (int i = 0; i < nSegments; i++) {
+        SttSegment seg;
+        // whisper timestamps are in 10 ms units
+        seg.startMs = whisper_full_get_segment_t0(ctx_, i) * 10;
+        seg.endMs = whisper_full_get_segment_t1(ctx_, i) * 10;
+        seg.text = Trim(whisper_full_get_segment_text(ctx_, i));
+        if (seg.text.empty()) continue;
+
+        if (!text.empty()) text += " ";
+        text += seg.text;
+        if (!segments) continue;
+
+        // Merge sub-word tokens into words; a leading space starts a new one
+        int nTokens = whisper_full_n_tokens(ctx_, i);
+        for (int j = 0; j < nTokens; j++) {
+            whisper_token_data token = whisper_full_get_token_data(ctx_, i, j);
+            if (token.id >= whisper_token_eot(ctx_)) continue;  // timestamps and other specials
+
+            std::string piece = whisper_full_get_token_text(ctx_, i, j);
+            bool startsWord = !piece.empty() && piece[0] == ' ';
+            piece = Trim(piece);
+            if (piece.empty()) continue;
+
+            if (startsWord || seg.words.empty()) {
+                seg.words.push_back({token.t0 * 10, token.t1 * 10, piece});
+            } else {
+                seg.words.back().text += piece;
+                seg.words.back().endMs = token.t1 * 10;
+            }
+        }
+        segments->push_back(std::move(seg));
+    }
+    return true;
+}
+
+void SttWorker::Process(SttJob& job) {
+    auto started = std::chrono::steady_clock::now();
+
+    if (!ctx_) {
+        job.error = loadError_;
+        return;
+    }
+
+    if (!job.path.empty() && !ReadWavMono16k(job.path, job.samples, job.error)) {
+        return;
+    }
+
+    if (!RunWhisper(job.samples, false, job.text, &job.segments, job.error)) {
+        return;
+    }
+
+    job.ok = true;
+    job.elapsedMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - started).count();
+}
+
+void SttWorker::ProcessStream() {
+    std::vector<float> fresh;
+    int64_t from;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // A new stream's settings; a stop/start may have cut an utterance short
+        if (streamReset_) {
+            tuning_ = nextTuning_;
+            vad_ = VoiceActivityDetector(tuning_.vad);
+            inSpeech_ = false;
+            streamReset_ = false;
+        }
+        // If we fell behind by more than the ring holds, skip the lost audio
+        from = std::max(vadPos_, ring_.Begin());
+        ring_.Copy(from, ring_.End(), fresh);
+    }
+
+    size_t i = 0;
+    for (; i + kVadFrame <= fresh.size(); i += kVadFrame) {
+        int64_t framePos = from + static_cast<int64_t>(i);
+        int64_t frameEnd = framePos + static_cast<int64_t>(kVadFrame);
+
+        if (vad_.IsVoiced(fresh.data() + i)) {
+            if (!inSpeech_) {
+                inSpeech_ = true;
+                utteranceId_++;
+                utteranceStart_ = std::max<int64_t>(0, framePos - kPrerollSamples);
+                lastPartial_ = framePos;
+            }
+            lastVoice_ = frameEnd;
+        }
+
+        // Close the utterance after a pause, or split very long ones
+        if (inSpeech_ && (frameEnd - lastVoice_ >= tuning_.hangoverSamples ||
+                          frameEnd - utteranceStart_ >= tuning_.maxUtteranceSamples)) {
+            EmitStream(true, utteranceStart_, frameEnd);
+            inSpeech_ = false;
+        }
+    }
+
+    int64_t gated = from + static_cast<int64_t>(i);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        vadPos_ = gated;
+    }
+
+    // Partial over the trailing window; consecutive windows overlap by window - step
+    if (inSpeech_ && gated - lastPartial_ >= tuning_.stepSamples) {
+        lastPartial_ = gated;
+        EmitStream(false, std::max(utteranceStart_, gated - tuning_.windowSamples), gated);
+    }
+}
+
+void SttWorker::EmitStream(bool final, int64_t from, int64_t to) {
+    auto started = std::chrono::steady_clock::now();
+
+    std::vector<float> samples;
+    double epochMs;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ring_.Copy(from, to, samples);
+        epochMs = streamEpochMs_;
+    }
+    if (samples.empty()) return;
+
+    auto event = std::make_unique<SttStreamEvent>();
+    std::vector<SttSegment> segments;
+    std::string error;
+    if (!RunWhisper(samples, !final, event->text, final ? &segments : nullptr, error) || event->text.empty()) {
+        return;
+    }
+    for (SttSegment& seg : segments) {
+        event->words.insert(event->words.end(), seg.words.begin(), seg.words.end());
+    }
+
+    event->final = final;
+    event->utterance = utteranceId_;
+    event->startMs = epochMs + from * 1000.0 / kSttSampleRate;
+    event->endMs = epochMs + to * 1000.0 / kSttSampleRate;
+    event->elapsedMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - started).count();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (streaming_) {
+        streamTsfn_.NonBlockingCall(event.release(), DeliverStreamEvent);
+    }
+}
+
+// startStream({ windowMs?, stepMs?, hangoverMs?, maxUtteranceMs?, vadThreshold? }, callback)
+Napi::Value SttWorker::StartStream(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 2 || !info[0].IsObject() || !info[1].IsFunction()) {
+        Napi::TypeError::New(env, "Options object and callback expected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    Napi::Object opts = info[0].As<Napi::Object>();
+    auto msOption = [&](const char* key, int64_t fallback) -> int64_t {
+        int64_t ms = opts.Get(key).IsNumber() ? opts.Get(key).As<Napi::Number>().Int64Value() : fallback;
+        return std::max<int64_t>(20, ms) * kSttSampleRate / 1000;
+    };
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (streaming_) {
+        Napi::Error::New(env, "Stream already started").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    // Voiced audio would reach whisper_full without a context
+    if (!loaded_) {
+        Napi::Error::New(env, loadError_.empty() ? "Whisper model still loading" : loadError_)
+            .ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    nextTuning_.windowSamples = msOption("windowMs", 5000);
+    nextTuning_.stepSamples = msOption("stepMs", 1000);
+    nextTuning_.hangoverSamples = msOption("hangoverMs", 700);
+    // The whole utterance must still be in the ring when it is finalized
+    nextTuning_.maxUtteranceSamples =
+        std::min<int64_t>(msOption("maxUtteranceMs", 15000), kSttSampleRate * 25);
+    nextTuning_.vad = VadOptions();
+    if (opts.Get("vadThreshold").IsNumber()) {
+        nextTuning_.vad.minRms = opts.Get("vadThreshold").As<Napi::Number>().FloatValue();
+    }
+    streamReset_ = true;
+
+    streamTsfn_ = Napi::ThreadSafeFunction::New(
+        env,
+        info[1].As<Napi::Function>(),
+        "SttStreamEvent",
+        0,
+        1
+    );
+    streamTsfn_.Unref(env);
+
+    ring_.Clear();
+    streamEpochMs_ = -1;
+    vadPos_ = 0;
+    streaming_ = true;
+
+    return Napi::Boolean::New(env, true);
+}
+
+// pushPcm(pcm: Buffer | Int16Array, timestampMs?) - 16 kHz mono S16LE
+Napi::Value SttWorker::PushPcm(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsTypedArray()) {
+        Napi::TypeError::New(env, "Buffer or Int16Array expected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    Napi::TypedArray arr = info[0].As<Napi::TypedArray>();
+    const uint8_t* bytes = static_cast<const uint8_t*>(arr.ArrayBuffer().Data()) + arr.ByteOffset();
+    size_t count = arr.ByteLength() / sizeof(int16_t);
+
+    std::vector<float> samples(count);
+    for (size_t i = 0; i < count; i++) {
+        int16_t v = static_cast<int16_t>(bytes[i * 2] | (bytes[i * 2 + 1] << 8));
+        samples[i] = v / 32768.0f;
+    }
+
+    double now = info.Length() > 1 && info[1].IsNumber()
+        ? info[1].As<Napi::Number>().DoubleValue()
+        : static_cast<double>(std::chrono::duration_cast<std::chrono::milliseconds>(
+              std::chrono::system_clock::now().time_since_epoch()).count());
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!streaming_) return Napi::Boolean::New(env, false);
+
+        // Anchor the sample clock to the arrival time of the first chunk
+        if (streamEpochMs_ < 0) {
+            streamEpochMs_ = now - count * 1000.0 / kSttSampleRate;
+        }
+        ring_.Push(samples.data(), samples.size());
+    }
+    cv_.notify_one();
+
+    return Napi::Boolean::New(env, true);
+}
+
+Napi::Value SttWorker::StopStream(const Napi::CallbackInfo& info) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (streaming_) {
+        streaming_ = false;
+        streamTsfn_.Release();
+    }
+    return info.Env().Undefined();
+}
+
+// transcribe(pathOrSamples: string | Float32Array | Int16Array): Promise<{ text, segments, elapsedMs }>
+Napi::Value SttWorker::Transcribe(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    auto job = std::make_unique<SttJob>(env);
+    Napi::Promise promise = job->deferred.Promise();
+
+    if (info.Length() < 1) {
+        job->deferred.Reject(Napi::TypeError::New(env, "Audio path or samples expected").Value());
+        return promise;
+    }
+
+    if (info[0].IsString()) {
+        job->path = info[0].As<Napi::String>().Utf8Value();
+    } else if (info[0].IsTypedArray()) {
+        Napi::TypedArray arr = info[0].As<Napi::TypedArray>();
+        if (arr.TypedArrayType() == napi_float32_array) {
+            Napi::Float32Array f32 = info[0].As<Napi::Float32Array>();
+            job->samples.assign(f32.Data(), f32.Data() + f32.ElementLength());
+        } else if (arr.TypedArrayType() == napi_int16_array) {
+            Napi::Int16Array i16 = info[0].As<Napi::Int16Array>();
+            Int16ToFloat(i16.Data(), i16.ElementLength(), job->samples);
+        } else {
+            job->deferred.Reject(Napi::TypeError::New(env, "Float32Array or Int16Array expected").Value());
+            return promise;
+        }
+    } else {
+        job->deferred.Reject(Napi::TypeError::New(env, "Audio path or samples expected").Value());
+        return promise;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) {
+            job->deferred.Reject(Napi::Error::New(env, "STT worker closed").Value());
+            return promise;
+        }
+        // Bounded queue: shed load instead of piling up work behind a slow model
+        if (queue_.size() >= maxQueue_) {
+            job->deferred.Reject(Napi::Error::New(env, "STT queue full").Value());
+            return promise;
+        }
+        queue_.push_back(std::move(job));
+    }
+    cv_.notify_one();
+
+    return promise;
+}
+
+Napi::Value SttWorker::GetStats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("loaded", loaded_);
+    if (!loadError_.empty()) obj.Set("error", loadError_);
+    obj.Set("queued", static_cast<double>(queue_.size()));
+    obj.Set("busy", busy_);
+    obj.Set("threads", threads_);
+    obj.Set("queueSize", static_cast<double>(maxQueue_));
+    obj.Set("streaming", streaming_);
+    obj.Set("streamBacklogMs", streaming_ ? (ring_.End() - vadPos_) * 1000.0 / kSttSampleRate : 0.0);
+    return obj;
+}
+
+Napi::Value SttWorker::Close(const Napi::CallbackInfo& info) {
+    Stop();
+    return info.Env().Undefined();
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <napi.h>
+#include "pcm_ring.hpp"
+#include "vad.hpp"
+#include "wav_reader.hpp"
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct whisper_context;
+
+struct SttWord {
+    int64_t startMs;
+    int64_t endMs;
+    std::string text;
+};
+
+// A transcribed segment, offsets relative to the start of the submitted audio
+struct SttSegment {
+    int64_t startMs;
+    int64_t endMs;
+    std::string text;
+    std::vector<SttWord> words;
+};
+
+struct SttJob {
+    std::string path;                 // WAV file to load on the worker thread, or
+    std::vector<float> samples;       // 16 kHz mono samples passed in from JS
+    Napi::Promise::Deferred deferred;
+
+    // Results, filled in by the worker thread
+    bool ok = false;
+    std::string error;
+    std::string text;
+    std::vector<SttSegment> segments;
+    double elapsedMs = 0;
+
+    explicit SttJob(Napi::Env env) : deferred(Napi::Promise::Deferred::New(env)) {}
+};
+
+// Partial or final transcript from the live PCM stream, times in epoch ms
+struct SttStreamEvent {
+    bool final;
+    int64_t utterance;
+    double startMs;
+    double endMs;
+    std::string text;
+    std::vector<SttWord> words;       // finals only, offsets from startMs
+    double elapsedMs;
+};
+
+// Live stream tuning, in samples
+struct SttStreamTuning {
+    int64_t windowSamples = 0;
+    int64_t stepSamples = 0;
+    int64_t hangoverSamples = 0;
+    int64_t maxUtteranceSamples = 0;
+    VadOptions vad;
+};
+
+// Long-lived whisper.cpp worker. The model is loaded once on a background
+// thread; audio is submitted through a bounded queue and transcripts are
+// returned as Promises, so no per-segment process or .txt file is needed.
+//
+// The worker can also consume live 16 kHz PCM (startStream/pushPcm). Voiced
+// audio is transcribed incrementally over overlapping windows and reported as
+// partial transcripts every step, then as a final one when the speaker pauses.
+class SttWorker : public Napi::ObjectWrap<SttWorker> {
+public:
+    static Napi::Object Init(Napi::Env env, Napi::Object exports);
+
+    SttWorker(const Napi::CallbackInfo& info);
+    ~SttWorker();
+
+private:
+    static Napi::FunctionReference constructor;
+
+    std::string modelPath_;
+    std::string language_;
+    int threads_ = 4;
+    size_t maxQueue_ = 4;
+
+    whisper_context* ctx_ = nullptr;
+    bool loaded_ = false;
+    std::string loadError_;
+
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::unique_ptr<SttJob>> queue_;
+    bool busy_ = false;
+    bool stopping_ = false;
+
+    Napi::ThreadSafeFunction tsfn_;
+
+    // Live stream input, guarded by mutex_
+    bool streaming_ = false;
+    PcmRing ring_{static_cast<size_t>(kSttSampleRate) * 30};
+    double streamEpochMs_ = -1;       // wall clock of ring sample 0
+    int64_t vadPos_ = 0;              // next sample the worker has not gated yet
+    Napi::ThreadSafeFunction streamTsfn_;
+
+    SttStreamTuning nextTuning_;      // set by startStream
+    bool streamReset_ = false;        // worker adopts nextTuning_ and drops any utterance
+
+    // Utterance tracking, worker thread only
+    SttStreamTuning tuning_;
+    bool inSpeech_ = false;
+    int64_t utteranceStart_ = 0;
+    int64_t lastVoice_ = 0;
+    int64_t lastPartial_ = 0;
+    int64_t utteranceId_ = 0;
+    VoiceActivityDetector vad_;
+
+    void Run();
+    void Process(SttJob& job);
+    void ProcessStream();
+    void EmitStream(bool final, int64_t from, int64_t to);
+    bool RunWhisper(const std::vector<float>& samples, bool singleSegment,
+                    std::string& text, std::vector<SttSegment>* segments, std::string& error);
+    void Stop();
+
+    Napi::Value Transcribe(const Napi::CallbackInfo& info);
+    Napi::Value StartStream(const Napi::CallbackInfo& info);
+    Napi::Value PushPcm(const Napi::CallbackInfo& info);
+    Napi::Value StopStream(const Napi::CallbackInfo& info);
+    Napi::Value GetStats(const Napi::CallbackInfo& info);
+    Napi::Value Close(const Napi::CallbackInfo& info);
+};
@@ -0,0 +1,287 @@
+#include "vad.hpp"
+#include "wav_reader.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define OBSBOT_VAD_SSE2 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define OBSBOT_VAD_NEON 1
+#endif
+
+namespace {
+
+constexpr float kPi = 3.14159265358979f;
+
+// Flatness is measured over 300 Hz - 4 kHz, where voiced speech is strongly
+// harmonic; mains hum and HVAC rumble below that would otherwise dominate.
+constexpr size_t kBandLow = 300 * VoiceActivityDetector::kFrameSize / kSttSampleRate;
+constexpr size_t kBandHigh = 4000 * VoiceActivityDetector::kFrameSize / kSttSampleRate;
+
+float SumSquares(const float* x, size_t n) {
+    size_t i = 0;
+    float sum = 0.0f;
+#if defined(OBSBOT_VAD_SSE2)
+    __m128 acc = _mm_setzero_ps();
+    for (; i < (n & ~size_t(3)); i += 4) {
+        __m128 v = _mm_loadu_ps(x + i);
+        acc = _mm_add_ps(acc, _mm_mul_ps(v, v));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, acc);
+    sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#elif defined(OBSBOT_VAD_NEON)
+    float32x4_t acc = vdupq_n_f32(0.0f);
+    for (; i < (n & ~size_t(3)); i += 4) {
+        float32x4_t v = vld1q_f32(x + i);
+        acc = vmlaq_f32(acc, v, v);
+    }
+    sum = vgetq_lane_f32(acc, 0) + vgetq_lane_f32(acc, 1) +
+          vgetq_lane_f32(acc, 2) + vgetq_lane_f32(acc, 3);
+#endif
+    for (; i < n; i++) {
+        sum += x[i] * x[i];
+    }
+    return sum;
+}
+
+// Number of adjacent sample pairs with opposite signs
+size_t CountZeroCrossings(const float* x, size_t n) {
+    if (n < 2) return 0;
+    size_t pairs = n - 1;
+    size_t i = 0;
+    size_t count = 0;
+#if defined(OBSBOT_VAD_SSE2)
+    // Compare masks are all-ones (-1), so subtracting them counts crossings
+    __m128i acc = _mm_setzero_si128();
+    const __m128 zero = _mm_setzero_ps();
+    for (; i < (pairs & ~size_t(3)); i += 4) {
+        __m128 prod = _mm_mul_ps(_mm_loadu_ps(x + i), _mm_loadu_ps(x + i + 1));
+        acc = _mm_sub_epi32(acc, _mm_castps_si128(_mm_cmplt_ps(prod, zero)));
+    }
+    int32_t lanes[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), acc);
+    count = static_cast<size_t>(lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+#elif defined(OBSBOT_VAD_NEON)
+    uint32x4_t acc = vdupq_n_u32(0);
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    for (; i < (pairs & ~size_t(3)); i += 4) {
+        float32x4_t prod = vmulq_f32(vld1q_f32(x + i), vld1q_f32(x + i + 1));
+        acc = vsubq_u32(acc, vcltq_f32(prod, zero));
+    }
+    count = vgetq_lane_u32(acc, 0) + vgetq_lane_u32(acc, 1) +
+            vgetq_lane_u32(acc, 2) + vgetq_lane_u32(acc, 3);
+#endif
+    for (; i < pairs; i++) {
+        if (x[i] * x[i + 1] < 0.0f) count++;
+    }
+    return count;
+}
+
+void MultiplyInto(const float* a, const float* b, float* out, size_t n) {
+    size_t i = 0;
+#if defined(OBSBOT_VAD_SSE2)
+    for (; i < (n & ~size_t(3)); i += 4) {
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    }
+#elif defined(OBSBOT_VAD_NEON)
+    for (; i < (n & ~size_t(3)); i += 4) {
+        vst1q_f32(out + i, vmulq_f32(vld1q_f32(a + i), vld1q_f32(b + i)));
+    }
+#endif
+    for (; i < n; i++) {
+        out[i] = a[i] * b[i];
+    }
+}
+
+void PowerInto(const float* re, const float* im, float* out, size_t n) {
+    size_t i = 0;
+#if defined(OBSBOT_VAD_SSE2)
+    for (; i < (n & ~size_t(3)); i += 4) {
+        __m128 r = _mm_loadu_ps(re + i);
+        __m128 m = _mm_loadu_ps(im + i);
+        _mm_storeu_ps(out + i, _mm_add_ps(_mm_mul_ps(r, r), _mm_mul_ps(m, m)));
+    }
+#elif defined(OBSBOT_VAD_NEON)
+    for (; i < (n & ~size_t(3)); i += 4) {
+        float32x4_t r = vld1q_f32(re + i);
+        float32x4_t m = vld1q_f32(im + i);
+        vst1q_f32(out + i, vmlaq_f32(vmulq_f32(r, r), m, m));
+    }
+#endif
+    for (; i < n; i++) {
+        out[i] = re[i] * re[i] + im[i] * im[i];
+    }
+}
+
+// In-place iterative radix-2 FFT on split real/imaginary arrays
+void Fft(float* re, float* im, size_t n, const float* twRe, const float* twIm) {
+    for (size_t i = 1, j = 0; i < n; i++) {
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1) j ^= bit;
+        j ^= bit;
+        if (i < j) {
+            std::swap(re[i], re[j]);
+            std::swap(im[i], im[j]);
+        }
+    }
+
+    for (size_t len = 2; len <= n; len <<= 1) {
+        size_t half = len >> 1;
+        size_t stride = n / len;
+        for (size_t start = 0; start < n; start += len) {
+            for (size_t k = 0; k < half; k++) {
+                float wr = twRe[k * stride];
+                float wi = twIm[k * stride];
+                size_t a = start + k;
+                size_t b = a + half;
+                float tr = re[b] * wr - im[b] * wi;
+                float ti = re[b] * wi + im[b] * wr;
+                re[b] = re[a] - tr;
+                im[b] = im[a] - ti;
+                re[a] += tr;
+                im[a] += ti;
+            }
+        }
+    }
+}
+
+}  // namespace
+
+VoiceActivityDetector::VoiceActivityDetector(const VadOptions& options)
+    : options_(options), window_(kFrameSize), twiddleRe_(kFrameSize / 2), twiddleIm_(kFrameSize / 2) {
+    for (size_t i = 0; i < kFrameSize; i++) {
+        window_[i] = 0.5f - 0.5f * std::cos(2.0f * kPi * i / (kFrameSize - 1));
+    }
+    for (size_t k = 0; k < kFrameSize / 2; k++) {
+        twiddleRe_[k] = std::cos(-2.0f * kPi * k / kFrameSize);
+        twiddleIm_[k] = std::sin(-2.0f * kPi * k / kFrameSize);
+    }
+}
+
+VadFeatures VoiceActivityDetector::ComputeFeatures(const float* frame) const {
+    VadFeatures f;
+    f.rms = std::sqrt(SumSquares(frame, kFrameSize) / kFrameSize);
+    f.zcr = static_cast<float>(CountZeroCrossings(frame, kFrameSize)) / (kFrameSize - 1);
+
+    // Geometric over arithmetic mean of the power spectrum
+    float re[kFrameSize];
+    float im[kFrameSize] = {};
+    float power[kFrameSize / 2];
+    MultiplyInto(frame, window_.data(), re, kFrameSize);
+    Fft(re, im, kFrameSize, twiddleRe_.data(), twiddleIm_.data());
+    PowerInto(re, im, power, kFrameSize / 2);
+
+    const float eps = 1e-10f;
+    double logSum = 0.0;
+    double sum = 0.0;
+    for (size_t k = kBandLow; k < kBandHigh; k++) {
+        logSum += std::log(power[k] + eps);
+        sum += power[k] + eps;
+    }
+    double bins = static_cast<double>(kBandHigh - kBandLow);
+    f.flatness = static_cast<float>(std::exp(logSum / bins) / (sum / bins));
+    return f;
+}
+
+bool VoiceActivityDetector::Classify(const VadFeatures& f, float noiseFloor) const {
+    return f.rms > options_.minRms &&
+           f.rms > noiseFloor * options_.energyRatio &&
+           f.flatness < options_.maxFlatness &&
+           f.zcr < options_.maxZcr;
+}
+
+VadResult VoiceActivityDetector::Analyze(const float* samples, size_t count) const {
+    VadResult result;
+    size_t frames = count / kFrameSize;
+    if (frames == 0) return result;
+
+    std::vector<VadFeatures> features(frames);
+    std::vector<float> levels(frames);
+    double rmsSum = 0.0;
+    for (size_t i = 0; i < frames; i++) {
+        features[i] = ComputeFeatures(samples + i * kFrameSize);
+        levels[i] = features[i].rms;
+        rmsSum += features[i].rms;
+    }
+
+    // Background level: the 10th percentile frame
+    auto nth = levels.begin() + frames / 10;
+    std::nth_element(levels.begin(), nth, levels.end());
+
+    result.frames = frames;
+    result.noiseFloor = *nth;
+    result.meanRms = static_cast<float>(rmsSum / frames);
+    for (const VadFeatures& f : features) {
+        if (Classify(f, result.noiseFloor)) result.voicedFrames++;
+    }
+    return result;
+}
+
+bool VoiceActivityDetector::IsVoiced(const float* frame) {
+    VadFeatures f = ComputeFeatures(frame);
+
+    // Track the floor down quickly and up slowly
+    if (noiseFloor_ == 0.0f || f.rms < noiseFloor_) {
+        noiseFloor_ = f.rms;
+    } else {
+        noiseFloor_ += (f.rms - noiseFloor_) * 0.002f;
+    }
+
+    return Classify(f, noiseFloor_);
+}
+
+// analyzeVoiceActivity(path | Float32Array | Int16Array, { minRms?, energyRatio?, maxFlatness?, maxZcr? })
+// Samples must be 16 kHz mono; WAV files are converted on load.
+Napi::Value AnalyzeVoiceActivity(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    auto started = std::chrono::steady_clock::now();
+
+    std::vector<float> samples;
+    if (info.Length() >= 1 && info[0].IsString()) {
+        std::string error;
+        if (!ReadWavMono16k(info[0].As<Napi::String>().Utf8Value(), samples, error)) {
+            return env.Null();
+        }
+    } else if (info.Length() >= 1 && info[0].IsTypedArray() &&
+               info[0].As<Napi::TypedArray>().TypedArrayType() == napi_float32_array) {
+        Napi::Float32Array f32 = info[0].As<Napi::Float32Array>();
+        samples.assign(f32.Data(), f32.Data() + f32.ElementLength());
+    } else if (info.Length() >= 1 && info[0].IsTypedArray() &&
+               info[0].As<Napi::TypedArray>().TypedArrayType() == napi_int16_array) {
+        Napi::Int16Array i16 = info[0].As<Napi::Int16Array>();
+        Int16ToFloat(i16.Data(), i16.ElementLength(), samples);
+    } else {
+        Napi::TypeError::New(env, "Audio path, Float32Array or Int16Array expected").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    VadOptions options;
+    if (info.Length() >= 2 && info[1].IsObject()) {
+        Napi::Object opts = info[1].As<Napi::Object>();
+        auto floatOption = [&](const char* key, float& value) {
+            if (opts.Get(key).IsNumber()) value = opts.Get(key).As<Napi::Number>().FloatValue();
+        };
+        floatOption("minRms", options.minRms);
+        floatOption("energyRatio", options.energyRatio);
+        floatOption("maxFlatness", options.maxFlatness);
+        floatOption("maxZcr", options.maxZcr);
+    }
+
+    VadResult result = VoiceActivityDetector(options).Analyze(samples.data(), samples.size());
+
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("speechRatio", result.SpeechRatio());
+    obj.Set("frames", static_cast<double>(result.frames));
+    obj.Set("voicedFrames", static_cast<double>(result.voicedFrames));
+    obj.Set("meanRms", result.meanRms);
+    obj.Set("noiseFloor", result.noiseFloor);
+    obj.Set("durationMs", samples.size() * 1000.0 / kSttSampleRate);
+    obj.Set("elapsedUs", std::chrono::duration<double, std::micro>(
+        std::chrono::steady_clock::now() - started).count());
+    return obj;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <napi.h>
+#include <cstddef>
+#include <vector>
+
+// Per-frame features used to separate speech from silence and steady noise
+struct VadFeatures {
+    float rms;          // frame energy
+    float zcr;          // zero crossings per sample, 0..1
+    float flatness;     // spectral flatness over the speech band, 0 (tonal) .. 1 (white noise)
+};
+
+struct VadOptions {
+    float minRms = 0.01f;       // absolute floor (~ -40 dBFS)
+    float energyRatio = 3.0f;   // required margin above the noise floor
+    float maxFlatness = 0.55f;  // noise-like spectra above this are rejected
+    float maxZcr = 0.45f;       // broadband hiss crosses zero almost every sample
+};
+
+struct VadResult {
+    size_t frames = 0;
+    size_t voicedFrames = 0;
+    float meanRms = 0.0f;
+    float noiseFloor = 0.0f;
+
+    float SpeechRatio() const { return frames ? static_cast<float>(voicedFrames) / frames : 0.0f; }
+};
+
+// Voice activity detector for 16 kHz mono audio in 32 ms frames. Energy,
+// zero-crossing and windowing/power loops are vectorized with SSE2 or NEON.
+class VoiceActivityDetector {
+public:
+    static constexpr size_t kFrameSize = 512;
+
+    explicit VoiceActivityDetector(const VadOptions& options = VadOptions());
+
+    VadFeatures ComputeFeatures(const float* frame) const;
+
+    // Whole-buffer scoring; the noise floor is estimated from the quietest frames
+    VadResult Analyze(const float* samples, size_t count) const;
+
+    // Streaming classification with an adaptive noise floor
+    bool IsVoiced(const float* frame);
+    void Reset() { noiseFloor_ = 0.0f; }
+
+private:
+    VadOptions options_;
+    std::vector<float> window_;     // Hann window
+    std::vector<float> twiddleRe_;
+    std::vector<float> twiddleIm_;
+    float noiseFloor_ = 0.0f;
+
+    bool Classify(const VadFeatures& f, float noiseFloor) const;
+};
+
+// analyzeVoiceActivity(pathOrSamples, options?) exported from the addon
+Napi::Value AnalyzeVoiceActivity(const Napi::CallbackInfo& info);
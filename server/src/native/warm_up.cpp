@@ -0,0 +1,354 @@
+#include "warm_up.hpp"
+#include "worker_support.hpp"
+#include <cstring>
+#include <functional>
+#include <map>
+
+namespace {
+
+using AsyncGet = std::function<int32_t(Device::RxDataCallback)>;
+
+// Marks an output struct as not yet written
+constexpr uint8_t kUnfilled = 0xA5;
+
+bool Filled(const void* out, size_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(out);
+    for (size_t i = 0; i < size; i++) {
+        if (bytes[i] != kUnfilled) return true;
+    }
+    return false;
+}
+
+// Sends one NonBlock read into out; its reply moves name from pending to
+// received or failed. dev.hpp only documents rcvd_data for async replies, and
+// its payload layout isn't specified, so whether the SDK also filled out is
+// checked: out is pre-set to a marker, and a reply that left it untouched
+// goes to unfilled, to be read again blocking.
+void Issue(const std::shared_ptr<WarmReplies>& replies, const std::string& name, void* out,
+           size_t size, const AsyncGet& get) {
+    {
+        std::lock_guard<std::mutex> lock(replies->mutex);
+        replies->pending.insert(name);
+        std::memset(out, kUnfilled, size);
+    }
+    Device::RxDataCallback callback = [replies, name, out, size](void*, const void* data) {
+        // The first byte is the reply's length, or an error code when negative
+        const bool ok = data && static_cast<const int8_t*>(data)[0] >= 0;
+        std::lock_guard<std::mutex> lock(replies->mutex);
+        if (!replies->pending.erase(name)) return;
+        if (!ok) {
+            replies->failed.insert(name);
+        } else {
+            (Filled(out, size) ? replies->received : replies->unfilled).insert(name);
+        }
+        replies->cv.notify_all();
+    };
+    if (get(callback) != 0) {
+        // Never sent, so never answered
+        std::lock_guard<std::mutex> lock(replies->mutex);
+        if (replies->pending.erase(name)) replies->failed.insert(name);
+    }
+}
+
+// Records a blocking read's result alongside the NonBlock ones
+void Record(WarmReplies& replies, const std::string& name, bool ok) {
+    std::lock_guard<std::mutex> lock(replies.mutex);
+    (ok ? replies.received : replies.failed).insert(name);
+}
+
+// Waits until every read sent so far is answered, or the deadline
+void Await(WarmReplies& replies, std::chrono::steady_clock::time_point deadline) {
+    std::unique_lock<std::mutex> lock(replies.mutex);
+    replies.cv.wait_until(lock, deadline, [&replies] {
+        return replies.pending.empty() || replies.stopping;
+    });
+}
+
+struct WarmUpResult {
+    ObsbotProductType productType;
+    WarmSnapshot snapshot;
+    std::vector<Napi::Promise::Deferred> deferreds;
+};
+
+// Resolve everyone waiting on the warm-up on the JS thread
+void SettleWarmUp(Napi::Env env, Napi::Function, WarmUpResult* result) {
+    Napi::Object obj = DeviceWarmUp::ToObject(env, result->productType, result->snapshot);
+    for (auto& deferred : result->deferreds) {
+        deferred.Resolve(obj);
+    }
+    delete result;
+}
+
+}  // namespace
+
+Napi::Object CameraStatusObject(Napi::Env env, ObsbotProductType productType,
+                                const Device::CameraStatus* tiny, const Device::AiStatus* ai) {
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("productType", static_cast<int>(productType));
+    if (tiny) {
+        obj.Set("aiMode", static_cast<int>(tiny->tiny.ai_mode));
+        obj.Set("aiSubMode", static_cast<int>(tiny->tiny.ai_sub_mode));
+        obj.Set("hdr", static_cast<int>(tiny->tiny.hdr));
+        obj.Set("fov", static_cast<int>(tiny->tiny.fov));
+        obj.Set("zoomRatio", static_cast<int>(tiny->tiny.zoom_ratio));
+        obj.Set("antiFlicker", static_cast<int>(tiny->tiny.anti_flicker));
+        obj.Set("faceAutoFocus", tiny->tiny.face_auto_focus != 0);
+        obj.Set("autoFocus", tiny->tiny.auto_focus != 0);
+        obj.Set("imageFlipHor", tiny->tiny.image_flip_hor != 0);
+        obj.Set("aiTrackerSpeed", static_cast<int>(tiny->tiny.ai_tracker_speed));
+    }
+    if (ai) {
+        obj.Set("gestureTarget", ai->gesture_target);
+        obj.Set("gestureZoom", ai->gesture_zoom);
+        obj.Set("gestureDynamicZoom", ai->gesture_dynamic_zoom);
+    }
+    return obj;
+}
+
+Napi::Object GimbalStateObject(Napi::Env env, const Device::AiGimbalStateInfo& state) {
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("pitch", state.pitch_euler);
+    obj.Set("yaw", state.yaw_euler);
+    obj.Set("roll", state.roll_euler);
+    obj.Set("motorPitch", state.pitch_motor);
+    obj.Set("motorYaw", state.yaw_motor);
+    obj.Set("motorRoll", state.roll_motor);
+    return obj;
+}
+
+Napi::Object PresetObject(Napi::Env env, const Device::PresetPosInfo& preset) {
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("id", preset.id);
+    obj.Set("pitch", preset.pitch);
+    obj.Set("yaw", preset.yaw);
+    obj.Set("roll", preset.roll);
+    obj.Set("zoom", preset.zoom);
+    obj.Set("name", std::string(preset.name));
+    return obj;
+}
+
+DeviceWarmUp::DeviceWarmUp(Napi::Env env, std::shared_ptr<Device> device,
+                           ShadowRegisters& shadow, CapabilityCache& caps, bool tinySeries)
+    : device_(std::move(device)), shadow_(shadow), caps_(caps), tinySeries_(tinySeries) {
+    tsfn_ = MakeResultTsfn(env, "DeviceWarmUpResult");
+}
+
+DeviceWarmUp::~DeviceWarmUp() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (replies_) {
+            std::lock_guard<std::mutex> repliesLock(replies_->mutex);
+            replies_->stopping = true;
+            replies_->cv.notify_all();
+        }
+    }
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    tsfn_.Release();
+}
+
+Napi::Promise DeviceWarmUp::Start(Napi::Env env, int timeoutMs) {
+    auto deferred = Napi::Promise::Deferred::New(env);
+    std::lock_guard<std::mutex> lock(mutex_);
+    waiting_.push_back(deferred);
+    if (!running_) {
+        running_ = true;
+        replies_ = std::make_shared<WarmReplies>();
+        RestartWorker(thread_, &DeviceWarmUp::Run, this, timeoutMs);
+    }
+    return deferred.Promise();
+}
+
+std::optional<std::vector<Device::PresetPosInfo>> DeviceWarmUp::Presets() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return presets_;
+}
+
+void DeviceWarmUp::InvalidatePresets() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    presets_.reset();
+    presetGeneration_++;
+}
+
+Napi::Object DeviceWarmUp::ToObject(Napi::Env env, ObsbotProductType productType,
+                                    const WarmSnapshot& snapshot) {
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("ready", snapshot.ready);
+    obj.Set("durationMs", snapshot.durationMs);
+    obj.Set("status", CameraStatusObject(env, productType,
+                                         snapshot.status ? &*snapshot.status : nullptr,
+                                         snapshot.ai ? &*snapshot.ai : nullptr));
+    obj.Set("zoom", snapshot.zoom ? Napi::Number::New(env, *snapshot.zoom) : env.Null());
+    obj.Set("gimbal", snapshot.gimbal ? Napi::Value(GimbalStateObject(env, *snapshot.gimbal))
+                                      : env.Null());
+    if (snapshot.presets) {
+        Napi::Array presets = Napi::Array::New(env, snapshot.presets->size());
+        for (size_t i = 0; i < snapshot.presets->size(); i++) {
+            presets[i] = PresetObject(env, (*snapshot.presets)[i]);
+        }
+        obj.Set("presets", presets);
+    } else {
+        obj.Set("presets", env.Null());
+    }
+    obj.Set("bootPosition", snapshot.bootPosition
+                                ? Napi::Value(PresetObject(env, *snapshot.bootPosition))
+                                : env.Null());
+    obj.Set("capabilities", snapshot.capabilities);
+
+    auto names = [env](const std::vector<std::string>& list) {
+        Napi::Array arr = Napi::Array::New(env, list.size());
+        for (size_t i = 0; i < list.size(); i++) arr[i] = list[i];
+        return arr;
+    };
+    obj.Set("failed", names(snapshot.failed));
+    obj.Set("timedOut", names(snapshot.timedOut));
+    return obj;
+}
+
+void DeviceWarmUp::Run(int timeoutMs) {
+    const auto start = Clock::now();
+    const auto deadline = start + std::chrono::milliseconds(timeoutMs);
+    std::shared_ptr<WarmReplies> replies;
+    int generation;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        replies = replies_;
+        generation = presetGeneration_;
+    }
+    WarmReplies& r = *replies;
+    // A replugged camera may have been changed while it was away
+    shadow_.InvalidateAll();
+
+    // Blocking versions of the NonBlock reads, for replies that left their struct unfilled
+    std::map<std::string, std::function<int32_t()>> blocking;
+    auto refill = [&] {
+        std::set<std::string> names;
+        {
+            std::lock_guard<std::mutex> lock(r.mutex);
+            names.swap(r.unfilled);
+        }
+        for (const std::string& name : names) {
+            Record(r, name, blocking[name]() == 0);
+        }
+    };
+
+    // The NonBlock reads go out first, so the device answers them while the
+    // blocking-only reads below are on the wire
+    blocking["aiStatus"] = [&] { return device_->aiGetAiStatusR(&r.ai); };
+    Issue(replies, "aiStatus", &r.ai, sizeof(r.ai), [&](Device::RxDataCallback cb) {
+        return device_->aiGetAiStatusR(&r.ai, cb, nullptr, Device::NonBlock);
+    });
+    blocking["gimbal"] = [&] { return device_->aiGetGimbalStateR(&r.gimbal); };
+    Issue(replies, "gimbal", &r.gimbal, sizeof(r.gimbal), [&](Device::RxDataCallback cb) {
+        return device_->aiGetGimbalStateR(&r.gimbal, cb, nullptr, Device::NonBlock);
+    });
+    blocking["bootPosition"] = [&] { return device_->aiGetGimbalBootPosR(&r.bootPosition); };
+    Issue(replies, "bootPosition", &r.bootPosition, sizeof(r.bootPosition),
+          [&](Device::RxDataCallback cb) {
+        return device_->aiGetGimbalBootPosR(&r.bootPosition, cb, nullptr, Device::NonBlock);
+    });
+    blocking["presetList"] = [&] { return device_->aiGetGimbalPresetListR(&r.presetIds); };
+    Issue(replies, "presetList", &r.presetIds, sizeof(r.presetIds),
+          [&](Device::RxDataCallback cb) {
+        return device_->aiGetGimbalPresetListR(&r.presetIds, cb, nullptr, Device::NonBlock);
+    });
+
+    WarmSnapshot snapshot;
+    Device::CameraStatus status;
+    if (tinySeries_) {
+        const bool ok = device_->cameraGetCameraStatusU(status) == 0;
+        Record(r, "status", ok);
+        if (ok) snapshot.status = status;
+    }
+    float zoom;
+    if (device_->cameraGetZoomAbsoluteR(zoom) == 0) {
+        Record(r, "zoom", true);
+        shadow_.Observe(Register::Zoom, {zoom});
+        snapshot.zoom = zoom;
+    } else {
+        Record(r, "zoom", false);
+    }
+    snapshot.capabilities = caps_.Fill();
+    Record(r, "capabilities", snapshot.capabilities);
+
+    // Each preset's position needs its id from the list
+    Await(r, deadline);
+    refill();
+    bool listed;
+    std::vector<int32_t> ids;
+    {
+        std::lock_guard<std::mutex> lock(r.mutex);
+        listed = r.received.count("presetList") > 0;
+    }
+    if (listed) {
+        std::lock_guard<std::mutex> lock(r.mutex);
+        ids.assign(r.presetIds.data_int32, r.presetIds.data_int32 + r.presetIds.len);
+        r.presets.assign(ids.size(), Device::PresetPosInfo{});
+    }
+    // The tiny and tiny 4K only answer the preset info read synchronously
+    const ObsbotProductType productType = device_->productType();
+    const bool blockingPresets =
+        productType == ObsbotProdTiny || productType == ObsbotProdTiny4k;
+    for (size_t i = 0; i < ids.size() && Clock::now() < deadline; i++) {
+        const std::string name = "preset:" + std::to_string(ids[i]);
+        Device::PresetPosInfo* info = &r.presets[i];
+        if (blockingPresets) {
+            Record(r, name, device_->aiGetGimbalPresetInfoWithIdR(info, ids[i]) == 0);
+            continue;
+        }
+        const int32_t id = ids[i];
+        blocking[name] = [this, info, id] {
+            return device_->aiGetGimbalPresetInfoWithIdR(info, id);
+        };
+        Issue(replies, name, info, sizeof(*info), [&](Device::RxDataCallback cb) {
+            return device_->aiGetGimbalPresetInfoWithIdR(info, id, cb, nullptr,
+                                                         Device::NonBlock);
+        });
+    }
+    Await(r, deadline);
+    refill();
+
+    {
+        std::lock_guard<std::mutex> lock(r.mutex);
+        auto got = [&r](const char* name) { return r.received.count(name) > 0; };
+        if (got("aiStatus")) snapshot.ai = r.ai;
+        if (got("gimbal")) snapshot.gimbal = r.gimbal;
+        if (got("bootPosition")) snapshot.bootPosition = r.bootPosition;
+
+        // A list missing a preset is worse than none; getPresetList re-reads
+        bool allPresets = listed;
+        for (size_t i = 0; i < ids.size() && allPresets; i++) {
+            allPresets = r.received.count("preset:" + std::to_string(ids[i])) > 0;
+        }
+        if (allPresets) {
+            snapshot.presets = r.presets;
+            for (size_t i = 0; i < ids.size(); i++) (*snapshot.presets)[i].id = ids[i];
+        }
+
+        snapshot.failed.assign(r.failed.begin(), r.failed.end());
+        snapshot.timedOut.assign(r.pending.begin(), r.pending.end());
+        // Preset reads the deadline cut off before they were sent
+        for (int32_t id : ids) {
+            const std::string name = "preset:" + std::to_string(id);
+            if (!r.received.count(name) && !r.failed.count(name) && !r.pending.count(name)) {
+                snapshot.timedOut.push_back(name);
+            }
+        }
+    }
+    snapshot.ready = snapshot.timedOut.empty();
+    snapshot.durationMs =
+        std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    auto* result = new WarmUpResult();
+    result->productType = productType;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (snapshot.presets && generation == presetGeneration_) presets_ = snapshot.presets;
+        running_ = false;
+        replies_.reset();
+        result->snapshot = std::move(snapshot);
+        result->deferreds.swap(waiting_);
+    }
+    tsfn_.NonBlockingCall(result, SettleWarmUp);
+}
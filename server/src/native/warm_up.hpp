@@ -0,0 +1,94 @@
+#pragma once
+
+#include <napi.h>
+#include <dev/dev.hpp>
+#include "capability_cache.hpp"
+#include "shadow_registers.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+// What a warm-up read. Unset fields are reads that failed or went unanswered.
+struct WarmSnapshot {
+    std::optional<Device::CameraStatus> status;     // tiny series only
+    std::optional<Device::AiStatus> ai;
+    std::optional<Device::AiGimbalStateInfo> gimbal;
+    std::optional<float> zoom;
+    std::optional<std::vector<Device::PresetPosInfo>> presets;
+    std::optional<Device::PresetPosInfo> bootPosition;
+    bool capabilities = false;                        // every range cached
+    std::vector<std::string> failed;                  // answered with an error
+    std::vector<std::string> timedOut;                // not answered by the deadline
+    bool ready = false;
+    double durationMs = 0;
+};
+
+// Replies to NonBlock reads. The SDK's copies of the callbacks share it, so a
+// reply that arrives after the deadline still has somewhere to land.
+struct WarmReplies {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::set<std::string> pending, received, failed;
+    std::set<std::string> unfilled;                 // answered, but the struct was left untouched
+    bool stopping = false;
+
+    Device::AiStatus ai = {};
+    Device::AiGimbalStateInfo gimbal = {};
+    Device::PresetPosInfo bootPosition = {};
+    Device::DevDataArray presetIds = {};
+    std::vector<Device::PresetPosInfo> presets;      // sized before the info reads go out
+};
+
+// Reads everything the dashboard's first load needs right after a device
+// connects, on a background thread: the AI status, gimbal state, boot
+// position and preset list go out as NonBlock requests where the SDK has
+// them, and the blocking-only reads (camera status, zoom, parameter ranges)
+// run while those are answered. Fills the capability cache, the zoom shadow
+// register and a preset cache; the snapshot is ready once every read has
+// been answered, failed ones included (a product without that feature).
+class DeviceWarmUp {
+public:
+    DeviceWarmUp(Napi::Env env, std::shared_ptr<Device> device, ShadowRegisters& shadow,
+                 CapabilityCache& caps, bool tinySeries);
+    ~DeviceWarmUp();
+
+    // Resolves the snapshot once every read has been answered or timeoutMs has
+    // passed. A warm-up already running is joined rather than started again.
+    Napi::Promise Start(Napi::Env env, int timeoutMs);
+    // The preset list a warm-up read, until a preset is added or deleted
+    std::optional<std::vector<Device::PresetPosInfo>> Presets();
+    void InvalidatePresets();
+
+    static Napi::Object ToObject(Napi::Env env, ObsbotProductType productType,
+                                 const WarmSnapshot& snapshot);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    std::shared_ptr<Device> device_;
+    ShadowRegisters& shadow_;
+    CapabilityCache& caps_;
+    const bool tinySeries_;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::vector<Napi::Promise::Deferred> waiting_;
+    std::shared_ptr<WarmReplies> replies_;   // the running warm-up's
+    bool running_ = false;
+    std::optional<std::vector<Device::PresetPosInfo>> presets_;
+    int presetGeneration_ = 0;               // bumped by InvalidatePresets
+    Napi::ThreadSafeFunction tsfn_;
+
+    void Run(int timeoutMs);
+};
+
+// The objects getCameraStatus, getGimbalState and getPresetList return
+Napi::Object CameraStatusObject(Napi::Env env, ObsbotProductType productType,
+                                const Device::CameraStatus* tiny, const Device::AiStatus* ai);
+Napi::Object GimbalStateObject(Napi::Env env, const Device::AiGimbalStateInfo& state);
+Napi::Object PresetObject(Napi::Env env, const Device::PresetPosInfo& preset);
@@ -0,0 +1,115 @@
+#include "wav_reader.hpp"
+#include <cstring>
+#include <fstream>
+
+namespace {
+
+uint32_t ReadLE32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+uint16_t ReadLE16(const uint8_t* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+}  // namespace
+
+void Int16ToFloat(const int16_t* in, size_t count, std::vector<float>& out) {
+    out.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        out[i] = static_cast<float>(in[i]) / 32768.0f;
+    }
+}
+
+bool ReadWavMono16k(const std::string& path, std::vector<float>& samples, std::string& error) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        error = "Failed to open " + path;
+        return false;
+    }
+
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (data.size() < 12 || memcmp(data.data(), "RIFF", 4) != 0 || memcmp(data.data() + 8, "WAVE", 4) != 0) {
+        error = "Not a RIFF/WAVE file";
+        return false;
+    }
+
+    uint16_t format = 0, channels = 0, bitsPerSample = 0;
+    uint32_t sampleRate = 0;
+    size_t dataOffset = 0, dataSize = 0;
+
+    // Walk the chunk list looking for "fmt " and "data"
+    size_t pos = 12;
+    while (pos + 8 <= data.size()) {
+        const uint8_t* chunk = data.data() + pos;
+        uint32_t chunkSize = ReadLE32(chunk + 4);
+        size_t body = pos + 8;
+
+        if (memcmp(chunk, "fmt ", 4) == 0 && body + 16 <= data.size()) {
+            format = ReadLE16(data.data() + body);
+            channels = ReadLE16(data.data() + body + 2);
+            sampleRate = ReadLE32(data.data() + body + 4);
+            bitsPerSample = ReadLE16(data.data() + body + 14);
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            dataOffset = body;
+            // Unfinalized files report 0 or 0xFFFFFFFF; use whatever is on disk
+            size_t available = data.size() - body;
+            dataSize = (chunkSize == 0 || chunkSize > available) ? available : chunkSize;
+            break;
+        }
+
+        pos = body + chunkSize + (chunkSize & 1);
+    }
+
+    if (dataOffset == 0 || channels == 0 || sampleRate == 0) {
+        error = "Missing fmt or data chunk";
+        return false;
+    }
+
+    // 1 = PCM, 3 = IEEE float, 0xFFFE = extensible (assume PCM/float by bit depth)
+    bool isFloat = format == 3 || (format == 0xFFFE && bitsPerSample == 32);
+    if (!(bitsPerSample == 16 && !isFloat) && !(bitsPerSample == 32 && isFloat)) {
+        error = "Unsupported WAV format (need PCM16 or float32)";
+        return false;
+    }
+
+    size_t bytesPerFrame = static_cast<size_t>(bitsPerSample / 8) * channels;
+    size_t frames = dataSize / bytesPerFrame;
+    const uint8_t* src = data.data() + dataOffset;
+
+    std::vector<float> mono(frames);
+    for (size_t i = 0; i < frames; i++) {
+        float sum = 0.0f;
+        for (uint16_t c = 0; c < channels; c++) {
+            const uint8_t* p = src + i * bytesPerFrame + c * (bitsPerSample / 8);
+            if (isFloat) {
+                float v;
+                memcpy(&v, p, sizeof(v));
+                sum += v;
+            } else {
+                sum += static_cast<int16_t>(ReadLE16(p)) / 32768.0f;
+            }
+        }
+        mono[i] = sum / channels;
+    }
+
+    if (sampleRate == static_cast<uint32_t>(kSttSampleRate)) {
+        samples = std::move(mono);
+        return true;
+    }
+
+    // Linear resample to 16 kHz
+    double ratio = static_cast<double>(sampleRate) / kSttSampleRate;
+    size_t outFrames = static_cast<size_t>(frames / ratio);
+    samples.resize(outFrames);
+    for (size_t i = 0; i < outFrames; i++) {
+        double srcPos = i * ratio;
+        size_t idx = static_cast<size_t>(srcPos);
+        double frac = srcPos - idx;
+        float a = mono[idx];
+        float b = idx + 1 < frames ? mono[idx + 1] : a;
+        samples[i] = static_cast<float>(a + (b - a) * frac);
+    }
+    return true;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Sample rate expected by whisper (16 kHz mono)
+constexpr int kSttSampleRate = 16000;
+
+// Read a PCM16 / float32 WAV file, downmix to mono and resample to 16 kHz.
+// Tolerates the placeholder sizes splitmuxsink leaves in files that are still
+// being written by reading up to the end of the file.
+bool ReadWavMono16k(const std::string& path, std::vector<float>& samples, std::string& error);
+
+// Convert signed 16-bit mono PCM to normalized floats
+void Int16ToFloat(const int16_t* in, size_t count, std::vector<float>& out);
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <napi.h>
+#include <thread>
+#include <utility>
+
+// TSFN for a native worker's results. Each result is delivered through
+// NonBlockingCall with its own callback, so the JS function is unused. Unref'd,
+// so a worker doesn't keep the event loop alive.
+inline Napi::ThreadSafeFunction MakeResultTsfn(Napi::Env env, const char* name) {
+    Napi::ThreadSafeFunction tsfn = Napi::ThreadSafeFunction::New(
+        env,
+        Napi::Function::New(env, [](const Napi::CallbackInfo&) {}),
+        name,
+        0,
+        1
+    );
+    tsfn.Unref(env);
+    return tsfn;
+}
+
+// Starts a worker thread for one run. The previous run's thread has nothing
+// left to do by the time a new run is started, so it is joined first.
+template <typename... Args>
+void RestartWorker(std::thread& thread, Args&&... args) {
+    if (thread.joinable()) thread.join();
+    thread = std::thread(std::forward<Args>(args)...);
+}
@@ -1,20 +1,77 @@
-import * as path from 'path';
-
-// Load native addon
-let obsbot: any;
-try {
-  // We expect the build to be in the root's build/Release folder
-  obsbot = require('../../build/Release/obsbot_native.node');
-} catch (e) {
-  console.error('Failed to load native addon:', e);
-  obsbot = null;
+import { EventEmitter } from 'events';
+import { obsbot } from './native';
+import { capabilityStore } from './capabilities';
+
+// A setting write held by coalescing and sent when its window ends; the SDK
+// itself answers 0 (ok) or -1
+export const WRITE_QUEUED = 1;
+
+// Commands that pan, tilt or zoom the camera, or end such a move
+const MOVE_COMMANDS = new Set([
+  'gimbal-set-speed',
+  'gimbal-input',
+  'gimbal-stop',
+  'gimbal-set-angle',
+  'gimbal-move',
+  'gimbal-move-cancel',
+  'gimbal-reset',
+  'zoom-set',
+  'preset-trigger',
+  'preset-move',
+]);
+
+export interface TargetBox {
+  xMin: number;
+  yMin: number;
+  xMax: number;
+  yMax: number;
 }
 
-export class CameraService {
+/**
+ * The selected camera. When one connects, a native warm-up reads what the
+ * dashboard's first load needs (status, zoom, gimbal, presets, parameter
+ * ranges) in one go, NonBlock where the SDK allows it, and fills the native
+ * caches. Until it finishes, getStatus() answers from what it has without
+ * touching the camera; afterwards it serves the warm-up's snapshot for
+ * WARM_UP_FRESH_MS, so the first paint after a replug costs no USB reads.
+ * Emits 'warm' when a warm-up finishes, 'status' with every camera status
+ * the device pushes (tiny series), 'move' when a command pans, tilts or
+ * zooms, and 'tracking' (boolean) when AI tracking, which moves the camera
+ * on its own, starts or stops. `ready` is only set when every warm-up read
+ * was answered.
+ */
+export class CameraService extends EventEmitter {
   private currentDevice: any = null;
   private initialized = false;
 
+  // Warm-up on connect
+  private warmUpTimeoutMs = parseInt(process.env.WARM_UP_TIMEOUT_MS || '2000');
+  private warmFreshMs = parseInt(process.env.WARM_UP_FRESH_MS || '2000');
+  private warming = false;
+  private ready = false;
+  private tracking = false;
+  private warm: { at: number; status: any; zoom: number | null; gimbal: any } | null = null;
+  private warmUps = 0;
+  private lastWarmUp: { durationMs: number; failed: string[]; timedOut: string[] } | null = null;
+
+  // Shaping of 'gimbal-input' joystick deflection (native, fixed rate)
+  private joystickOptions = {
+    rateHz: parseInt(process.env.JOYSTICK_RATE_HZ || '50'),
+    deadzone: parseFloat(process.env.JOYSTICK_DEADZONE || '0.05'),
+    expo: parseFloat(process.env.JOYSTICK_EXPO || '0.4'),
+    maxSpeed: parseFloat(process.env.JOYSTICK_MAX_SPEED || '50'),
+    maxAccel: parseFloat(process.env.JOYSTICK_MAX_ACCEL || '200'),
+    watchdogMs: parseInt(process.env.JOYSTICK_WATCHDOG_MS || '500'),
+  };
+  // How long a target selection may take to show up in the pushed status
+  private targetConfirmMs = parseInt(process.env.TARGET_CONFIRM_MS || '2000');
+  // How long a command's expected state may take to show up in the pushed status
+  private commandConfirmMs = parseInt(process.env.COMMAND_CONFIRM_MS || '3000');
+  // Writes to one setting closer together than this are collapsed to the latest
+  private writeCoalesceMs = parseInt(process.env.WRITE_COALESCE_MS || '50');
+
   constructor() {
+    super();
     this.initialize();
   }
 
@@ -31,6 +88,10 @@ export class CameraService {
           this.currentDevice.getDeviceInfo().serialNumber === event.serialNumber
         ) {
           this.currentDevice = null;
+          this.warming = false;
+          this.ready = false;
+          this.warm = null;
+          this.setTracking(false);
         }
       });
       this.initialized = true;
@@ -46,14 +107,82 @@ export class CameraService {
     if (devices && devices.length > 0) {
       this.currentDevice = devices[0];
       console.log('Selected device:', this.currentDevice.getDeviceInfo().serialNumber);
+      try {
+        this.currentDevice.configureJoystick(this.joystickOptions);
+      } catch (error: any) {
+        console.error('[Camera] Invalid joystick settings, using defaults:', error.message);
+      }
+      try {
+        this.currentDevice.configureWrites({ windowMs: this.writeCoalesceMs });
+      } catch (error: any) {
+        console.error('[Camera] Invalid WRITE_COALESCE_MS, using default:', error.message);
+      }
+      const device = this.currentDevice;
+      device.watchStatus((status: any) => {
+        if (device !== this.currentDevice) return;
+        this.setTracking(status.aiMode !== 0);
+        this.emit('status', status);
+      });
+      const seeded = capabilityStore.seed(device);
+      this.warmUp(device, seeded);
     }
   }
 
+  // Read the first load's state on the native worker and fill the caches
+  private async warmUp(device: any, capabilitiesSeeded: boolean) {
+    this.warming = true;
+    this.ready = false;
+    this.warm = null;
+    try {
+      const result = await device.warmUp({ timeoutMs: this.warmUpTimeoutMs });
+      if (device !== this.currentDevice) return; // replugged again meanwhile
+      this.warmUps++;
+      this.lastWarmUp = {
+        durationMs: Math.round(result.durationMs),
+        failed: result.failed,
+        timedOut: result.timedOut,
+      };
+      const { status, zoom, gimbal } = result;
+      this.warm = { at: Date.now(), status, zoom, gimbal };
+      this.ready = result.ready;
+      if (!capabilitiesSeeded) capabilityStore.save(device);
+      const outcome = result.ready
+        ? 'ready'
+        : `incomplete, no answer: ${result.timedOut.join(', ')}`;
+      console.log(`[Camera] Warm-up ${outcome} in ${this.lastWarmUp.durationMs}ms`);
+    } catch (error: any) {
+      console.error('[Camera] Warm-up failed:', error.message);
+    } finally {
+      if (device === this.currentDevice) {
+        this.warming = false;
+        this.emit('warm');
+      }
+    }
+  }
+
+  private setTracking(tracking: boolean) {
+    if (tracking === this.tracking) return;
+    this.tracking = tracking;
+    this.emit('tracking', tracking);
+  }
+
+  // The warm-up's snapshot, until it's WARM_UP_FRESH_MS old or a command goes out
+  private freshWarm() {
+    if (this.warm && Date.now() - this.warm.at >= this.warmFreshMs) this.warm = null;
+    return this.warm;
+  }
+
   public getStatus() {
     if (!this.currentDevice) return null;
     try {
+      const info = this.currentDevice.getDeviceInfo();
+      // Reads would queue behind the warm-up's; the dashboard shows it as connecting
+      if (this.warming) return { info, ready: false };
+      const warm = this.freshWarm();
+      if (warm) return { info, ready: this.ready, status: warm.status, zoom: warm.zoom };
       return {
-        info: this.currentDevice.getDeviceInfo(),
+        info,
+        ready: this.ready,
         status: this.currentDevice.getCameraStatus(),
         zoom: this.currentDevice.getZoom(),
       };
@@ -62,10 +191,45 @@ export class CameraService {
     }
   }
 
+  /**
+   * getStatus() and getGimbalState() together, read on the native settings
+   * thread so the JS thread never waits on the camera
+   */
+  public async readState() {
+    if (!this.currentDevice) return { camera: null, gimbal: null };
+    const device = this.currentDevice;
+    try {
+      const info = device.getDeviceInfo();
+      if (this.warming) return { camera: { info, ready: false }, gimbal: null };
+      const warm = this.freshWarm();
+      if (warm) {
+        const camera = { info, ready: this.ready, status: warm.status, zoom: warm.zoom };
+        return { camera, gimbal: warm.gimbal };
+      }
+      const { status, zoom, gimbal } = await device.readState();
+      return { camera: { info, ready: this.ready, status, zoom }, gimbal };
+    } catch (error) {
+      return { camera: null, gimbal: null };
+    }
+  }
+
+  /** The zoom last written or read, from the shadow register; null when unknown */
+  public getKnownZoom(): number | null {
+    if (!this.currentDevice) return null;
+    return this.currentDevice.getKnownZoom();
+  }
+
+  public getWarmUpStats() {
+    if (!this.currentDevice) return null;
+    return { ready: this.ready, warming: this.warming, runs: this.warmUps, last: this.lastWarmUp };
+  }
+
   public async executeCommand(type: string, payload: any) {
     if (!this.currentDevice) {
       throw new Error('No camera connected');
     }
+    this.warm = null;
+    if (MOVE_COMMANDS.has(type)) this.emit('move', type);
 
     switch (type) {
       case 'gimbal-set-speed':
@@ -74,6 +238,9 @@ export class CameraService {
           payload.pan || 0,
           payload.roll || 0
         );
+      case 'gimbal-input':
+        // Joystick deflection, -1..1; resend while held (watchdog stops the gimbal)
+        return this.currentDevice.setJoystick(payload.pitch || 0, payload.pan || 0);
       case 'gimbal-stop':
         return this.currentDevice.stopGimbal();
       case 'gimbal-set-angle':
@@ -82,13 +249,23 @@ export class CameraService {
           payload.yaw || 0,
           payload.roll || 0
         );
+      case 'gimbal-move':
+        // { pitch?, yaw?, roll?, zoom?, durationMs?, maxSpeed?, ... }: resolves on arrival
+        return this.arrive(this.currentDevice.moveTo(payload));
+      case 'gimbal-move-cancel':
+        return this.currentDevice.cancelMove();
       case 'gimbal-reset':
         return this.currentDevice.resetGimbalPosition();
       case 'zoom-set':
         return this.currentDevice.setZoom(payload.zoom);
+      case 'settings-apply':
+        // { brightness?, hdr?, exposure?: { mode?, value? }, wb?: { type?, value? }, ... }
+        return this.currentDevice.applySettings(payload);
       case 'ai-set-enabled':
+        this.setTracking(!!payload.enabled);
         return this.currentDevice.setAIEnabled(payload.enabled);
       case 'ai-set-mode':
+        this.setTracking(payload.mode !== 0); // AiWorkModeNone
         return this.currentDevice.setAIMode(payload.mode, payload.subMode || 0);
       case 'ai-set-gesture':
         return this.currentDevice.setGestureControl(payload.gesture, payload.enabled);
@@ -102,8 +279,13 @@ export class CameraService {
         return this.currentDevice.selectBiggestTarget();
       case 'ai-deselect':
         return this.currentDevice.deselectTarget();
+      case 'ai-select-box':
+        // { xMin, yMin, xMax, yMax }, normalized preview coordinates
+        return this.selectTargetByBox(payload);
       case 'preset-trigger':
         return this.currentDevice.triggerPreset(payload.id);
+      case 'preset-move':
+        return this.moveToPreset(payload.id, payload);
       case 'preset-add':
         return this.currentDevice.addPreset();
       default:
@@ -111,6 +293,120 @@ export class CameraService {
     }
   }
 
+  // Glide to a preset on a planned S-curve instead of the firmware's own move
+  private moveToPreset(id: number, options: { durationMs?: number; maxSpeed?: number }) {
+    const presets: any[] = this.currentDevice.getPresetList() || [];
+    const preset = presets.find((p) => p.id === id);
+    if (!preset || preset.pitch === undefined) {
+      throw new Error(`Unknown preset: ${id}`);
+    }
+    return this.arrive(
+      this.currentDevice.moveTo({
+        pitch: preset.pitch,
+        yaw: preset.yaw,
+        zoom: preset.zoom,
+        durationMs: options.durationMs,
+        maxSpeed: options.maxSpeed,
+      })
+    );
+  }
+
+  // A planned move lasts as long as it takes; 'move' again once it ends
+  private arrive<T>(move: Promise<T>): Promise<T> {
+    return move.finally(() => this.emit('move', 'arrived'));
+  }
+
+  // Select the target inside a box on the preview and wait for the pushed
+  // status to show it, rather than sleeping and polling for it
+  public async selectTargetByBox(box: TargetBox) {
+    if (!this.currentDevice) {
+      throw new Error('No camera connected');
+    }
+    const started = Date.now();
+    const { result, method, selected } = this.currentDevice.selectTargetByBox(
+      box.xMin,
+      box.yMin,
+      box.xMax,
+      box.yMax
+    );
+    if (!selected) {
+      // Rejected, or only an ROI view of the box: nothing is being tracked
+      return { result, method, selected, confirmed: false, elapsedMs: Date.now() - started };
+    }
+    const { confirmed, updates } = await this.currentDevice.waitForTarget(this.targetConfirmMs);
+    // confirmed is null where the status can't show the selection
+    return { result, method, selected, confirmed, updates, elapsedMs: Date.now() - started };
+  }
+
+  // Resolves when the pushed status shows field === value (names as in
+  // getCameraStatus). null when the camera's status has no such field.
+  public confirmStatus(
+    field: string,
+    value: number | boolean
+  ): Promise<{ confirmed: boolean; elapsedMs: number; updates: number }> | null {
+    if (!this.currentDevice) return null;
+    return this.currentDevice.waitForStatus(field, value, this.commandConfirmMs);
+  }
+
+  public getStatusWatchStats() {
+    if (!this.currentDevice) return null;
+    return this.currentDevice.getStatusWatchStats();
+  }
+
+  public getGimbalState() {
+    if (!this.currentDevice || this.warming) return null;
+    const warm = this.freshWarm();
+    if (warm) return warm.gimbal;
+    try {
+      return this.currentDevice.getGimbalState();
+    } catch (error) {
+      return null;
+    }
+  }
+
+  public getWriteStats() {
+    if (!this.currentDevice) return null;
+    return this.currentDevice.getWriteStats();
+  }
+
+  /** Read the live configuration into a profile blob, on the native worker */
+  public captureProfile(): Promise<Buffer> {
+    if (!this.currentDevice) {
+      throw new Error('No camera connected');
+    }
+    return this.currentDevice.captureProfile();
+  }
+
+  /** Write only the fields of a profile blob that differ from the live configuration */
+  public restoreProfile(data: Buffer) {
+    if (!this.currentDevice) {
+      throw new Error('No camera connected');
+    }
+    this.warm = null;
+    return this.currentDevice.restoreProfile(data);
+  }
+
+  /** Cached ranges; never queries the camera */
+  public getCapabilities() {
+    if (!this.currentDevice) return null;
+    return this.currentDevice.getCapabilities();
+  }
+
+  public getApplyStats() {
+    if (!this.currentDevice) return null;
+    return this.currentDevice.getApplyStats();
+  }
+
+  public getJoystickStats() {
+    if (!this.currentDevice) return null;
+    return this.currentDevice.getJoystickStats();
+  }
+
+  public getMoveState() {
+    if (!this.currentDevice) return null;
+    return this.currentDevice.getMoveState();
+  }
+
   public isRunning(): boolean {
     return this.currentDevice !== null;
   }
@@ -0,0 +1,65 @@
+import * as fs from 'fs';
+import * as path from 'path';
+
+// Bumped when what a saved descriptor means changes. Version 1 saved reads
+// that failed as ranges the camera doesn't have.
+const CACHE_VERSION = 2;
+
+/**
+ * Keeps each camera's capability descriptor (its parameter ranges) in
+ * CAPABILITY_CACHE, keyed by product type and firmware version, which fully
+ * determine it. A known camera is seeded from the file when it connects, so
+ * getCapabilities() answers at once without a single range query; an unknown
+ * one has its ranges read by the connect warm-up. Only ranges the camera
+ * answered for are saved; one whose read failed is read again next time.
+ */
+export class CapabilityStoreService {
+  private cacheFile =
+    process.env.CAPABILITY_CACHE || path.join(process.cwd(), 'recordings', 'capabilities.json');
+
+  /** Seed the device's capability cache from disk; true if that covered every range */
+  public seed(device: any): boolean {
+    const key = this.key(device.getCapabilities());
+    const cached = this.readCache()[key];
+    if (cached?.version !== CACHE_VERSION) return false;
+    if (device.seedCapabilities(cached) && cached.complete) {
+      console.log(`[Capabilities] Using cached ranges for ${key}`);
+      return true;
+    }
+    return false;
+  }
+
+  /** Save the ranges the device has answered for; complete once it answered them all */
+  public save(device: any) {
+    const caps = device.getCapabilities();
+    if (Object.keys(caps.ranges).length === 0) return;
+    this.writeCache(this.key(caps), { ...caps, version: CACHE_VERSION });
+    const state = caps.complete ? 'all ranges' : 'partial ranges';
+    console.log(`[Capabilities] Saved ${state} for ${this.key(caps)}`);
+  }
+
+  private key(caps: { productType: number; devVersion: string }) {
+    return `${caps.productType}:${caps.devVersion}`;
+  }
+
+  private readCache(): Record<string, any> {
+    try {
+      return JSON.parse(fs.readFileSync(this.cacheFile, 'utf8'));
+    } catch {
+      return {};
+    }
+  }
+
+  private writeCache(key: string, caps: any) {
+    const cache = this.readCache();
+    cache[key] = caps;
+    try {
+      fs.mkdirSync(path.dirname(this.cacheFile), { recursive: true });
+      fs.writeFileSync(this.cacheFile, JSON.stringify(cache, null, 2));
+    } catch (error) {
+      console.error(`[Capabilities] Failed to write ${this.cacheFile}:`, error);
+    }
+  }
+}
+
+export const capabilityStore = new CapabilityStoreService();
@@ -0,0 +1,610 @@
+import { spawn, spawnSync } from 'child_process';
+import * as fs from 'fs';
+import * as os from 'os';
+import * as path from 'path';
+
+export type EncoderBackend = 'nvenc' | 'vaapi' | 'v4l2m2m' | 'software' | 'openh264';
+export type VideoCodec = 'h264' | 'h265';
+export type EncoderFramework = 'gstreamer' | 'ffmpeg';
+
+/** A GStreamer encoder element and how its settings are spelled */
+export interface GstEncoder {
+  backend: EncoderBackend;
+  element: string;
+  presetProp: string | null;
+  presets: string[]; // best quality first
+  bitrateProp: string | null; // null: bitrate and GOP are V4L2 extra-controls
+  bitrateMultiplier: number; // kbps -> property units
+  gopProp: string | null;
+  lowLatency: string[]; // properties for the live encoder
+}
+
+/** An FFmpeg encoder and the arguments it needs */
+export interface FFmpegEncoder {
+  backend: EncoderBackend;
+  codec: string;
+  presets: string[]; // -preset values, best quality first
+  globalArgs: string[]; // before the inputs, e.g. the hardware device
+  pixelArgs: string[]; // frame format or upload for the encoder
+  lowLatency: string[];
+  quality: string[]; // recording rate control
+}
+
+export type Selected<T> = T & { preset: string | null; fps: number | null };
+
+interface Choice {
+  name: string; // element or codec
+  preset: string | null;
+  fps: number;
+}
+
+interface BenchResult {
+  codec: VideoCodec;
+  name: string;
+  preset: string | null;
+  fps: number | null; // null if the encoder failed
+}
+
+interface ProbeResult {
+  fingerprint: string;
+  probedAt: number;
+  targetFps: number;
+  headroom: number;
+  h264: Choice | null;
+  h265: Choice | null;
+  results: BenchResult[];
+}
+
+const VAAPI_DEVICE = process.env.VAAPI_DEVICE || '/dev/dri/renderD128';
+
+// Bumped when the benchmark changes, so cached results are measured again
+const BENCH_VERSION = 3;
+
+// Backends that leave the CPU to the rest of the server
+const isHardware = (backend: EncoderBackend) => backend !== 'software' && backend !== 'openh264';
+
+// Candidates in order of preference; hardware first
+const GST_ENCODERS: Record<VideoCodec, GstEncoder[]> = {
+  h264: [
+    {
+      backend: 'nvenc',
+      element: 'nvh264enc',
+      presetProp: 'preset',
+      presets: ['low-latency-hq', 'low-latency', 'low-latency-hp'],
+      bitrateProp: 'bitrate',
+      bitrateMultiplier: 1,
+      gopProp: 'gop-size',
+      lowLatency: ['zerolatency=true'],
+    },
+    {
+      backend: 'vaapi',
+      element: 'vah264enc',
+      presetProp: 'target-usage',
+      presets: ['4', '7'],
+      bitrateProp: 'bitrate',
+      bitrateMultiplier: 1,
+      gopProp: 'key-int-max',
+      lowLatency: ['b-frames=0'],
+    },
+    {
+      backend: 'vaapi',
+      element: 'vaapih264enc',
+      presetProp: 'quality-level',
+      presets: ['4', '7'],
+      bitrateProp: 'bitrate',
+      bitrateMultiplier: 1,
+      gopProp: 'keyframe-period',
+      lowLatency: ['max-bframes=0'],
+    },
+    {
+      backend: 'v4l2m2m',
+      element: 'v4l2h264enc',
+      presetProp: null,
+      presets: [],
+      bitrateProp: null,
+      bitrateMultiplier: 1000,
+      gopProp: null,
+      lowLatency: [],
+    },
+    {
+      backend: 'software',
+      element: 'x264enc',
+      presetProp: 'speed-preset',
+      presets: ['veryfast', 'superfast', 'ultrafast'],
+      bitrateProp: 'bitrate',
+      bitrateMultiplier: 1,
+      gopProp: 'key-int-max',
+      lowLatency: ['tune=zerolatency'],
+    },
+    {
+      backend: 'openh264',
+      element: 'openh264enc',
+      presetProp: 'complexity',
+      presets: ['high', 'medium', 'low'],
+      bitrateProp: 'bitrate',
+      bitrateMultiplier: 1000, // bps
+      gopProp: 'gop-size',
+      lowLatency: [],
+    },
+  ],
+  h265: [
+    {
+      backend: 'nvenc',
+      element: 'nvh265enc',
+      presetProp: 'preset',
+      presets: ['hq', 'default', 'hp'],
+      bitrateProp: 'bitrate',
+      bitrateMultiplier: 1,
+      gopProp: 'gop-size',
+      lowLatency: ['zerolatency=true'],
+    },
+    {
+      backend: 'vaapi',
+      element: 'vah265enc',
+      presetProp: 'target-usage',
+      presets: ['4', '7'],
+      bitrateProp: 'bitrate',
+      bitrateMultiplier: 1,
+      gopProp: 'key-int-max',
+      lowLatency: ['b-frames=0'],
+    },
+    {
+      backend: 'vaapi',
+      element: 'vaapih265enc',
+      presetProp: 'quality-level',
+      presets: ['4', '7'],
+      bitrateProp: 'bitrate',
+      bitrateMultiplier: 1,
+      gopProp: 'keyframe-period',
+      lowLatency: ['max-bframes=0'],
+    },
+    {
+      backend: 'v4l2m2m',
+      element: 'v4l2h265enc',
+      presetProp: null,
+      presets: [],
+      bitrateProp: null,
+      bitrateMultiplier: 1000,
+      gopProp: null,
+      lowLatency: [],
+    },
+    {
+      backend: 'software',
+      element: 'x265enc',
+      presetProp: 'speed-preset',
+      presets: ['veryfast', 'superfast', 'ultrafast'],
+      bitrateProp: 'bitrate',
+      bitrateMultiplier: 1,
+      gopProp: 'key-int-max',
+      lowLatency: ['tune=zerolatency'],
+    },
+  ],
+};
+
+const FFMPEG_ENCODERS: Record<VideoCodec, FFmpegEncoder[]> = {
+  h264: [
+    {
+      backend: 'nvenc',
+      codec: 'h264_nvenc',
+      presets: ['p4', 'p2', 'p1'],
+      globalArgs: [],
+      pixelArgs: ['-pix_fmt', 'yuv420p'],
+      lowLatency: ['-tune', 'll', '-zerolatency', '1', '-delay', '0', '-forced-idr', '1'],
+      quality: ['-cq', '23'],
+    },
+    {
+      backend: 'vaapi',
+      codec: 'h264_vaapi',
+      presets: [],
+      globalArgs: ['-vaapi_device', VAAPI_DEVICE],
+      pixelArgs: ['-vf', 'format=nv12,hwupload'],
+      lowLatency: ['-bf', '0'],
+      quality: ['-qp', '23'],
+    },
+    {
+      backend: 'v4l2m2m',
+      codec: 'h264_v4l2m2m',
+      presets: [],
+      globalArgs: [],
+      pixelArgs: ['-pix_fmt', 'yuv420p'],
+      lowLatency: [],
+      quality: ['-b:v', '8M'],
+    },
+    {
+      backend: 'software',
+      codec: 'libx264',
+      presets: ['veryfast', 'superfast', 'ultrafast'],
+      globalArgs: [],
+      pixelArgs: ['-pix_fmt', 'yuv420p'],
+      lowLatency: ['-tune', 'zerolatency'],
+      quality: ['-crf', '23'],
+    },
+    {
+      backend: 'openh264',
+      codec: 'libopenh264',
+      presets: [],
+      globalArgs: [],
+      pixelArgs: ['-pix_fmt', 'yuv420p'],
+      lowLatency: [],
+      quality: ['-b:v', '8M'],
+    },
+  ],
+  h265: [
+    {
+      backend: 'nvenc',
+      codec: 'hevc_nvenc',
+      presets: ['p4', 'p2', 'p1'],
+      globalArgs: [],
+      pixelArgs: ['-pix_fmt', 'yuv420p'],
+      lowLatency: ['-tune', 'll', '-zerolatency', '1', '-delay', '0', '-forced-idr', '1'],
+      quality: ['-cq', '23'],
+    },
+    {
+      backend: 'vaapi',
+      codec: 'hevc_vaapi',
+      presets: [],
+      globalArgs: ['-vaapi_device', VAAPI_DEVICE],
+      pixelArgs: ['-vf', 'format=nv12,hwupload'],
+      lowLatency: ['-bf', '0'],
+      quality: ['-qp', '25'],
+    },
+    {
+      backend: 'v4l2m2m',
+      codec: 'hevc_v4l2m2m',
+      presets: [],
+      globalArgs: [],
+      pixelArgs: ['-pix_fmt', 'yuv420p'],
+      lowLatency: [],
+      quality: ['-b:v', '15M'],
+    },
+    {
+      backend: 'software',
+      codec: 'libx265',
+      presets: ['veryfast', 'superfast', 'ultrafast'],
+      globalArgs: [],
+      pixelArgs: ['-pix_fmt', 'yuv420p'],
+      lowLatency: ['-tune', 'zerolatency'],
+      quality: ['-crf', '26'],
+    },
+  ],
+};
+
+// Used without a probe: what the capture services were written for
+const isJetson = fs.existsSync('/etc/nv_tegra_release');
+const DEFAULTS: Record<EncoderFramework, Record<VideoCodec, Omit<Choice, 'fps'>>> = {
+  // Jetson Orin Nano has no NVENC; desktops are assumed to have an NVIDIA GPU
+  gstreamer: isJetson
+    ? {
+        h264: { name: 'x264enc', preset: 'ultrafast' },
+        h265: { name: 'x265enc', preset: 'ultrafast' },
+      }
+    : {
+        h264: { name: 'nvh264enc', preset: 'low-latency' },
+        h265: { name: 'nvh265enc', preset: 'hq' },
+      },
+  ffmpeg: {
+    h264: { name: 'h264_nvenc', preset: 'p1' },
+    h265: { name: 'hevc_nvenc', preset: 'p4' },
+  },
+};
+
+/**
+ * Element properties for a bitrate and keyframe interval, as gst-launch
+ * arguments.
+ */
+export function gstEncoderSettings(
+  encoder: GstEncoder,
+  bitrateKbps: number,
+  keyframeInterval: number
+): string[] {
+  if (!encoder.bitrateProp || !encoder.gopProp) {
+    // V4L2 encoders take both as driver controls
+    const bitrate = bitrateKbps * encoder.bitrateMultiplier;
+    return [`extra-controls=controls,video_bitrate=${bitrate},video_gop_size=${keyframeInterval}`];
+  }
+  return [
+    `${encoder.bitrateProp}=${bitrateKbps * encoder.bitrateMultiplier}`,
+    `${encoder.gopProp}=${keyframeInterval}`,
+  ];
+}
+
+/**
+ * Picks the video encoders for the capture pipeline. At startup it lists the
+ * hardware and software encoders GStreamer or FFmpeg offer and times a short
+ * synthetic encode at the capture resolution with each. Per encoder, presets
+ * are tried from best quality down until one reaches the capture frame rate
+ * with ENCODER_HEADROOM to spare; of those, the hardware encoder with the
+ * most headroom wins, a software one only if no hardware encoder gets there.
+ * Each timing leaves out process start and encoder setup. Results are cached
+ * per host in ENCODER_CACHE and reused until the host's CPU, GPU devices or
+ * encoder list change.
+ */
+export class EncoderProbeService {
+  private enabled = process.env.ENCODER_PROBE !== 'false';
+  private cacheFile =
+    process.env.ENCODER_CACHE || path.join(process.cwd(), 'recordings', 'encoders.json');
+  private headroom = parseFloat(process.env.ENCODER_HEADROOM || '1.5');
+
+  // Benchmark: the camera's capture format
+  private width = 1920;
+  private height = 1080;
+  private targetFps = 30;
+  private frames = 90; // timed
+  private warmFrames = 15; // startup baseline, subtracted
+  private benchTimeoutMs = 15000;
+
+  private probes: Partial<Record<EncoderFramework, ProbeResult>> = {};
+
+  /** Probe (or load from cache) the encoders of one framework */
+  public async probe(framework: EncoderFramework): Promise<void> {
+    if (!this.enabled || this.probes[framework]) return;
+
+    const available = this.listAvailable(framework);
+    const fingerprint = this.fingerprint(framework, available);
+    const cached = this.readCache()[os.hostname()]?.[framework];
+    if (cached && cached.fingerprint === fingerprint) {
+      this.probes[framework] = cached;
+      console.log(`[Encoders] Using cached ${framework} selection: ${this.describe(cached)}`);
+      return;
+    }
+
+    console.log(`[Encoders] Benchmarking ${framework} encoders: ${available.join(', ') || 'none'}`);
+    const started = Date.now();
+    const results: BenchResult[] = [];
+    const result: ProbeResult = {
+      fingerprint,
+      probedAt: started,
+      targetFps: this.targetFps,
+      headroom: this.headroom,
+      h264: await this.choose(framework, 'h264', available, results),
+      h265: await this.choose(framework, 'h265', available, results),
+      results,
+    };
+
+    this.probes[framework] = result;
+    this.writeCache(framework, result);
+    console.log(
+      `[Encoders] Selected in ${((Date.now() - started) / 1000).toFixed(1)}s: ${this.describe(result)}`
+    );
+  }
+
+  private describe(result: ProbeResult): string {
+    const choice = (c: Choice | null) =>
+      c ? `${c.name}${c.preset ? ` (${c.preset})` : ''} ${c.fps.toFixed(0)} fps` : 'default';
+    return `h264 ${choice(result.h264)}, h265 ${choice(result.h265)}`;
+  }
+
+  private listAvailable(framework: EncoderFramework): string[] {
+    if (framework === 'gstreamer') {
+      const elements = [...GST_ENCODERS.h264, ...GST_ENCODERS.h265].map((e) => e.element);
+      return elements.filter(
+        (element) => spawnSync('gst-inspect-1.0', ['--exists', element]).status === 0
+      );
+    }
+
+    const listing = spawnSync('ffmpeg', ['-hide_banner', '-encoders'], { encoding: 'utf8' });
+    const output = listing.stdout || '';
+    const codecs = [...FFMPEG_ENCODERS.h264, ...FFMPEG_ENCODERS.h265].map((e) => e.codec);
+    return codecs.filter((codec) => new RegExp(`\\s${codec}\\s`).test(output));
+  }
+
+  // Whatever would change the outcome: CPU, GPU devices, installed encoders
+  private fingerprint(framework: EncoderFramework, available: string[]): string {
+    const cpus = os.cpus();
+    const devices = ['/dev/nvidia0', VAAPI_DEVICE, '/dev/video11'].filter((d) => fs.existsSync(d));
+    return [
+      framework,
+      `${cpus[0]?.model || 'unknown'} x${cpus.length}`,
+      `${this.width}x${this.height}@${this.targetFps}`,
+      this.headroom,
+      `bench v${BENCH_VERSION}`,
+      devices.join(','),
+      available.join(','),
+    ].join('|');
+  }
+
+  private async choose(
+    framework: EncoderFramework,
+    codec: VideoCodec,
+    available: string[],
+    results: BenchResult[]
+  ): Promise<Choice | null> {
+    const candidates =
+      framework === 'gstreamer'
+        ? GST_ENCODERS[codec].map((e) => ({ name: e.element, ...e }))
+        : FFMPEG_ENCODERS[codec].map((e) => ({ name: e.codec, ...e }));
+    const needed = this.targetFps * this.headroom;
+
+    const best: (Choice & { meets: boolean; hardware: boolean })[] = [];
+    for (const candidate of candidates.filter((c) => available.includes(c.name))) {
+      // The first preset that is fast enough, else the fastest one
+      let pick: Choice | null = null;
+      let meets = false;
+      const presets = candidate.presets.length ? candidate.presets : [null];
+
+      for (const preset of presets) {
+        const fps = await this.bench(framework, codec, candidate.name, preset);
+        results.push({ codec, name: candidate.name, preset, fps });
+        if (fps === null) break; // not usable on this host; too slow is a number
+        if (!pick || fps > pick.fps || fps >= needed) pick = { name: candidate.name, preset, fps };
+        if (fps >= needed) {
+          meets = true;
+          break;
+        }
+      }
+      if (pick) best.push({ ...pick, meets, hardware: isHardware(candidate.backend) });
+    }
+
+    // Fast enough and in hardware, else fast enough, else the fastest there is
+    const meeting = best.filter((b) => b.meets);
+    const hardware = meeting.filter((b) => b.hardware);
+    const pool = hardware.length ? hardware : meeting.length ? meeting : best;
+    const winner = pool.sort((a, b) => b.fps - a.fps)[0];
+    if (!winner) return null;
+    if (!winner.meets) {
+      console.warn(
+        `[Encoders] No ${codec} encoder reaches ${needed} fps; using the fastest (${winner.name}, ${winner.fps.toFixed(0)} fps)`
+      );
+    }
+    return { name: winner.name, preset: winner.preset, fps: winner.fps };
+  }
+
+  // Frames per second of a synthetic encode, or null if the encoder fails.
+  // Process start, the plugin scan and CUDA/VA-API setup take a similar time
+  // however many frames follow, so a short run is timed too and taken off.
+  // A run cut off at benchTimeoutMs counts as its frames over the timeout,
+  // more than it really managed, so a faster preset still gets its turn.
+  private async bench(
+    framework: EncoderFramework,
+    codec: VideoCodec,
+    name: string,
+    preset: string | null
+  ): Promise<number | null> {
+    const [command, argsFor] = this.benchCommand(framework, codec, name, preset);
+    const timedOut = (frames: number) => frames / (this.benchTimeoutMs / 1000);
+
+    const startup = await this.timeRun(command, argsFor(this.warmFrames));
+    if (startup === null) return null;
+    if (startup === 'timeout') return timedOut(this.warmFrames);
+    const total = await this.timeRun(command, argsFor(this.warmFrames + this.frames));
+    if (total === null) return null;
+    if (total === 'timeout') return timedOut(this.warmFrames + this.frames);
+    // Timing noise on a very fast encoder: fall back to the whole run, a lower bound
+    if (total <= startup) return (this.warmFrames + this.frames) / total;
+    return this.frames / (total - startup);
+  }
+
+  // The benchmark command, and its arguments for a number of frames
+  private benchCommand(
+    framework: EncoderFramework,
+    codec: VideoCodec,
+    name: string,
+    preset: string | null
+  ): [string, (frames: number) => string[]] {
+    const size = `${this.width}x${this.height}`;
+
+    if (framework === 'gstreamer') {
+      const encoder = GST_ENCODERS[codec].find((e) => e.element === name)!;
+      const args = (frames: number) => [
+        '-q',
+        'videotestsrc',
+        `num-buffers=${frames}`,
+        'pattern=smpte',
+        'horizontal-speed=8', // moving content, not one repeated frame
+        '!',
+        `video/x-raw,width=${this.width},height=${this.height},framerate=${this.targetFps}/1`,
+        '!',
+        'videoconvert',
+        '!',
+        name,
+        ...(encoder.presetProp && preset ? [`${encoder.presetProp}=${preset}`] : []),
+        '!',
+        'fakesink',
+      ];
+      return ['gst-launch-1.0', args];
+    }
+
+    const encoder = FFMPEG_ENCODERS[codec].find((e) => e.codec === name)!;
+    const args = (frames: number) => [
+      '-hide_banner',
+      '-loglevel',
+      'error',
+      ...encoder.globalArgs,
+      '-f',
+      'lavfi',
+      '-i',
+      `testsrc2=size=${size}:rate=${this.targetFps}`,
+      '-frames:v',
+      String(frames),
+      '-c:v',
+      name,
+      ...(preset ? ['-preset', preset] : []),
+      ...encoder.pixelArgs,
+      '-f',
+      'null',
+      '-',
+    ];
+    return ['ffmpeg', args];
+  }
+
+  // Wall time of a run in seconds, 'timeout' if it was killed at
+  // benchTimeoutMs, or null if it failed
+  private timeRun(command: string, args: string[]): Promise<number | 'timeout' | null> {
+    return new Promise((resolve) => {
+      const started = Date.now();
+      const proc = spawn(command, args, { stdio: 'ignore' });
+      let killed = false;
+      const timer = setTimeout(() => {
+        killed = true;
+        proc.kill('SIGKILL');
+      }, this.benchTimeoutMs);
+
+      proc.on('error', () => {
+        clearTimeout(timer);
+        resolve(null);
+      });
+      proc.on('close', (code) => {
+        clearTimeout(timer);
+        if (killed) resolve('timeout');
+        else resolve(code === 0 ? (Date.now() - started) / 1000 : null);
+      });
+    });
+  }
+
+  private readCache(): Record<string, Partial<Record<EncoderFramework, ProbeResult>>> {
+    try {
+      return JSON.parse(fs.readFileSync(this.cacheFile, 'utf8'));
+    } catch {
+      return {};
+    }
+  }
+
+  private writeCache(framework: EncoderFramework, result: ProbeResult) {
+    const cache = this.readCache();
+    const host = os.hostname();
+    cache[host] = { ...cache[host], [framework]: result };
+    try {
+      fs.mkdirSync(path.dirname(this.cacheFile), { recursive: true });
+      fs.writeFileSync(this.cacheFile, JSON.stringify(cache, null, 2));
+    } catch (error) {
+      console.error(`[Encoders] Failed to write ${this.cacheFile}:`, error);
+    }
+  }
+
+  private selection(framework: EncoderFramework, codec: VideoCodec) {
+    const probed = this.probes[framework]?.[codec];
+    return probed ?? { ...DEFAULTS[framework][codec], fps: null };
+  }
+
+  /** GStreamer encoder for a codec: the probed one, else the default */
+  public gst(codec: VideoCodec): Selected<GstEncoder> {
+    const choice = this.selection('gstreamer', codec);
+    const encoder =
+      GST_ENCODERS[codec].find((e) => e.element === choice.name) ?? GST_ENCODERS[codec][0];
+    return { ...encoder, preset: choice.preset, fps: choice.fps };
+  }
+
+  /** FFmpeg encoder for a codec: the probed one, else the default */
+  public ffmpeg(codec: VideoCodec): Selected<FFmpegEncoder> {
+    const choice = this.selection('ffmpeg', codec);
+    const encoder =
+      FFMPEG_ENCODERS[codec].find((e) => e.codec === choice.name) ?? FFMPEG_ENCODERS[codec][0];
+    return { ...encoder, preset: choice.preset, fps: choice.fps };
+  }
+
+  public getStats() {
+    const summary = (framework: EncoderFramework) => {
+      const probe = this.probes[framework];
+      return probe
+        ? { probedAt: probe.probedAt, h264: probe.h264, h265: probe.h265, results: probe.results }
+        : null;
+    };
+    return {
+      enabled: this.enabled,
+      gstreamer: summary('gstreamer'),
+      ffmpeg: summary('ffmpeg'),
+    };
+  }
+}
+
+export const encoderProbeService = new EncoderProbeService();
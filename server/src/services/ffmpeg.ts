@@ -1,17 +1,83 @@
 import { spawn, ChildProcess } from 'child_process';
 import * as path from 'path';
 import * as fs from 'fs';
+import { segmentManager } from './segmentManager';
+import { encoderProbeService } from './encoderProbe';
 
+interface CaptureOptions {
+  videoDevice: string;
+  audioDevice: string;
+  rtspUrl: string;
+  pcmOutput?: string;
+  frameOutput?: string;
+  frameRate?: number;
+}
+
+// Latest block from -progress; counters are cumulative for the process
+interface FFmpegProgress {
+  frame: number;
+  fps: number;
+  bitrateKbps: number;
+  speed: number;
+  dupFrames: number;
+  dropFrames: number;
+  outTimeMs: number;
+  totalSize: number;
+}
+
+// Time to let ffmpeg finalize the open segment after SIGINT
+const STOP_TIMEOUT_MS = 5000;
+
+/**
+ * Runs ffmpeg under supervision. Progress comes from -progress on stdout
+ * instead of the stderr stats line and is kept as metrics. A process that
+ * exits, or makes no progress for FFMPEG_STALL_MS, is restarted after an
+ * exponential backoff (FFMPEG_RESTART_MIN_MS doubling up to
+ * FFMPEG_RESTART_MAX_MS, reset after a minute of stable running). Each
+ * outage is recorded as a gap in the segment DB, from the last frame before
+ * it to the first frame after it.
+ */
 export class FFmpegService {
   private ffmpegProcess: ChildProcess | null = null;
   private recordingsDir = path.join(process.cwd(), 'recordings');
 
+  private stallMs = parseInt(process.env.FFMPEG_STALL_MS || '10000');
+  private minBackoffMs = parseInt(process.env.FFMPEG_RESTART_MIN_MS || '1000');
+  private maxBackoffMs = parseInt(process.env.FFMPEG_RESTART_MAX_MS || '60000');
+  private stableMs = 60000;
+
+  private options: CaptureOptions | null = null;
+  private stopping = false;
+  private attempts = 0; // restarts since the last stable run
+  private restarts = 0;
+  private restartTimer: NodeJS.Timeout | null = null;
+  private restartAt = 0;
+  private watchdog: NodeJS.Timeout | null = null;
+  private killReason: string | null = null;
+  private gapId: number | null = null;
+
+  private startedAt = 0;
+  private lastAdvanceAt = 0; // last time the frame count grew
+  private lastProgressAt = 0;
+  private progress: FFmpegProgress | null = null;
+  private progressBuffer = '';
+  private progressFields: Record<string, string> = {};
+
+  // RECORD_MODE=raw copies the camera's MJPEG into the segments instead of
+  // encoding HEVC live; the transcoder converts them later
+  private rawRecording = process.env.RECORD_MODE === 'raw';
+
+  // RECORD_PROFILE=dual adds a continuous 480p proxy and sends the full-res
+  // segments to the pre-roll, which keeps only those a keep window covers
+  private dualRecording = process.env.RECORD_PROFILE === 'dual';
+
   constructor() {
     this.ensureDirectories();
   }
 
   private ensureDirectories() {
     const dirs = ['segments', 'audio'];
+    if (this.dualRecording) dirs.push('proxy', 'preroll');
     dirs.forEach((dir) => {
       const fullPath = path.join(this.recordingsDir, dir);
       if (!fs.existsSync(fullPath)) {
@@ -20,13 +86,37 @@ export class FFmpegService {
     });
   }
 
-  public startCapture(options: { videoDevice: string; audioDevice: string; rtspUrl: string }) {
-    if (this.ffmpegProcess) {
+  public startCapture(options: CaptureOptions) {
+    if (this.ffmpegProcess || this.restartTimer) {
       console.warn('FFmpeg capture already running');
       return;
     }
 
+    this.options = options;
+    this.stopping = false;
+    this.attempts = 0;
+    this.spawnProcess();
+
+    if (!this.watchdog) {
+      this.watchdog = setInterval(() => this.checkProgress(), 1000);
+    }
+  }
+
+  private buildArgs(options: CaptureOptions): string[] {
+    // Encoders chosen by the startup probe (or NVENC without one)
+    const record = encoderProbeService.ffmpeg('h265');
+    const live = encoderProbeService.ffmpeg('h264');
+    const preset = (encoder: { preset: string | null }) =>
+      encoder.preset ? ['-preset', encoder.preset] : [];
+    // Hardware device for VAAPI, before the inputs
+    const usesRecord = !this.rawRecording || this.dualRecording;
+    const deviceArgs = [...(usesRecord ? [record] : []), live].find(
+      (encoder) => encoder.globalArgs.length
+    )?.globalArgs;
+
     const args = [
+      ...(deviceArgs || []),
+
       // Inputs
       '-thread_queue_size',
       '512',
@@ -50,20 +140,18 @@ export class FFmpegService {
 
       // Global options
       '-y', // Overwrite files
+      '-nostats', // Progress is read from -progress instead
+      '-progress',
+      'pipe:1',
 
-      // OUTPUT 1: High-Quality Loop Recording (HEVC NVENC)
+      // OUTPUT 1: High-Quality Loop Recording (HEVC, or camera MJPEG copied)
       '-map',
       '0:v',
       '-map',
       '1:a',
-      '-c:v',
-      'hevc_nvenc',
-      '-preset',
-      'p4',
-      '-cq',
-      '23',
-      '-pix_fmt',
-      'yuv420p',
+      ...(this.rawRecording
+        ? ['-c:v', 'copy']
+        : ['-c:v', record.codec, ...preset(record), ...record.quality, ...record.pixelArgs]),
       '-c:a',
       'aac',
       '-b:a',
@@ -76,7 +164,11 @@ export class FFmpegService {
       '1',
       '-strftime',
       '1',
-      path.join(this.recordingsDir, 'segments/%Y%m%d_%H%M%S.mp4'),
+      path.join(
+        this.recordingsDir,
+        this.dualRecording ? 'preroll' : 'segments',
+        '%Y%m%d_%H%M%S.mp4'
+      ),
 
       // OUTPUT 2: AI Speech-to-Text Audio (WAV)
       '-map',
@@ -99,21 +191,12 @@ export class FFmpegService {
       '-map',
       '1:a',
       '-c:v',
-      'h264_nvenc',
-      '-preset',
-      'p1',
-      '-tune',
-      'll',
-      '-zerolatency',
-      '1',
-      '-delay',
-      '0',
+      live.codec,
+      ...preset(live),
+      ...live.lowLatency,
       '-g',
       '30',
-      '-forced-idr',
-      '1',
-      '-pix_fmt',
-      'yuv420p',
+      ...live.pixelArgs,
       '-c:a',
       'aac',
       '-b:a',
@@ -125,38 +208,256 @@ export class FFmpegService {
         : options.rtspUrl,
     ];
 
+    // OUTPUT 1b (RECORD_PROFILE=dual): Continuous 480p proxy, same segmenting
+    if (this.dualRecording) {
+      // The scale goes ahead of any upload filter the encoder needs
+      const filter =
+        record.pixelArgs[0] === '-vf'
+          ? ['-vf', `scale=-2:480,${record.pixelArgs[1]}`]
+          : ['-vf', 'scale=-2:480', ...record.pixelArgs];
+      args.push(
+        '-map',
+        '0:v',
+        '-map',
+        '1:a',
+        '-c:v',
+        record.codec,
+        ...preset(record),
+        '-b:v',
+        '800k',
+        '-g',
+        '60',
+        ...filter,
+        '-c:a',
+        'aac',
+        '-b:a',
+        '64k',
+        '-f',
+        'segment',
+        '-segment_time',
+        '30',
+        '-reset_timestamps',
+        '1',
+        '-strftime',
+        '1',
+        path.join(this.recordingsDir, 'proxy/proxy_%Y%m%d_%H%M%S.mp4')
+      );
+    }
+
+    // OUTPUT 4 (optional): Live 16 kHz mono PCM for streaming STT
+    if (options.pcmOutput) {
+      args.push(
+        '-map',
+        '1:a',
+        '-ar',
+        '16000',
+        '-ac',
+        '1',
+        '-f',
+        's16le',
+        '-flush_packets',
+        '1',
+        options.pcmOutput
+      );
+    }
+
+    // OUTPUT 5 (optional): Camera JPEGs copied without decoding, as multipart
+    // for the frame tap (which drops frames down to its own rate). Written
+    // through the fifo muxer's own thread and queue, which drops packets
+    // when full: a stalled reader loses tap frames instead of blocking the
+    // recording and HLS outputs, like the leaky queue on the GStreamer path
+    if (options.frameOutput) {
+      args.push(
+        '-map',
+        '0:v',
+        '-c:v',
+        'copy',
+        '-f',
+        'fifo',
+        '-fifo_format',
+        'mpjpeg',
+        '-queue_size',
+        '8',
+        '-drop_pkts_on_overflow',
+        '1',
+        '-attempt_recovery',
+        '1',
+        '-format_opts',
+        'flush_packets=1',
+        options.frameOutput
+      );
+    }
+
+    return args;
+  }
+
+  private spawnProcess() {
+    if (!this.options) return;
+    this.restartTimer = null;
+
+    const args = this.buildArgs(this.options);
     console.log('Starting FFmpeg with args:', args.join(' '));
 
-    this.ffmpegProcess = spawn('ffmpeg', args);
+    const proc = spawn('ffmpeg', args);
+    this.ffmpegProcess = proc;
+    this.startedAt = Date.now();
+    this.lastAdvanceAt = 0;
+    this.progress = null;
+    this.progressBuffer = '';
+    this.progressFields = {};
+    this.killReason = null;
 
-    this.ffmpegProcess.stderr?.on('data', (data) => {
-      const msg = data.toString();
-      // Suppress the constant frame=... messages
-      if (!msg.includes('frame=')) {
-        console.log(`[FFmpeg] ${msg.trim()}`);
-      }
+    proc.stdout?.on('data', (data) => this.onProgressData(data.toString()));
+
+    proc.stderr?.on('data', (data) => {
+      console.log(`[FFmpeg] ${data.toString().trim()}`);
     });
 
-    this.ffmpegProcess.on('close', (code) => {
-      console.log(`FFmpeg process exited with code ${code}`);
-      this.ffmpegProcess = null;
+    proc.on('close', (code, signal) => {
+      this.onExit(proc, signal ? `killed by ${signal}` : `exited with code ${code}`);
     });
 
-    this.ffmpegProcess.on('error', (err) => {
+    proc.on('error', (err) => {
       console.error('FFmpeg process error:', err);
-      this.ffmpegProcess = null;
+      this.onExit(proc, err.message);
     });
   }
 
-  public stopCapture() {
-    if (this.ffmpegProcess) {
-      this.ffmpegProcess.kill('SIGINT');
+  // -progress writes key=value lines; each block ends with progress=continue|end
+  private onProgressData(chunk: string) {
+    const lines = (this.progressBuffer + chunk).split('\n');
+    this.progressBuffer = lines.pop() || '';
+
+    for (const line of lines) {
+      const eq = line.indexOf('=');
+      if (eq < 0) continue;
+      const key = line.slice(0, eq).trim();
+      const value = line.slice(eq + 1).trim();
+      if (key === 'progress') {
+        this.applyProgress(this.progressFields);
+        this.progressFields = {};
+      } else {
+        this.progressFields[key] = value;
+      }
+    }
+  }
+
+  private applyProgress(fields: Record<string, string>) {
+    // Values like '1234.5kbits/s', '1.01x' or 'N/A'
+    const num = (value?: string) => {
+      const n = parseFloat(value ?? '');
+      return Number.isFinite(n) ? n : 0;
+    };
+
+    const now = Date.now();
+    const frame = num(fields.frame);
+    if (frame > (this.progress?.frame ?? 0)) {
+      this.lastAdvanceAt = now;
+      if (this.gapId !== null) {
+        segmentManager.closeGap(this.gapId, now);
+        console.log('[FFmpeg] Recording resumed');
+        this.gapId = null;
+      }
+    }
+
+    this.lastProgressAt = now;
+    this.progress = {
+      frame,
+      fps: num(fields.fps),
+      bitrateKbps: num(fields.bitrate),
+      speed: num(fields.speed),
+      dupFrames: num(fields.dup_frames),
+      dropFrames: num(fields.drop_frames),
+      outTimeMs: num(fields.out_time_us) / 1000,
+      totalSize: num(fields.total_size),
+    };
+  }
+
+  private checkProgress() {
+    const proc = this.ffmpegProcess;
+    if (!proc || this.stopping || this.killReason) return;
+
+    const now = Date.now();
+    const idleMs = now - (this.lastAdvanceAt || this.startedAt);
+    if (idleMs > this.stallMs) {
+      console.error(`[FFmpeg] No new frames for ${Math.round(idleMs / 1000)}s, restarting`);
+      this.kill(proc, `stalled for ${Math.round(idleMs / 1000)}s`);
+      return;
+    }
+
+    if (this.attempts > 0 && this.lastAdvanceAt && now - this.startedAt > this.stableMs) {
+      this.attempts = 0;
+    }
+  }
+
+  // SIGINT lets ffmpeg finalize the open segment; a stuck process gets SIGKILL
+  private kill(proc: ChildProcess, reason: string) {
+    this.killReason = reason;
+    proc.kill('SIGINT');
+    setTimeout(() => {
+      if (proc.exitCode === null && proc.signalCode === null) proc.kill('SIGKILL');
+    }, STOP_TIMEOUT_MS);
+  }
+
+  private onExit(proc: ChildProcess, how: string) {
+    // 'error' and 'close' can both fire for one process
+    if (this.ffmpegProcess !== proc) return;
+    this.ffmpegProcess = null;
+    console.log(`FFmpeg process ${how}`);
+    if (this.stopping || !this.options) return;
+
+    const reason = this.killReason || how;
+    if (this.gapId === null) {
+      this.gapId = segmentManager.openGap(this.lastAdvanceAt || this.startedAt, reason);
+    }
+
+    const delay = Math.min(this.maxBackoffMs, this.minBackoffMs * 2 ** this.attempts);
+    this.attempts++;
+    this.restarts++;
+    this.restartAt = Date.now() + delay;
+    console.log(`[FFmpeg] Restarting in ${delay} ms (attempt ${this.attempts})`);
+    this.restartTimer = setTimeout(() => this.spawnProcess(), delay);
+  }
+
+  public async stopCapture() {
+    this.stopping = true;
+    if (this.watchdog) {
+      clearInterval(this.watchdog);
+      this.watchdog = null;
+    }
+    if (this.restartTimer) {
+      clearTimeout(this.restartTimer);
+      this.restartTimer = null;
+    }
+    if (this.gapId !== null) {
+      segmentManager.closeGap(this.gapId, Date.now());
+      this.gapId = null;
+    }
+
+    const proc = this.ffmpegProcess;
+    if (proc) {
+      const exited = new Promise<void>((resolve) => proc.once('close', () => resolve()));
+      this.kill(proc, 'stopped');
+      await exited;
     }
   }
 
   public isRunning() {
     return this.ffmpegProcess !== null;
   }
+
+  public getStats() {
+    const now = Date.now();
+    return {
+      running: this.ffmpegProcess !== null,
+      uptimeMs: this.ffmpegProcess ? now - this.startedAt : 0,
+      restarts: this.restarts,
+      nextRestartMs: this.restartTimer ? Math.max(0, this.restartAt - now) : null,
+      lastFrameAgoMs: this.lastAdvanceAt ? now - this.lastAdvanceAt : null,
+      lastProgressAt: this.lastProgressAt || null,
+      progress: this.progress,
+    };
+  }
 }
 
 export const ffmpegService = new FFmpegService();
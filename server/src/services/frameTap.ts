@@ -0,0 +1,126 @@
+import { spawnSync } from 'child_process';
+import { EventEmitter } from 'events';
+import * as net from 'net';
+import * as fs from 'fs';
+
+export interface TappedFrame {
+  jpeg: Buffer; // original camera JPEG, not re-encoded
+  timestamp: number; // epoch ms on arrival
+}
+
+// Anything bigger than this without a complete frame means we lost sync
+const MAX_PENDING_BYTES = 8 * 1024 * 1024;
+const HEADER_END = Buffer.from('\r\n\r\n');
+
+/**
+ * Camera MJPEG frames tapped from the capture pipeline before decoding. The
+ * pipeline writes multipart JPEG (GStreamer multipartmux / FFmpeg mpjpeg)
+ * into a FIFO; each part carries a Content-Length so frames are split
+ * without scanning the JPEG data. An in-process pipeline pushes frames from
+ * an appsink instead. Consumers call start() before capture begins and
+ * listen for 'frame' events.
+ */
+export class FrameTapService extends EventEmitter {
+  private fifo = process.env.FRAME_TAP_FIFO || '/tmp/obsbot-frames.mjpeg';
+  private fps = parseInt(process.env.FRAME_TAP_FPS || '5');
+  private socket: net.Socket | null = null;
+  private pending: Buffer = Buffer.alloc(0);
+  private lastEmit = 0;
+  private latestFrame: TappedFrame | null = null;
+
+  /** FIFO the capture service should write multipart JPEG into, if the tap is active */
+  public get frameOutput(): string | undefined {
+    return this.socket ? this.fifo : undefined;
+  }
+
+  /** Maximum frames per second the pipeline should pass to the tap */
+  public get frameRate(): number {
+    return this.fps;
+  }
+
+  public get latest(): TappedFrame | null {
+    return this.latestFrame;
+  }
+
+  public start(): boolean {
+    if (this.socket) return true;
+    if (!this.ensureFifo()) return false;
+
+    // Same trick as the STT PCM FIFO: read-write never blocks and survives
+    // capture restarts
+    const fd = fs.openSync(this.fifo, fs.constants.O_RDWR | fs.constants.O_NONBLOCK);
+    this.socket = new net.Socket({ fd, readable: true, writable: false });
+    this.socket.on('data', (chunk: Buffer) => this.onData(chunk));
+    this.socket.on('error', (error) => {
+      console.error('[FrameTap] Stream error:', error.message);
+    });
+
+    console.log(`[FrameTap] Reading camera JPEG frames from ${this.fifo} (max ${this.fps} fps)`);
+    return true;
+  }
+
+  private ensureFifo(): boolean {
+    try {
+      if (fs.existsSync(this.fifo)) {
+        if (fs.statSync(this.fifo).isFIFO()) return true;
+        fs.unlinkSync(this.fifo);
+      }
+      return spawnSync('mkfifo', [this.fifo]).status === 0;
+    } catch (error) {
+      console.error(`[FrameTap] Failed to create FIFO ${this.fifo}:`, error);
+      return false;
+    }
+  }
+
+  private onData(chunk: Buffer) {
+    this.pending = this.pending.length ? Buffer.concat([this.pending, chunk]) : chunk;
+
+    for (;;) {
+      const headerEnd = this.pending.indexOf(HEADER_END);
+      if (headerEnd < 0) break;
+
+      const header = this.pending.subarray(0, headerEnd).toString('latin1');
+      const match = header.match(/content-length:\s*(\d+)/i);
+      const bodyStart = headerEnd + HEADER_END.length;
+
+      if (!match) {
+        // Boundary line or junk without a length; skip past it
+        this.pending = this.pending.subarray(bodyStart);
+        continue;
+      }
+
+      const length = parseInt(match[1]);
+      if (this.pending.length < bodyStart + length) break;
+
+      const jpeg = this.pending.subarray(bodyStart, bodyStart + length);
+      this.pending = this.pending.subarray(bodyStart + length);
+      this.push(jpeg);
+    }
+
+    if (this.pending.length > MAX_PENDING_BYTES) {
+      console.warn('[FrameTap] Lost multipart sync, dropping buffered data');
+      this.pending = Buffer.alloc(0);
+    }
+  }
+
+  /** Deliver one camera JPEG; data may be reused by the caller afterwards */
+  public push(data: Buffer, timestamp = Date.now()) {
+    // FFmpeg copies every camera frame; keep to the configured rate here
+    if (timestamp - this.lastEmit < 1000 / this.fps) return;
+    this.lastEmit = timestamp;
+
+    // Copy out of the shared read buffer so consumers can hold on to it
+    const frame: TappedFrame = { jpeg: Buffer.from(data), timestamp };
+    this.latestFrame = frame;
+    this.emit('frame', frame);
+  }
+
+  public close() {
+    if (this.socket) {
+      this.socket.destroy();
+      this.socket = null;
+    }
+  }
+}
+
+export const frameTapService = new FrameTapService();
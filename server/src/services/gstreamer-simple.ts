@@ -1,32 +1,12 @@
 import { spawn, ChildProcess } from 'child_process';
 import * as path from 'path';
 import * as fs from 'fs';
+import { encoderProbeService, gstEncoderSettings } from './encoderProbe';
 
 export class GStreamerSimpleService {
   private gstProcess: ChildProcess | null = null;
   private recordingsDir = path.join(process.cwd(), 'recordings');
 
-  // Detect if running on NVIDIA Jetson (L4T)
-  private isJetson = fs.existsSync('/etc/nv_tegra_release');
-
-  private get encoders() {
-    return this.isJetson
-      ? {
-          h264: 'x264enc',
-          h265: 'x265enc',
-          presetProp: 'speed-preset',
-          h264Preset: 'ultrafast',
-          h265Preset: 'ultrafast',
-        }
-      : {
-          h264: 'nvh264enc',
-          h265: 'nvh265enc',
-          presetProp: 'preset',
-          h264Preset: 'low-latency',
-          h265Preset: 'hq',
-        };
-  }
-
   constructor() {
     this.ensureDirectories();
   }
@@ -48,7 +28,14 @@ export class GStreamerSimpleService {
     }
   }
 
-  public startCapture(options: { videoDevice: string; audioDevice: string; rtspUrl: string }) {
+  public startCapture(options: {
+    videoDevice: string;
+    audioDevice: string;
+    rtspUrl: string;
+    pcmOutput?: string;
+    frameOutput?: string;
+    frameRate?: number;
+  }) {
     if (this.gstProcess) {
       console.warn('GStreamer capture already running');
       return;
@@ -62,7 +49,12 @@ export class GStreamerSimpleService {
       return;
     }
 
-    const { encoders } = this;
+    if (process.env.RECORD_PROFILE === 'dual') {
+      console.warn('[GStreamer] RECORD_PROFILE=dual needs gstreamer-full or ffmpeg, ignoring');
+    }
+
+    // H.264 encoder chosen by the startup probe (or the default without one)
+    const h264 = encoderProbeService.gst('h264');
 
     // Generate timestamp prefix for this capture session
     const now = new Date();
@@ -90,18 +82,18 @@ export class GStreamerSimpleService {
       '!',
       'image/jpeg,width=1920,height=1080,framerate=30/1',
       '!',
+      // Tee the camera's own JPEGs for the frame tap before decoding
+      ...(options.frameOutput ? ['tee', 'name=jtee', '!', 'queue', '!'] : []),
       'jpegdec',
       '!',
       'videoconvert',
       '!',
 
       // H.264 encoder
-      encoders.h264,
-      `${encoders.presetProp}=${encoders.h264Preset}`,
-      this.isJetson ? 'tune=zerolatency' : 'zerolatency=true',
-      'bitrate=8000',
-      this.isJetson ? 'key-int-max=30' : 'gop-size=30',
-      this.isJetson ? 'bframes=0' : '',
+      h264.element,
+      ...(h264.presetProp && h264.preset ? [`${h264.presetProp}=${h264.preset}`] : []),
+      ...h264.lowLatency,
+      ...gstEncoderSettings(h264, 8000, 30),
       '!',
       'h264parse',
       'config-interval=-1',
@@ -119,6 +111,13 @@ export class GStreamerSimpleService {
       '!',
       'audio/x-raw,rate=48000,channels=2',
       '!',
+      // Raw tee so live PCM for STT can branch off before AAC encoding
+      'tee',
+      'name=araw',
+      'araw.',
+      '!',
+      'queue',
+      '!',
       'voaacenc',
       'bitrate=128000',
       '!',
@@ -172,11 +171,68 @@ export class GStreamerSimpleService {
       'split.audio_0',
     ].filter(arg => arg !== ''); // Remove empty args
 
+    // Branch 3 (optional): Live 16 kHz mono PCM for streaming STT.
+    // Leaky so a slow reader drops audio instead of stalling capture.
+    if (options.pcmOutput) {
+      args.push(
+        'araw.',
+        '!',
+        'queue',
+        'max-size-time=2000000000',
+        'max-size-buffers=0',
+        'max-size-bytes=0',
+        'leaky=downstream',
+        '!',
+        'audioconvert',
+        '!',
+        'audioresample',
+        '!',
+        'audio/x-raw,format=S16LE,rate=16000,channels=1',
+        '!',
+        'filesink',
+        `location=${options.pcmOutput}`,
+        'sync=false',
+        'async=false',
+        'buffer-mode=unbuffered'
+      );
+    }
+
+    // Branch 4 (optional): Original MJPEG frames for motion detection and
+    // snapshots, rate-limited and framed as multipart so no decode is needed.
+    if (options.frameOutput) {
+      args.push(
+        'jtee.',
+        '!',
+        'queue',
+        'max-size-buffers=2',
+        'leaky=downstream',
+        '!',
+        'videorate',
+        'drop-only=true',
+        `max-rate=${options.frameRate ?? 5}`,
+        '!',
+        'multipartmux',
+        'boundary=frame',
+        '!',
+        'filesink',
+        `location=${options.frameOutput}`,
+        'sync=false',
+        'async=false',
+        'buffer-mode=unbuffered'
+      );
+    }
+
     console.log('Starting GStreamer pipeline for streaming + recording');
     console.log('  - Video: H.264 encode at 8Mbps');
     console.log('  - Audio: AAC encode at 128kbps');
     console.log('  - Live stream: RTSP -> MediaMTX (video + audio)');
     console.log('  - Recording: 30s MP4 segments (video + audio)');
+    if (options.pcmOutput) {
+      console.log(`  - STT: 16kHz PCM -> ${options.pcmOutput}`);
+    }
+    if (options.frameOutput) {
+      console.log(`  - Frame tap: camera JPEG -> ${options.frameOutput}`);
+    }
     console.log('Command:', 'gst-launch-1.0', args.join(' '));
 
     this.gstProcess = spawn('gst-launch-1.0', args);
@@ -1,54 +1,137 @@
 import { spawn, ChildProcess } from 'child_process';
 import * as path from 'path';
 import * as fs from 'fs';
+import { obsbot } from './native';
+import { frameTapService } from './frameTap';
+import { liveViewerService } from './liveViewers';
+import { encoderProbeService, gstEncoderSettings, GstEncoder, Selected } from './encoderProbe';
+
+type CaptureOptions = {
+  videoDevice: string;
+  audioDevice: string;
+  rtspUrl: string;
+  enableRtsp?: boolean;
+  pcmOutput?: string;
+  frameOutput?: string;
+  frameRate?: number;
+};
+
+export interface EncoderParams {
+  bitrateKbps: number;
+  keyframeInterval: number; // frames
+  width: number;
+  height: number;
+}
+
+export type ParamTarget = 'live' | 'recording';
+
+// How a parameter change took effect:
+// applied     - set on the running encoder
+// rebuilt     - live branch re-created with the new settings (brief gap for viewers)
+// deferred    - live branch not attached; used when it next attaches
+// next-start  - the element can't take it while running; used from the next pipeline start
+// unsupported - nothing encodes this output (raw recording)
+export type ParamResult = 'applied' | 'rebuilt' | 'deferred' | 'next-start' | 'unsupported';
+
+// Camera capture size; outputs can only be scaled down from it
+const CAPTURE_WIDTH = 1920;
+const CAPTURE_HEIGHT = 1080;
+const CAPTURE_FPS = 30;
+
+// RECORD_PROFILE=dual: the continuous proxy, on the same GOP as the recording
+// so both split into segments at the same points
+const PROXY_PARAMS: EncoderParams = {
+  bitrateKbps: 800,
+  keyframeInterval: 60,
+  width: 854,
+  height: 480,
+};
+
+// Time to let sinks finalize their files after EOS before tearing down
+const EOS_TIMEOUT_MS = 5000;
+// Delay before rebuilding an in-process pipeline that failed
+const RESTART_DELAY_MS = 1000;
+// Delay before re-attaching a live branch that failed (e.g. MediaMTX down)
+const LIVE_RETRY_MS = 5000;
 
 export class GStreamerService {
   private gstProcess: ChildProcess | null = null;
   private recordingsDir = path.join(process.cwd(), 'recordings');
 
-  // Detect if running on NVIDIA Jetson (L4T)
-  private isJetson = fs.existsSync('/etc/nv_tegra_release');
+  // Run the graph inside the addon (CapturePipeline) instead of spawning
+  // gst-launch-1.0, when the addon was built with GStreamer
+  private inProcess = !!obsbot?.CapturePipeline && process.env.GST_IN_PROCESS !== 'false';
+  private pipeline: any = null;
+  private lastOptions: CaptureOptions | null = null;
+  private stopping = false;
+  private onEos: (() => void) | null = null;
+
+  // In-process only: the live H.264 branch is attached while someone watches
+  private liveOnDemand = process.env.LIVE_ON_DEMAND !== 'false';
+  private liveSource: { tee: string; fromJpeg: boolean; rtspUrl: string } | null = null;
+  private liveBranchId: number | null = null;
+
+  // Encoder settings, changeable at runtime through setParams()
+  private params: Record<ParamTarget, EncoderParams> = {
+    live: {
+      bitrateKbps: 3000,
+      keyframeInterval: 30,
+      width: CAPTURE_WIDTH,
+      height: CAPTURE_HEIGHT,
+    },
+    recording: {
+      bitrateKbps: 15000,
+      keyframeInterval: 60,
+      width: CAPTURE_WIDTH,
+      height: CAPTURE_HEIGHT,
+    },
+  };
+
+  // RECORD_MODE=raw stores the camera's MJPEG in the segments instead of
+  // encoding HEVC live; the transcoder converts them later
+  private rawRecording = process.env.RECORD_MODE === 'raw';
 
+  // RECORD_PROFILE=dual adds a continuous 480p proxy and sends the full-res
+  // segments to the pre-roll, which keeps only those a keep window covers
+  private dualRecording = process.env.RECORD_PROFILE === 'dual';
+
+  // Encoders chosen by the startup probe (or the defaults without one)
   private get encoders() {
-    return this.isJetson
-      ? {
-          // Jetson Orin Nano does not have NVENC hardware encoder
-          // Use software encoders (x264enc/x265enc)
-          h264: 'x264enc',
-          h265: 'x265enc',
-          scaler: 'videoscale',
-          jpegdec: 'jpegdec',
-          // Software encoders expect bitrate in kbps
-          bitrateMultiplier: 1,
-          presetProp: 'speed-preset',
-          h264Preset: 'ultrafast', // ultrafast for low latency
-          h265Preset: 'ultrafast',
-          // Software encoders use standard system memory
-          hwCaps: 'video/x-raw',
-          swCaps: 'video/x-raw',
-        }
-      : {
-          h264: 'nvh264enc',
-          h265: 'nvh265enc',
-          scaler: 'videoscale',
-          jpegdec: 'jpegdec',
-          // Desktop nvh encoders expect bitrate in kbps
-          bitrateMultiplier: 1,
-          presetProp: 'preset',
-          h264Preset: 'low-latency',
-          h265Preset: 'hq',
-          // Desktop uses standard system memory
-          hwCaps: 'video/x-raw',
-          swCaps: 'video/x-raw',
-        };
+    return {
+      h264: encoderProbeService.gst('h264'),
+      h265: encoderProbeService.gst('h265'),
+      jpegdec: 'jpegdec',
+      // Encoders take standard system memory
+      hwCaps: 'video/x-raw',
+    };
+  }
+
+  // Encoder element with its preset and rate control, as gst-launch arguments
+  private encoderArgs(
+    encoder: Selected<GstEncoder>,
+    name: string,
+    params: EncoderParams,
+    lowLatency: boolean
+  ): string[] {
+    return [
+      encoder.element,
+      `name=${name}`,
+      ...(encoder.presetProp && encoder.preset ? [`${encoder.presetProp}=${encoder.preset}`] : []),
+      ...(lowLatency ? encoder.lowLatency : []),
+      ...gstEncoderSettings(encoder, params.bitrateKbps, params.keyframeInterval),
+    ];
   }
 
   constructor() {
     this.ensureDirectories();
+    if (this.inProcess) {
+      liveViewerService.on('change', () => this.syncLiveBranch());
+    }
   }
 
   private ensureDirectories() {
     const dirs = ['segments', 'audio', 'snapshots'];
+    if (this.dualRecording) dirs.push('proxy', 'preroll');
     dirs.forEach((dir) => {
       const fullPath = path.join(this.recordingsDir, dir);
       if (!fs.existsSync(fullPath)) {
@@ -57,21 +140,28 @@ export class GStreamerService {
     });
   }
 
+  private rtspClientSinkAvailable: boolean | null = null;
+
+  // Cached so pipeline restarts don't pay for gst-inspect again
   private checkRtspClientSinkAvailable(): boolean {
+    if (this.rtspClientSinkAvailable !== null) return this.rtspClientSinkAvailable;
     try {
       const { execSync } = require('child_process');
       execSync('gst-inspect-1.0 rtspclientsink', { stdio: 'ignore' });
-      return true;
+      this.rtspClientSinkAvailable = true;
     } catch {
-      return false;
+      this.rtspClientSinkAvailable = false;
     }
+    return this.rtspClientSinkAvailable;
   }
 
-  public startCapture(options: { videoDevice: string; audioDevice: string; rtspUrl: string; enableRtsp?: boolean }) {
-    if (this.gstProcess) {
+  public startCapture(options: CaptureOptions) {
+    if (this.gstProcess || this.pipeline) {
       console.warn('GStreamer capture already running');
       return;
     }
+    this.lastOptions = options;
+    this.stopping = false;
 
     // Check if rtspclientsink is available
     const rtspAvailable = this.checkRtspClientSinkAvailable();
@@ -94,28 +184,47 @@ export class GStreamerService {
      *    - tees: Splits video/audio for multiple outputs
      *
      * 3. Output 1 (High Quality Segmented MP4):
-     *    - nvh265enc: NVIDIA HW HEVC encoding
+     *    - HEVC encoder picked by the encoder probe (nvh265enc, vah265enc, x265enc...)
      *    - voaacenc: AAC audio encoding
      *    - splitmuxsink: Creates 30s segments
+     *    - RECORD_MODE=raw: camera JPEGs muxed as-is (no HEVC encoder in the
+     *      pipeline), transcoded to HEVC later by the transcoder service
+     *    - RECORD_PROFILE=dual: written to the pre-roll instead, next to a
+     *      continuous 480p HEVC proxy (pmux) segmented the same way
      *
      * 4. Output 2 (Segmented WAV for STT):
      *    - wavenc: Wraps raw audio in WAV container
      *    - splitmuxsink: Creates 10s segments
      *
      * 5. Output 3 (Live RTSP Stream):
-     *    - nvh264enc: NVIDIA HW H.264 encoding
+     *    - H.264 encoder picked by the encoder probe (nvh264enc, x264enc...)
      *    - rtspclientsink: Pushes to RTSP server (e.g. MediaMTX)
+     *    - In-process: attached to the tee only while there are viewers
+     *      (fresh encoder, so the stream starts on a keyframe)
      *
      * 6. Output 4 (Periodic Snapshots):
-     *    - videorate: Limits framerate to 1 frame every 10s
-     *    - jpegenc: Encodes as JPEG
-     *    - multifilesink: Saves numbered images
+     *    - Taken by the snapshot service from the frame tap (Output 6): the
+     *      camera's own JPEGs are saved as-is, no decode + jpegenc
+     *
+     * 7. Output 5 (Live PCM for streaming STT, optional):
+     *    - 16kHz mono S16LE written to a FIFO read by the STT service
+     *
+     * 8. Output 6 (Frame tap, optional):
+     *    - Camera JPEGs teed before jpegdec, rate-limited, multipart-framed
+     *      into a FIFO for motion detection and snapshots (an appsink when
+     *      the pipeline runs in-process)
      */
 
     // Note: GStreamer splitmuxsink doesn't support strftime-style filenames directly
     // in the location property via gst-launch-1.0. We use indexed naming for now.
 
     const { encoders } = this;
+    const jpegTee = options.frameOutput || this.rawRecording;
+    const liveOnDemand = enableRtsp && this.inProcess && this.liveOnDemand;
+    // Raw recording never needs decoded video except for a permanent live
+    // stream or the proxy; an on-demand live branch decodes the camera JPEGs itself
+    const decode = !this.rawRecording || this.dualRecording || (enableRtsp && !liveOnDemand);
+    const recordDir = this.dualRecording ? 'preroll' : 'segments';
     const args = [
       '-e', // Send EOS on interrupt to finalize files
 
@@ -123,20 +232,26 @@ export class GStreamerService {
       'v4l2src',
       `device=${options.videoDevice}`,
       '!',
-      'image/jpeg,width=1920,height=1080,framerate=30/1', // 1080p capture
-      '!',
-      'queue',
-      'max-size-buffers=30',
-      'name=v_src_q',
-      '!',
-      encoders.jpegdec,
-      '!',
-      'videoconvert',
-      '!',
-      encoders.hwCaps,
-      '!',
-      'tee',
-      'name=vtee',
+      // 1080p capture
+      `image/jpeg,width=${CAPTURE_WIDTH},height=${CAPTURE_HEIGHT},framerate=${CAPTURE_FPS}/1`,
+      ...(jpegTee ? ['!', 'tee', 'name=jtee'] : []),
+      ...(decode
+        ? [
+            '!',
+            'queue',
+            'max-size-buffers=30',
+            'name=v_src_q',
+            '!',
+            encoders.jpegdec,
+            '!',
+            'videoconvert',
+            '!',
+            encoders.hwCaps,
+            '!',
+            'tee',
+            'name=vtee',
+          ]
+        : []),
 
       // Audio Source: pulse capture -> convert -> resample
       'pulsesrc',
@@ -155,20 +270,22 @@ export class GStreamerService {
       'tee',
       'name=atee',
 
-      // -- OUTPUT 1: High-Quality Segments (HEVC 1080p) --
-      'vtee.',
-      '!',
-      'queue',
-      'max-size-buffers=30',
-      '!',
-      encoders.h265,
-      `${encoders.presetProp}=${encoders.h265Preset}`,
-      `bitrate=${15000 * encoders.bitrateMultiplier}`,
-      this.isJetson ? 'key-int-max=60' : 'gop-size=60', // x265enc uses key-int-max
-      '!',
-      'h265parse',
-      '!',
-      'smux.video',
+      // -- OUTPUT 1: High-Quality Segments (HEVC 1080p, or camera MJPEG) --
+      ...(this.rawRecording
+        ? ['jtee.', '!', 'queue', 'max-size-buffers=30', '!', 'jpegparse', '!', 'smux.video']
+        : [
+            'vtee.',
+            '!',
+            'queue',
+            'max-size-buffers=30',
+            '!',
+            ...this.scaler(this.params.recording),
+            ...this.encoderArgs(encoders.h265, 'rec_enc', this.params.recording, false),
+            '!',
+            'h265parse',
+            '!',
+            'smux.video',
+          ]),
 
       'atee.',
       '!',
@@ -185,9 +302,44 @@ export class GStreamerService {
       'splitmuxsink',
       'name=smux',
       'muxer-factory=mp4mux',
-      `location=${path.join(this.recordingsDir, 'segments/gst_%05d.mp4')}`,
+      `location=${path.join(this.recordingsDir, recordDir, 'gst_%05d.mp4')}`,
       'max-size-time=30000000000', // 30 seconds
 
+      // -- OUTPUT 1b: Continuous 480p proxy (RECORD_PROFILE=dual) --
+      ...(this.dualRecording
+        ? [
+            'vtee.',
+            '!',
+            'queue',
+            'max-size-buffers=30',
+            '!',
+            ...this.scaler(PROXY_PARAMS),
+            ...this.encoderArgs(encoders.h265, 'proxy_enc', PROXY_PARAMS, false),
+            '!',
+            'h265parse',
+            '!',
+            'pmux.video',
+
+            'atee.',
+            '!',
+            'queue',
+            'max-size-buffers=60',
+            '!',
+            'voaacenc',
+            'bitrate=64000',
+            '!',
+            'aacparse',
+            '!',
+            'pmux.audio_0',
+
+            'splitmuxsink',
+            'name=pmux',
+            'muxer-factory=mp4mux',
+            `location=${path.join(this.recordingsDir, 'proxy/proxy_%05d.mp4')}`,
+            'max-size-time=30000000000',
+          ]
+        : []),
+
       // -- OUTPUT 2: Audio Segments (WAV) --
       'atee.',
       '!',
@@ -209,49 +361,79 @@ export class GStreamerService {
     ];
 
     // -- OUTPUT 3: Live Stream (H.264 1080p) -- (Optional, requires rtspclientsink)
-    if (enableRtsp) {
+    this.liveSource = null;
+    if (liveOnDemand) {
+      this.liveSource = {
+        tee: decode ? 'vtee' : 'jtee',
+        fromJpeg: !decode,
+        rtspUrl: options.rtspUrl,
+      };
+    } else if (enableRtsp) {
+      args.push('vtee.', '!', ...this.liveBranch(options.rtspUrl, false));
+    } else {
+      console.log('[GStreamer] RTSP streaming disabled (rtspclientsink not available)');
+    }
+
+    // -- OUTPUT 5: Live PCM for streaming STT (16kHz mono S16LE) -- (Optional)
+    if (options.pcmOutput) {
       args.push(
-        'vtee.',
+        'atee.',
         '!',
         'queue',
-        'max-size-buffers=30',
+        'max-size-time=2000000000',
+        'max-size-buffers=0',
+        'max-size-bytes=0',
+        'leaky=downstream',
+        '!',
+        'audioconvert',
         '!',
-        encoders.h264,
-        `${encoders.presetProp}=${encoders.h264Preset}`,
-        this.isJetson ? 'tune=zerolatency' : 'zerolatency=true',
-        `bitrate=${3000 * encoders.bitrateMultiplier}`,
-        this.isJetson ? 'key-int-max=30' : 'gop-size=30',
+        'audioresample',
         '!',
-        'h264parse',
+        'audio/x-raw,format=S16LE,rate=16000,channels=1',
         '!',
-        'rtsp_sink.sink_0',
-        'rtspclientsink',
-        'name=rtsp_sink',
-        `location=${options.rtspUrl}`
+        'filesink',
+        `location=${options.pcmOutput}`,
+        'sync=false',
+        'async=false',
+        'buffer-mode=unbuffered'
       );
-    } else {
-      console.log('[GStreamer] RTSP streaming disabled (rtspclientsink not available)');
     }
 
-    // -- OUTPUT 4: Periodic Snapshots (JPEG 1080p) --
-    args.push(
-      'vtee.',
-      '!',
-      'queue',
-      'max-size-buffers=30',
-      '!',
-      'videorate',
-      '!',
-      'video/x-raw,framerate=1/10', // One frame every 10 seconds
-      '!',
-      'videoconvert',
-      '!',
-      'jpegenc',
-      'quality=85',
-      '!',
-      'multifilesink',
-      `location=${path.join(this.recordingsDir, 'snapshots/snap_%05d.jpg')}`
-    );
+    // -- OUTPUT 6: Frame tap (original MJPEG) -- (Optional)
+    // In-process frames go straight to JS through an appsink; otherwise
+    // multipart-framed into the FIFO
+    if (options.frameOutput) {
+      args.push(
+        'jtee.',
+        '!',
+        'queue',
+        'max-size-buffers=2',
+        'leaky=downstream',
+        '!',
+        'videorate',
+        'drop-only=true',
+        `max-rate=${options.frameRate ?? 5}`,
+        '!',
+        ...(this.inProcess
+          ? ['appsink', 'name=frame_sink']
+          : [
+              'multipartmux',
+              'boundary=frame',
+              '!',
+              'filesink',
+              `location=${options.frameOutput}`,
+              'sync=false',
+              'async=false',
+              'buffer-mode=unbuffered',
+            ])
+      );
+    }
+
+    if (this.inProcess) {
+      // '-e' is a gst-launch option; EOS on stop is handled by stopCapture()
+      this.startPipeline(args.slice(1), !!options.frameOutput);
+      return;
+    }
 
     console.log('Starting GStreamer with args:', args.join(' '));
 
@@ -276,7 +458,287 @@ export class GStreamerService {
     });
   }
 
-  public stopCapture() {
+  /**
+   * Live H.264 output from a tee. The queue is leaky so a slow live encoder
+   * drops frames instead of holding up the recording branch; elements are
+   * named live_* so their errors can be told apart from the rest of the graph.
+   */
+  private liveBranch(rtspUrl: string, fromJpeg: boolean): string[] {
+    const { encoders } = this;
+    const live = this.params.live;
+    return [
+      'queue',
+      'name=live_q',
+      'max-size-buffers=30',
+      'leaky=downstream',
+      '!',
+      // Frame rate cap for rate control; drops before decoding when fed JPEG
+      'videorate',
+      'name=live_rate',
+      'drop-only=true',
+      `max-rate=${CAPTURE_FPS}`,
+      '!',
+      ...(fromJpeg ? [encoders.jpegdec, '!', 'videoconvert', '!'] : []),
+      ...this.scaler(live),
+      ...this.encoderArgs(encoders.h264, 'live_enc', live, true),
+      '!',
+      'h264parse',
+      'config-interval=-1', // SPS/PPS with every keyframe for late joiners
+      '!',
+      'rtspclientsink',
+      'name=live_sink',
+      `location=${rtspUrl}`,
+    ];
+  }
+
+  // Downscale ahead of an encoder when the output is smaller than the capture
+  private scaler(params: EncoderParams): string[] {
+    if (params.width === CAPTURE_WIDTH && params.height === CAPTURE_HEIGHT) return [];
+    return ['videoscale', '!', `video/x-raw,width=${params.width},height=${params.height}`, '!'];
+  }
+
+  // Attach or detach the live branch to match viewer presence
+  private syncLiveBranch() {
+    const source = this.liveSource;
+    if (!this.pipeline || !source) return;
+    const wanted = liveViewerService.isActive;
+
+    if (wanted && this.liveBranchId === null) {
+      try {
+        this.liveBranchId = this.pipeline.addBranch(
+          source.tee,
+          this.liveBranch(source.rtspUrl, source.fromJpeg)
+        );
+        console.log('[GStreamer] Live stream branch attached');
+      } catch (error: any) {
+        console.error('[GStreamer] Failed to attach live branch:', error.message);
+      }
+    } else if (!wanted && this.liveBranchId !== null) {
+      this.pipeline.removeBranch(this.liveBranchId);
+      this.liveBranchId = null;
+      console.log('[GStreamer] Live stream branch detached');
+    }
+  }
+
+  // A failing live branch is dropped and retried; recording carries on
+  private dropLiveBranch() {
+    if (this.pipeline && this.liveBranchId !== null) {
+      this.pipeline.removeBranch(this.liveBranchId);
+    }
+    this.liveBranchId = null;
+    setTimeout(() => this.syncLiveBranch(), LIVE_RETRY_MS);
+  }
+
+  private startPipeline(args: string[], frameTap: boolean) {
+    console.log('Starting in-process GStreamer pipeline:', args.join(' '));
+
+    try {
+      this.pipeline = new obsbot.CapturePipeline(args, (msg: any) => this.onPipelineMessage(msg));
+    } catch (error: any) {
+      console.error('[GStreamer] Failed to build pipeline:', error.message);
+      return;
+    }
+
+    if (frameTap) {
+      this.pipeline.connectAppSink('frame_sink', (jpeg: Buffer, timestamp: number) =>
+        frameTapService.push(jpeg, timestamp)
+      );
+    }
+
+    if (!this.pipeline.start()) {
+      console.error('[GStreamer] Pipeline failed to start');
+      this.restart();
+      return;
+    }
+    this.syncLiveBranch();
+  }
+
+  private onPipelineMessage(msg: { type: string; source: string; message: string; detail?: string }) {
+    switch (msg.type) {
+      case 'error':
+        console.error(`[GStreamer] ${msg.source}: ${msg.message}`);
+        if (msg.detail) console.error(`[GStreamer]   ${msg.detail}`);
+        // Let the bus callback return before tearing anything down
+        if (msg.source.startsWith('live_') && this.liveBranchId !== null) {
+          setImmediate(() => this.dropLiveBranch());
+        } else {
+          setImmediate(() => this.restart());
+        }
+        break;
+      case 'warning':
+        console.warn(`[GStreamer] ${msg.source}: ${msg.message}`);
+        break;
+      case 'state':
+        console.log(`[GStreamer] Pipeline ${msg.detail} -> ${msg.message}`);
+        break;
+      case 'eos':
+        this.onEos?.();
+        break;
+    }
+  }
+
+  // Rebuild the pipeline in-process: only the graph is recreated, no new
+  // process, so a failure costs about a second of footage
+  private restart() {
+    if (this.pipeline) {
+      this.pipeline.close();
+      this.pipeline = null;
+    }
+    this.liveBranchId = null;
+    if (this.stopping || !this.lastOptions) return;
+
+    const options = this.lastOptions;
+    console.log(`[GStreamer] Restarting pipeline in ${RESTART_DELAY_MS}ms`);
+    setTimeout(() => {
+      if (!this.stopping && !this.pipeline) this.startCapture(options);
+    }, RESTART_DELAY_MS);
+  }
+
+  /** Whether the pipeline runs in this process, where its settings can change live */
+  public isInProcess() {
+    return this.inProcess;
+  }
+
+  public getParams(): Record<ParamTarget, EncoderParams> {
+    return { live: { ...this.params.live }, recording: { ...this.params.recording } };
+  }
+
+  /**
+   * Change encoder settings of the live or recording output without
+   * restarting capture. Each changed field reports how it took effect (see
+   * ParamResult); anything the running pipeline can't take is kept for the
+   * next start. Throws on out-of-range values.
+   */
+  public setParams(target: ParamTarget, changes: Partial<EncoderParams>) {
+    const current = this.params[target];
+    const next = { ...current, ...changes };
+    this.validateParams(next);
+
+    const changed = (Object.keys(changes) as (keyof EncoderParams)[]).filter(
+      (key) => next[key] !== current[key]
+    );
+    this.params[target] = next;
+
+    const results: Partial<Record<keyof EncoderParams, ParamResult>> = {};
+    const report = (result: ParamResult) => changed.forEach((key) => (results[key] = result));
+
+    if (changed.length === 0) {
+      // Nothing to do
+    } else if (!this.pipeline) {
+      report('next-start');
+    } else if (target === 'live') {
+      this.applyLiveParams(changed, report);
+    } else if (this.rawRecording) {
+      report('unsupported');
+    } else {
+      for (const key of changed) {
+        results[key] = this.setEncoderProperty('rec_enc', key, next) ? 'applied' : 'next-start';
+      }
+    }
+
+    console.log(`[GStreamer] ${target} params:`, JSON.stringify(next), JSON.stringify(results));
+    return { params: { ...next }, results };
+  }
+
+  private applyLiveParams(
+    changed: (keyof EncoderParams)[],
+    report: (result: ParamResult) => void
+  ) {
+    if (!this.liveSource) {
+      // Permanent live output from a spawned or static graph
+      report('next-start');
+      return;
+    }
+    if (this.liveBranchId === null) {
+      report('deferred');
+      return;
+    }
+
+    // Bitrate can usually change on the running encoder; anything else needs a
+    // fresh branch (new caps or GOP), which starts on a keyframe anyway
+    if (
+      changed.every((key) => key === 'bitrateKbps') &&
+      this.setEncoderProperty('live_enc', 'bitrateKbps', this.params.live)
+    ) {
+      report('applied');
+      return;
+    }
+    this.pipeline.removeBranch(this.liveBranchId);
+    this.liveBranchId = null;
+    this.syncLiveBranch();
+    report(this.liveBranchId !== null ? 'rebuilt' : 'deferred');
+  }
+
+  // Runtime change of one encoder setting; false if the encoder doesn't allow it now
+  private setEncoderProperty(
+    element: string,
+    key: keyof EncoderParams,
+    params: EncoderParams
+  ): boolean {
+    // Resolution changes mid-stream would also change the caps of the open segment
+    if (key === 'width' || key === 'height') return false;
+    const encoder = element === 'live_enc' ? this.encoders.h264 : this.encoders.h265;
+    const prop = key === 'bitrateKbps' ? encoder.bitrateProp : encoder.gopProp;
+    if (!prop) return false; // driver controls, fixed at start
+    try {
+      const value =
+        key === 'bitrateKbps'
+          ? params.bitrateKbps * encoder.bitrateMultiplier
+          : params.keyframeInterval;
+      return this.pipeline.setProperty(element, prop, value);
+    } catch (error: any) {
+      console.error(`[GStreamer] Failed to set ${key} on ${element}:`, error.message);
+      return false;
+    }
+  }
+
+  /** Throws, as setParams would, if the changes are out of range; applies nothing */
+  public checkParams(target: ParamTarget, changes: Partial<EncoderParams>) {
+    this.validateParams({ ...this.params[target], ...changes });
+  }
+
+  private validateParams(params: EncoderParams) {
+    const inRange = (value: number, min: number, max: number) =>
+      Number.isInteger(value) && value >= min && value <= max;
+
+    if (!inRange(params.bitrateKbps, 100, 100000)) {
+      throw new Error('bitrateKbps must be an integer between 100 and 100000');
+    }
+    if (!inRange(params.keyframeInterval, 1, 600)) {
+      throw new Error('keyframeInterval must be an integer between 1 and 600 frames');
+    }
+    if (!inRange(params.width, 160, CAPTURE_WIDTH) || params.width % 2 !== 0) {
+      throw new Error(`width must be an even integer between 160 and ${CAPTURE_WIDTH}`);
+    }
+    if (!inRange(params.height, 90, CAPTURE_HEIGHT) || params.height % 2 !== 0) {
+      throw new Error(`height must be an even integer between 90 and ${CAPTURE_HEIGHT}`);
+    }
+  }
+
+  public async stopCapture() {
+    this.stopping = true;
+
+    if (this.pipeline) {
+      const pipeline = this.pipeline;
+      // EOS lets splitmuxsink finalize the current segment before teardown
+      await new Promise<void>((resolve) => {
+        const timer = setTimeout(resolve, EOS_TIMEOUT_MS);
+        this.onEos = () => {
+          clearTimeout(timer);
+          resolve();
+        };
+        if (!pipeline.sendEos()) {
+          clearTimeout(timer);
+          resolve();
+        }
+      });
+      this.onEos = null;
+      pipeline.close();
+      if (this.pipeline === pipeline) this.pipeline = null;
+      this.liveBranchId = null;
+      return;
+    }
+
     if (this.gstProcess) {
       // Send SIGINT so GStreamer can finalize the files (-e flag)
       this.gstProcess.kill('SIGINT');
@@ -284,7 +746,67 @@ export class GStreamerService {
   }
 
   public isRunning() {
-    return this.gstProcess !== null;
+    return this.gstProcess !== null || this.pipeline !== null;
+  }
+
+  /** Pipeline state, queue levels and drop counters (in-process only) */
+  public getStats() {
+    return this.pipeline ? this.pipeline.getStats() : null;
+  }
+
+  /**
+   * Congestion signals of the attached live branch, or null while none is
+   * attached. Counters are cumulative for the branch; a new branch id means
+   * they started over (queue overruns and QoS drops are both dropped
+   * natively with the branch they belong to).
+   */
+  public getLiveHealth() {
+    if (!this.pipeline || this.liveBranchId === null) return null;
+
+    const stats = this.pipeline.getStats();
+    const queue = stats.queues?.find((q: any) => q.name === 'live_q');
+    // Frames live elements dropped for lateness (live_rate drops on purpose)
+    const dropped = Object.entries((stats.qosDropped || {}) as Record<string, number>)
+      .filter(([source]) => source.startsWith('live_') && source !== 'live_rate')
+      .reduce((sum, [, count]) => sum + count, 0);
+
+    let rtcp: any = null;
+    try {
+      rtcp = this.pipeline.getRtcpStats('live_sink')[0] || null;
+    } catch {
+      // Sink not set up yet
+    }
+
+    return {
+      branch: this.liveBranchId,
+      queueFill: queue ? (queue.fill as number) : 0,
+      overruns: queue ? (queue.overruns as number) : 0,
+      dropped,
+      rtcp: rtcp as { fractionLost: number; roundTripMs: number; jitterMs: number | null } | null,
+      maxBitrateKbps: this.params.live.bitrateKbps,
+      maxFramerate: CAPTURE_FPS,
+    };
+  }
+
+  /**
+   * Change the running live encoder's bitrate or frame rate cap without
+   * touching the configured params. False if the element doesn't take the
+   * change while playing.
+   */
+  public adaptLive(change: { bitrateKbps: number } | { framerate: number }): boolean {
+    if (!this.pipeline || this.liveBranchId === null) return false;
+    try {
+      if ('bitrateKbps' in change) {
+        const encoder = this.encoders.h264;
+        if (!encoder.bitrateProp) return false;
+        const bitrate = change.bitrateKbps * encoder.bitrateMultiplier;
+        return this.pipeline.setProperty('live_enc', encoder.bitrateProp, bitrate);
+      }
+      return this.pipeline.setProperty('live_rate', 'max-rate', change.framerate);
+    } catch (error: any) {
+      console.error('[GStreamer] Live rate change failed:', error.message);
+      return false;
+    }
   }
 }
 
@@ -0,0 +1,153 @@
+import * as fs from 'fs';
+import * as path from 'path';
+import * as chokidar from 'chokidar';
+import { obsbot } from './native';
+
+export interface KeywordRule {
+  name: string;
+  phrases: string[];
+  reason: string;
+  bufferBeforeMs: number;
+  bufferAfterMs: number;
+  cooldownMs: number;
+}
+
+export interface KeywordHit {
+  rule: KeywordRule;
+  phrase: string;
+}
+
+// Used when there is no config file
+const DEFAULT_RULES: KeywordRule[] = [
+  {
+    name: 'default',
+    phrases: ['look', 'amazing', 'god', 'wow', 'baby', 'dancing'],
+    reason: 'Audio Trigger',
+    bufferBeforeMs: 60000,
+    bufferAfterMs: 30000,
+    cooldownMs: 0,
+  },
+];
+
+/**
+ * Keyword trigger rules loaded from KEYWORDS_CONFIG (JSON, reloaded on change).
+ * All phrases are compiled into one native Aho-Corasick matcher, so a
+ * transcript is scanned once regardless of vocabulary size.
+ *
+ * {
+ *   "rules": [
+ *     { "name": "excitement", "phrases": ["wow", "oh my god"], "reason": "Excitement",
+ *       "bufferBeforeMs": 60000, "bufferAfterMs": 30000, "cooldownMs": 30000 },
+ *     { "name": "products", "phrasesFile": "products.txt" }
+ *   ]
+ * }
+ *
+ * phrasesFile is relative to the config and holds one phrase per line (# comments).
+ */
+export class KeywordService {
+  private configPath = path.resolve(process.env.KEYWORDS_CONFIG || 'keywords.json');
+  private rules: KeywordRule[] = DEFAULT_RULES;
+  private matcher: any = null;
+  private lastFired = new Map<string, number>();
+
+  constructor() {
+    this.load();
+    this.watchConfig();
+  }
+
+  private load() {
+    let rules = DEFAULT_RULES;
+
+    if (fs.existsSync(this.configPath)) {
+      try {
+        rules = this.parseConfig(JSON.parse(fs.readFileSync(this.configPath, 'utf-8')));
+      } catch (error: any) {
+        console.error(`[Keywords] Failed to load ${this.configPath}:`, error.message);
+        return;
+      }
+    }
+
+    this.rules = rules;
+    this.matcher = obsbot?.KeywordMatcher
+      ? new obsbot.KeywordMatcher(rules.map((r) => r.phrases))
+      : null;
+
+    const phrases = rules.reduce((n, r) => n + r.phrases.length, 0);
+    console.log(
+      `[Keywords] Loaded ${rules.length} rules, ${phrases} phrases (${this.matcher ? 'native' : 'JS'} matcher)`
+    );
+  }
+
+  private parseConfig(config: any): KeywordRule[] {
+    if (!Array.isArray(config?.rules)) {
+      throw new Error('Config must contain a "rules" array');
+    }
+
+    const baseDir = path.dirname(this.configPath);
+    return config.rules.map((rule: any, i: number) => {
+      const phrases: string[] = Array.isArray(rule.phrases) ? [...rule.phrases] : [];
+      if (rule.phrasesFile) {
+        const lines = fs.readFileSync(path.resolve(baseDir, rule.phrasesFile), 'utf-8').split('\n');
+        for (const line of lines) {
+          const phrase = line.trim();
+          if (phrase && !phrase.startsWith('#')) phrases.push(phrase);
+        }
+      }
+
+      return {
+        name: rule.name || `rule${i}`,
+        phrases,
+        reason: rule.reason || 'Audio Trigger',
+        bufferBeforeMs: rule.bufferBeforeMs ?? 60000,
+        bufferAfterMs: rule.bufferAfterMs ?? 30000,
+        cooldownMs: rule.cooldownMs ?? 0,
+      };
+    });
+  }
+
+  private watchConfig() {
+    const watcher = chokidar.watch(this.configPath, {
+      persistent: true,
+      ignoreInitial: true,
+    });
+
+    watcher.on('add', () => this.load());
+    watcher.on('change', () => this.load());
+  }
+
+  /** Rules matching the transcript that are not cooling down at this timestamp */
+  public match(transcript: string, timestamp: number): KeywordHit[] {
+    if (!transcript) return [];
+
+    const found: { rule: number; phrase: string }[] = this.matcher
+      ? this.matcher.match(transcript)
+      : this.matchJs(transcript);
+
+    const hits: KeywordHit[] = [];
+    for (const { rule: index, phrase } of found) {
+      const rule = this.rules[index];
+      const last = this.lastFired.get(rule.name);
+      if (last !== undefined && Math.abs(timestamp - last) < rule.cooldownMs) continue;
+
+      this.lastFired.set(rule.name, timestamp);
+      hits.push({ rule, phrase });
+    }
+    return hits;
+  }
+
+  // Fallback when the native addon is unavailable: same word-boundary
+  // semantics, but a linear scan over every phrase
+  private matchJs(transcript: string) {
+    const normalize = (s: string) => ` ${s.toLowerCase().replace(/[^\p{L}\p{N}]+/gu, ' ').trim()} `;
+    const text = normalize(transcript);
+
+    const found: { rule: number; phrase: string }[] = [];
+    this.rules.forEach((rule, index) => {
+      const phrase = rule.phrases.find((p) => normalize(p).length > 2 && text.includes(normalize(p)));
+      if (phrase) found.push({ rule: index, phrase });
+    });
+    return found;
+  }
+}
+
+export const keywordService = new KeywordService();
@@ -0,0 +1,190 @@
+import { gstreamerService } from './gstreamer';
+
+type RateAction = 'decrease' | 'increase' | 'fps-down' | 'fps-up';
+
+interface RateDecision {
+  at: number;
+  action: RateAction;
+  bitrateKbps: number;
+  framerate: number;
+  reason: string;
+}
+
+/**
+ * Closed-loop rate control for the live stream, so a congested link shows
+ * lower quality instead of frozen video. Once a second it reads the live
+ * branch's congestion signals: the fill of its queue and frames dropped
+ * there, frames dropped late by the encoder or sink, and packet loss from
+ * the RTSP server's RTCP receiver reports. It steps the encoder bitrate down
+ * while they persist and, at the floor, the frame rate. When the link has
+ * been clear for a while it restores the frame rate first, then the bitrate,
+ * up to the configured live bitrate. Requires the in-process pipeline.
+ */
+export class LiveBitrateController {
+  private enabled = process.env.LIVE_ABR !== 'false';
+  private minKbps = parseInt(process.env.LIVE_ABR_MIN_KBPS || '500');
+  private minFps = parseInt(process.env.LIVE_ABR_MIN_FPS || '10');
+  private maxLoss = parseFloat(process.env.LIVE_ABR_MAX_LOSS || '0.05');
+  private intervalMs = 1000;
+
+  // Hysteresis: step down after a short run of congested samples, up only
+  // after a long run of clear ones, and never change twice within holdMs
+  private downAfter = 2;
+  private upAfter = 10;
+  private holdMs = 3000;
+  private decreaseFactor = 0.7;
+  private fpsStep = 5;
+
+  private timer: NodeJS.Timeout | null = null;
+  private branch: number | null = null;
+  private maxKbps = 0;
+  private maxFps = 0;
+  private bitrateKbps = 0;
+  private framerate = 0;
+  private fpsAdjustable = true;
+  private stuck = false;
+
+  private congestedTicks = 0;
+  private clearTicks = 0;
+  private lastChange = 0;
+  private lastCounters = { overruns: 0, dropped: 0 };
+  private signals: {
+    queueFill: number;
+    overruns: number;
+    dropped: number;
+    fractionLost: number | null;
+    roundTripMs: number | null;
+  } | null = null;
+
+  private decisions: Record<RateAction, number> = {
+    decrease: 0,
+    increase: 0,
+    'fps-down': 0,
+    'fps-up': 0,
+  };
+  private lastDecision: RateDecision | null = null;
+
+  public start() {
+    if (!this.enabled || this.timer) return;
+    this.timer = setInterval(() => this.tick(), this.intervalMs);
+  }
+
+  private tick() {
+    const health = gstreamerService.getLiveHealth();
+    if (!health) {
+      this.branch = null;
+      this.signals = null;
+      return;
+    }
+
+    const now = Date.now();
+    if (health.branch !== this.branch || health.maxBitrateKbps !== this.maxKbps) {
+      // New branch, or the configured bitrate changed: start from the top
+      this.branch = health.branch;
+      this.maxKbps = this.bitrateKbps = health.maxBitrateKbps;
+      this.maxFps = this.framerate = health.maxFramerate;
+      this.fpsAdjustable = true;
+      this.stuck = false;
+      this.lastCounters = { overruns: health.overruns, dropped: health.dropped };
+      this.congestedTicks = this.clearTicks = 0;
+      this.lastChange = now;
+      return;
+    }
+
+    const overruns = health.overruns - this.lastCounters.overruns;
+    const dropped = health.dropped - this.lastCounters.dropped;
+    this.lastCounters = { overruns: health.overruns, dropped: health.dropped };
+    const loss = health.rtcp?.fractionLost ?? 0;
+    this.signals = {
+      queueFill: health.queueFill,
+      overruns,
+      dropped,
+      fractionLost: health.rtcp ? health.rtcp.fractionLost : null,
+      roundTripMs: health.rtcp ? health.rtcp.roundTripMs : null,
+    };
+
+    const congested =
+      overruns > 0 || dropped > 0 || health.queueFill > 0.5 || loss > this.maxLoss;
+    const clear = !congested && health.queueFill < 0.2 && loss < this.maxLoss / 5;
+    // In between is the dead band: neither run grows
+    this.congestedTicks = congested ? this.congestedTicks + 1 : 0;
+    this.clearTicks = clear ? this.clearTicks + 1 : 0;
+
+    if (this.stuck || now - this.lastChange < this.holdMs) return;
+
+    if (this.congestedTicks >= this.downAfter) {
+      const reason = this.describe(overruns, dropped, health.queueFill, loss);
+      if (this.bitrateKbps > this.minKbps) {
+        const bitrate = Math.round(this.bitrateKbps * this.decreaseFactor);
+        this.apply('decrease', Math.max(this.minKbps, bitrate), this.framerate, reason);
+      } else if (this.fpsAdjustable && this.framerate > this.minFps) {
+        const framerate = Math.max(this.minFps, this.framerate - this.fpsStep);
+        this.apply('fps-down', this.bitrateKbps, framerate, reason);
+      }
+    } else if (this.clearTicks >= this.upAfter) {
+      const reason = `clear for ${this.clearTicks}s`;
+      if (this.framerate < this.maxFps) {
+        const framerate = Math.min(this.maxFps, this.framerate + this.fpsStep);
+        this.apply('fps-up', this.bitrateKbps, framerate, reason);
+      } else if (this.bitrateKbps < this.maxKbps) {
+        // Additive increase, so probing upwards stays gentle
+        const step = Math.max(100, Math.round(this.maxKbps * 0.1));
+        const bitrate = Math.min(this.maxKbps, this.bitrateKbps + step);
+        this.apply('increase', bitrate, this.framerate, reason);
+      }
+    }
+  }
+
+  private describe(overruns: number, dropped: number, fill: number, loss: number): string {
+    const reasons: string[] = [];
+    if (fill > 0.5) reasons.push(`queue ${Math.round(fill * 100)}%`);
+    if (overruns > 0) reasons.push(`${overruns} queue drops`);
+    if (dropped > 0) reasons.push(`${dropped} late drops`);
+    if (loss > this.maxLoss) reasons.push(`${(loss * 100).toFixed(1)}% loss`);
+    return reasons.join(', ');
+  }
+
+  private apply(action: RateAction, bitrateKbps: number, framerate: number, reason: string) {
+    if (bitrateKbps !== this.bitrateKbps && !gstreamerService.adaptLive({ bitrateKbps })) {
+      // The encoder only takes its bitrate at startup; nothing to control
+      console.warn('[LiveABR] Live encoder takes no bitrate changes while playing, giving up');
+      this.stuck = true;
+      return;
+    }
+    if (framerate !== this.framerate && !gstreamerService.adaptLive({ framerate })) {
+      console.warn('[LiveABR] Frame rate cap not adjustable while playing, bitrate only');
+      this.fpsAdjustable = false;
+      return;
+    }
+
+    this.bitrateKbps = bitrateKbps;
+    this.framerate = framerate;
+    this.lastChange = Date.now();
+    this.congestedTicks = this.clearTicks = 0;
+    this.decisions[action]++;
+    this.lastDecision = { at: this.lastChange, action, bitrateKbps, framerate, reason };
+    console.log(`[LiveABR] ${action}: ${bitrateKbps} kbps, ${framerate} fps (${reason})`);
+  }
+
+  public getStats() {
+    return {
+      enabled: this.enabled,
+      active: this.branch !== null && !this.stuck,
+      bitrateKbps: this.branch !== null ? this.bitrateKbps : null,
+      framerate: this.branch !== null ? this.framerate : null,
+      maxBitrateKbps: this.maxKbps,
+      signals: this.signals,
+      decisions: { ...this.decisions },
+      lastDecision: this.lastDecision,
+    };
+  }
+
+  public stop() {
+    if (this.timer) {
+      clearInterval(this.timer);
+      this.timer = null;
+    }
+  }
+}
+
+export const liveBitrateController = new LiveBitrateController();
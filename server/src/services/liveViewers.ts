@@ -0,0 +1,103 @@
+import { EventEmitter } from 'events';
+
+/**
+ * Tracks whether anyone is watching the live stream, so the live encoder only
+ * runs while it is needed. Viewers are web clients (their gimbal WebSocket is
+ * open while the video is on screen) and readers of the MediaMTX path, polled
+ * from its API. MediaMTX can also announce a new reader before the stream
+ * exists through runOnDemand (POST /api/live/demand). Emits 'change' with the
+ * new state; demand ends LIVE_IDLE_TIMEOUT_MS after the last viewer leaves.
+ */
+export class LiveViewerService extends EventEmitter {
+  private idleTimeoutMs = parseInt(process.env.LIVE_IDLE_TIMEOUT_MS || '30000');
+  private apiUrl = process.env.MEDIAMTX_API || 'http://localhost:9997';
+  private pathName = this.parsePathName(process.env.RTSP_URL || 'rtsp://localhost:8554/live');
+  private pollMs = 5000;
+
+  private webClients = 0;
+  private readers = 0;
+  private demandUntil = 0;
+  private lastViewer = 0;
+  private active = false;
+  private timer: NodeJS.Timeout | null = null;
+
+  private parsePathName(url: string): string {
+    try {
+      return new URL(url).pathname.replace(/^\//, '') || 'live';
+    } catch {
+      return 'live';
+    }
+  }
+
+  public get isActive(): boolean {
+    return this.active;
+  }
+
+  public start() {
+    if (this.timer) return;
+    this.timer = setInterval(() => this.poll(), this.pollMs);
+  }
+
+  public addClient() {
+    this.webClients++;
+    this.update();
+  }
+
+  public removeClient() {
+    this.webClients = Math.max(0, this.webClients - 1);
+    this.update();
+  }
+
+  /** A reader is about to connect (MediaMTX runOnDemand); hold the stream up meanwhile */
+  public requestDemand(holdMs = 20000) {
+    this.demandUntil = Math.max(this.demandUntil, Date.now() + holdMs);
+    this.update();
+  }
+
+  private async poll() {
+    try {
+      const res = await fetch(`${this.apiUrl}/v3/paths/get/${this.pathName}`, {
+        signal: AbortSignal.timeout(2000),
+      });
+      // 404 while nothing is publishing: no readers either
+      const body: any = res.ok ? await res.json() : null;
+      this.readers = Array.isArray(body?.readers) ? body.readers.length : 0;
+    } catch {
+      this.readers = 0; // MediaMTX not reachable
+    }
+    this.update();
+  }
+
+  private update() {
+    const now = Date.now();
+    if (this.webClients > 0 || this.readers > 0 || now < this.demandUntil) {
+      this.lastViewer = now;
+    }
+
+    const active = now - this.lastViewer < this.idleTimeoutMs && this.lastViewer > 0;
+    if (active !== this.active) {
+      this.active = active;
+      console.log(
+        `[LiveViewers] ${active ? 'Viewer connected, starting' : 'No viewers, stopping'} live stream`
+      );
+      this.emit('change', active);
+    }
+  }
+
+  public getStats() {
+    return {
+      active: this.active,
+      webClients: this.webClients,
+      readers: this.readers,
+    };
+  }
+
+  public stop() {
+    if (this.timer) {
+      clearInterval(this.timer);
+      this.timer = null;
+    }
+  }
+}
+
+export const liveViewerService = new LiveViewerService();
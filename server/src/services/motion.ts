@@ -0,0 +1,149 @@
+import { EventEmitter } from 'events';
+import { frameTapService, TappedFrame } from './frameTap';
+import { segmentManager } from './segmentManager';
+import { cameraService } from './camera';
+import { obsbot } from './native';
+
+export interface MotionInterval {
+  start: number; // epoch ms
+  end: number;
+  peakScore: number; // largest changed fraction seen
+}
+
+// Consecutive motion frames needed to open an interval, to ignore flicker
+const MIN_MOTION_FRAMES = 2;
+
+/**
+ * Marks segments for keeping when something moves in frame. Frames come from
+ * the MJPEG tap; the native MotionDetector decodes them at 1/8 scale and
+ * compares against an adaptive background. Emits 'motion-start' and 'motion'
+ * (a closed MotionInterval). Detection pauses while the camera itself moves:
+ * for MOTION_MOVE_SETTLE_MS after each gimbal, zoom or preset command, and
+ * for as long as AI tracking is on. The background is re-learned when it
+ * resumes.
+ */
+export class MotionService extends EventEmitter {
+  private enabled = process.env.ENABLE_MOTION === 'true';
+  private holdMs = parseInt(process.env.MOTION_HOLD_MS || '2000');
+  private bufferBeforeMs = parseInt(process.env.MOTION_BUFFER_BEFORE_MS || '30000');
+  private bufferAfterMs = parseInt(process.env.MOTION_BUFFER_AFTER_MS || '30000');
+  private settleMs = parseInt(process.env.MOTION_MOVE_SETTLE_MS || '1000');
+  private detector: any = null;
+
+  // Paused while the camera moves; the background is stale once it has
+  private tracking = false;
+  private pausedUntil = 0;
+  private moved = false;
+
+  private streak = 0;
+  private active: MotionInterval | null = null;
+  private lastMotion = 0;
+
+  constructor() {
+    super();
+    if (!this.enabled) return;
+
+    if (!obsbot?.MotionDetector) {
+      console.log('[Motion] Native detector not available (addon built without libjpeg)');
+      return;
+    }
+
+    let masks = [];
+    try {
+      masks = JSON.parse(process.env.MOTION_MASKS || '[]');
+    } catch (error) {
+      console.error('[Motion] Invalid MOTION_MASKS, ignoring:', error);
+    }
+
+    const options = {
+      threshold: parseInt(process.env.MOTION_THRESHOLD || '20'),
+      minArea: parseFloat(process.env.MOTION_MIN_AREA || '0.005'),
+    };
+    try {
+      this.detector = new obsbot.MotionDetector({ ...options, masks });
+    } catch (error: any) {
+      console.error('[Motion] Invalid MOTION_MASKS, ignoring:', error.message);
+      this.detector = new obsbot.MotionDetector(options);
+    }
+
+    if (frameTapService.start()) {
+      frameTapService.on('frame', (frame: TappedFrame) => this.onFrame(frame));
+    }
+    cameraService.on('move', () => this.pause());
+    cameraService.on('tracking', (tracking: boolean) => {
+      this.tracking = tracking;
+      this.pause();
+    });
+  }
+
+  private pause() {
+    this.pausedUntil = Date.now() + this.settleMs;
+    this.moved = true;
+    this.streak = 0;
+  }
+
+  private async onFrame(frame: TappedFrame) {
+    if (this.tracking || Date.now() < this.pausedUntil) return;
+    if (this.moved) {
+      this.moved = false;
+      this.reset();
+    }
+
+    // null while the previous frame is still being analyzed
+    const pending = this.detector.process(frame.jpeg);
+    if (!pending) return;
+
+    try {
+      const result = await pending;
+      this.update(result.motion, result.score, frame.timestamp);
+    } catch (error: any) {
+      console.error('[Motion] Failed to analyze frame:', error.message);
+    }
+  }
+
+  private update(motion: boolean, score: number, timestamp: number) {
+    if (motion) {
+      this.streak++;
+      this.lastMotion = timestamp;
+
+      if (this.active) {
+        this.active.end = timestamp;
+        this.active.peakScore = Math.max(this.active.peakScore, score);
+      } else if (this.streak >= MIN_MOTION_FRAMES) {
+        this.active = { start: timestamp, end: timestamp, peakScore: score };
+        console.log(`[Motion] Started (${(score * 100).toFixed(1)}% of frame)`);
+        // Mark right away so the footage is safe even if the interval never closes
+        segmentManager.markForKeeping(timestamp, 'Motion Trigger', this.bufferBeforeMs, this.bufferAfterMs);
+        this.emit('motion-start', { ...this.active });
+      }
+      return;
+    }
+
+    this.streak = 0;
+    if (this.active && timestamp - this.lastMotion >= this.holdMs) {
+      const interval = this.active;
+      this.active = null;
+
+      const seconds = ((interval.end - interval.start) / 1000).toFixed(1);
+      console.log(`[Motion] Ended after ${seconds}s (peak ${(interval.peakScore * 100).toFixed(1)}%)`);
+      segmentManager.markForKeeping(
+        interval.start,
+        `Motion Trigger (${seconds}s)`,
+        this.bufferBeforeMs,
+        interval.end - interval.start + this.bufferAfterMs
+      );
+      this.emit('motion', interval);
+    }
+  }
+
+  /** Re-learn the background, e.g. after the camera moved */
+  public reset() {
+    this.detector?.reset();
+  }
+
+  public getStats() {
+    return this.detector ? this.detector.getStats() : null;
+  }
+}
+
+export const motionService = new MotionService();
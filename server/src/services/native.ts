@@ -0,0 +1,11 @@
+// Load native addon once and share it between services
+let obsbot: any;
+try {
+  // We expect the build to be in the root's build/Release folder
+  obsbot = require('../../build/Release/obsbot_native.node');
+} catch (e) {
+  console.error('Failed to load native addon:', e);
+  obsbot = null;
+}
+
+export { obsbot };
@@ -0,0 +1,174 @@
+import * as fs from 'fs';
+import * as path from 'path';
+import * as chokidar from 'chokidar';
+import { segmentManager } from './segmentManager';
+
+interface PrerollFile {
+  filename: string;
+  startedAt: number;
+}
+
+interface KeepWindow {
+  start: number;
+  end: number;
+  reason: string;
+}
+
+/**
+ * Full-resolution side of RECORD_PROFILE=dual. The capture pipeline records
+ * a continuous 480p proxy into recordings/proxy and the full-resolution
+ * stream into recordings/preroll, in segments of the same length. Finished
+ * pre-roll segments that overlap a markForKeeping window are committed: they
+ * are registered as kept, linked with the proxy recorded alongside them and
+ * moved into recordings/segments. The rest are deleted once they are older
+ * than PREROLL_MS, so only the proxy runs up disk around the clock.
+ */
+export class PrerollService {
+  public readonly enabled = process.env.RECORD_PROFILE === 'dual';
+  private recordingsDir = path.join(process.cwd(), 'recordings');
+  private prerollDir = path.join(this.recordingsDir, 'preroll');
+  private segmentsDir = path.join(this.recordingsDir, 'segments');
+  private prerollMs = parseInt(process.env.PREROLL_MS || '120000');
+  private segmentMs = 30000;
+
+  private watcher: chokidar.FSWatcher | null = null;
+  private timer: NodeJS.Timeout | null = null;
+  private ready = false;
+  private files: PrerollFile[] = []; // oldest first; the last one is still being written
+  private windows: KeepWindow[] = [];
+  private committed = 0;
+  private discarded = 0;
+  private lastCommit: { filename: string; proxy: string | null; reason: string } | null = null;
+
+  public start() {
+    if (!this.enabled || this.watcher) return;
+    fs.mkdirSync(this.prerollDir, { recursive: true });
+
+    // Files left over from a previous run are picked up too and age out normally
+    this.watcher = chokidar.watch(this.prerollDir, {
+      ignored: /(^|[\/\\])\../,
+      persistent: true,
+      ignoreInitial: false,
+    });
+    this.watcher.on('add', (filePath) => this.onFile(filePath));
+    this.watcher.on('ready', () => (this.ready = true));
+
+    segmentManager.on('keep', (window: KeepWindow) => {
+      this.windows.push(window);
+      this.tick();
+    });
+    this.timer = setInterval(() => this.tick(), 5000);
+    console.log(`[Preroll] Holding full-res segments for ${this.prerollMs / 1000}s`);
+  }
+
+  private onFile(filePath: string) {
+    const filename = path.basename(filePath);
+    if (path.extname(filename) !== '.mp4') return;
+
+    let startedAt = Date.now();
+    if (!this.ready) {
+      try {
+        startedAt = fs.statSync(filePath).mtimeMs - this.segmentMs;
+      } catch {
+        return;
+      }
+    }
+
+    // A restarted pipeline reuses index-based names; the new file replaces the old entry
+    this.files = this.files.filter((f) => f.filename !== filename);
+    this.files.push({ filename, startedAt });
+    this.files.sort((a, b) => a.startedAt - b.startedAt);
+  }
+
+  private tick() {
+    const now = Date.now();
+    // A window can still match the segment that was open when it ended
+    this.windows = this.windows.filter((w) => w.end > now - this.segmentMs * 2);
+
+    const remaining: PrerollFile[] = [];
+    this.files.forEach((file, i) => {
+      const next = this.files[i + 1];
+      if (!next) {
+        remaining.push(file);
+        return;
+      }
+
+      const endedAt = next.startedAt;
+      const window = this.windows.find((w) => file.startedAt <= w.end && endedAt >= w.start);
+      if (window && this.commit(file, window)) return;
+      if (!window && endedAt < now - this.prerollMs && this.discard(file)) return;
+      remaining.push(file);
+    });
+    this.files = remaining;
+  }
+
+  private commit(file: PrerollFile, window: KeepWindow): boolean {
+    // Index-based names (gst_%05d) repeat across runs, so kept files are named by time
+    const timestamped = /^\d{8}_\d{6}/.test(file.filename);
+    const filename = timestamped ? file.filename : `${this.formatTime(file.startedAt)}.mp4`;
+    const proxyName = `proxy_${file.filename.replace(/^gst_/, '')}`;
+    const proxy = segmentManager.findProxy(proxyName, file.startedAt);
+
+    try {
+      segmentManager.registerKept(filename, file.startedAt, window.reason, proxy);
+      fs.renameSync(
+        path.join(this.prerollDir, file.filename),
+        path.join(this.segmentsDir, filename)
+      );
+    } catch (error: any) {
+      console.error(`[Preroll] Failed to commit ${file.filename}:`, error.message);
+      return false;
+    }
+
+    this.committed++;
+    this.lastCommit = { filename, proxy, reason: window.reason };
+    console.log(`[Preroll] Kept ${file.filename} as ${filename} (proxy: ${proxy ?? 'none'})`);
+    return true;
+  }
+
+  private discard(file: PrerollFile): boolean {
+    try {
+      fs.rmSync(path.join(this.prerollDir, file.filename), { force: true });
+    } catch (error: any) {
+      console.error(`[Preroll] Failed to delete ${file.filename}:`, error.message);
+      return false;
+    }
+    this.discarded++;
+    return true;
+  }
+
+  // Local time, matching the names FFmpeg's strftime segments get
+  private formatTime(ms: number): string {
+    const d = new Date(ms);
+    const pad = (n: number) => String(n).padStart(2, '0');
+    return (
+      `${d.getFullYear()}${pad(d.getMonth() + 1)}${pad(d.getDate())}_` +
+      `${pad(d.getHours())}${pad(d.getMinutes())}${pad(d.getSeconds())}`
+    );
+  }
+
+  public getStats() {
+    return {
+      enabled: this.enabled,
+      prerollMs: this.prerollMs,
+      pending: this.files.length,
+      windows: this.windows.length,
+      committed: this.committed,
+      discarded: this.discarded,
+      lastCommit: this.lastCommit,
+    };
+  }
+
+  public stop() {
+    if (this.timer) {
+      clearInterval(this.timer);
+      this.timer = null;
+    }
+    if (this.watcher) {
+      this.watcher.close();
+      this.watcher = null;
+    }
+  }
+}
+
+export const prerollService = new PrerollService();
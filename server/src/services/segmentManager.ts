@@ -1,3 +1,4 @@
+import { EventEmitter } from 'events';
 import * as fs from 'fs';
 import * as path from 'path';
 import * as chokidar from 'chokidar';
@@ -5,20 +6,89 @@ import Database from 'better-sqlite3';
 
 export interface Segment {
   filename: string;
-  type: 'video' | 'audio';
+  type: SegmentType;
   timestamp: number;
   keep: boolean;
   reason?: string;
+  speech_ratio?: number | null; // audio only: fraction of voiced frames
+  codec?: string | null; // video only: probed codec, e.g. 'mjpeg' before transcoding
+  linked?: string | null; // RECORD_PROFILE=dual: the full-res file of a proxy, and vice versa
 }
 
-export class SegmentManager {
+// 'proxy': continuous low-resolution recording of RECORD_PROFILE=dual
+export type SegmentType = 'video' | 'audio' | 'proxy';
+
+export interface TranscriptWord {
+  start: number; // epoch ms
+  end: number;
+  text: string;
+}
+
+export interface TranscriptMatch {
+  id: number;
+  source: string | null; // audio segment the transcript came from, null when streamed
+  start: number;
+  end: number;
+  text: string;
+  matches: TranscriptWord[]; // words (or phrases) matching the query
+  segment: { filename: string; offsetMs: number } | null; // video containing the first match
+}
+
+// Interval without recording because the capture process crashed or stalled
+export interface CaptureGap {
+  id: number;
+  start: number; // epoch ms of the last frame before the gap
+  end: number | null; // first frame after it, null while still open
+  reason: string;
+}
+
+// Saved camera configuration; data is the native profile blob (versioned binary)
+export interface CameraProfile {
+  name: string;
+  version: number; // blob format version
+  product_type: number;
+  created: number; // epoch ms
+  data: Buffer;
+}
+
+// Segments are cut every 30 s, but only on a keyframe, so one can run past
+// 30 s by up to a GOP; twice the nominal length covers that. Segments that
+// start further back than this do not contain the match
+const MAX_SEGMENT_MS = 60000;
+// Nominal segment lengths, and the speech WAVs' 16 kHz mono s16 byte rate
+const VIDEO_SEGMENT_MS = 30000;
+const WAV_HEADER_BYTES = 44;
+const WAV_BYTES_PER_MS = 32;
+
+/**
+ * Start of a finished segment whose name has no timestamp (GStreamer's indexed
+ * files). mtime is the segment's last write, so its length is taken off: the
+ * WAV's from its size, a video's nominal length otherwise.
+ */
+export function finishedSegmentStart(stats: fs.Stats, type: SegmentType): number {
+  const durationMs =
+    type === 'audio'
+      ? Math.max(0, stats.size - WAV_HEADER_BYTES) / WAV_BYTES_PER_MS
+      : VIDEO_SEGMENT_MS;
+  return stats.mtimeMs - durationMs;
+}
+
+/**
+ * Segment and transcript database. Emits 'keep' ({ start, end, reason }) when
+ * a time range is marked for keeping, so recordings that are not segments
+ * yet (the dual profile's pre-roll) can be committed too, and 'segment'
+ * (filename) when a segment is registered.
+ */
+export class SegmentManager extends EventEmitter {
   private db: Database.Database;
   private recordingsDir = path.join(process.cwd(), 'recordings');
   private segmentsDir = path.join(this.recordingsDir, 'segments');
   private audioDir = path.join(this.recordingsDir, 'audio');
+  private proxyDir = path.join(this.recordingsDir, 'proxy');
   private retentionBufferMs = 24 * 60 * 60 * 1000; // 24 hours
 
   constructor() {
+    super();
     this.db = new Database(path.join(this.recordingsDir, 'metadata.db'));
     this.initializeDb();
     this.startWatching();
@@ -35,14 +105,71 @@ export class SegmentManager {
                 reason TEXT
             )
         `);
+
+    // Columns added after the initial schema
+    const columns = this.db.prepare('PRAGMA table_info(segments)').all() as { name: string }[];
+    if (!columns.some((c) => c.name === 'speech_ratio')) {
+      this.db.exec('ALTER TABLE segments ADD COLUMN speech_ratio REAL');
+    }
+    if (!columns.some((c) => c.name === 'codec')) {
+      this.db.exec('ALTER TABLE segments ADD COLUMN codec TEXT');
+    }
+    if (!columns.some((c) => c.name === 'linked')) {
+      this.db.exec('ALTER TABLE segments ADD COLUMN linked TEXT');
+    }
+
+    // Transcripts with word timings (JSON [[startOffsetMs, endOffsetMs, word], ...]
+    // relative to start), indexed for full-text search by an external-content
+    // FTS5 table kept in sync by triggers.
+    this.db.exec(`
+            CREATE TABLE IF NOT EXISTS transcripts (
+                id INTEGER PRIMARY KEY,
+                source TEXT,
+                start INTEGER NOT NULL,
+                end INTEGER NOT NULL,
+                text TEXT NOT NULL,
+                words TEXT
+            );
+            CREATE INDEX IF NOT EXISTS transcripts_start ON transcripts(start);
+            CREATE INDEX IF NOT EXISTS segments_type_timestamp ON segments(type, timestamp);
+
+            CREATE VIRTUAL TABLE IF NOT EXISTS transcripts_fts USING fts5(
+                text, content='transcripts', content_rowid='id',
+                tokenize='unicode61 remove_diacritics 2'
+            );
+            CREATE TRIGGER IF NOT EXISTS transcripts_ai AFTER INSERT ON transcripts BEGIN
+                INSERT INTO transcripts_fts(rowid, text) VALUES (new.id, new.text);
+            END;
+            CREATE TRIGGER IF NOT EXISTS transcripts_ad AFTER DELETE ON transcripts BEGIN
+                INSERT INTO transcripts_fts(transcripts_fts, rowid, text) VALUES ('delete', old.id, old.text);
+            END;
+
+            CREATE TABLE IF NOT EXISTS capture_gaps (
+                id INTEGER PRIMARY KEY,
+                start INTEGER NOT NULL,
+                end INTEGER,
+                reason TEXT NOT NULL
+            );
+
+            CREATE TABLE IF NOT EXISTS profiles (
+                name TEXT PRIMARY KEY,
+                version INTEGER NOT NULL,
+                product_type INTEGER NOT NULL,
+                created INTEGER NOT NULL,
+                data BLOB NOT NULL
+            );
+        `);
   }
 
   private startWatching() {
-    const watcher = chokidar.watch([this.segmentsDir, this.audioDir], {
+    const watcher = chokidar.watch([this.segmentsDir, this.audioDir, this.proxyDir], {
       ignored: /(^|[\/\\])\../,
       persistent: true,
       ignoreInitial: false,
     });
+    // Files found by the initial scan are finished; later ones were just opened
+    let scanned = false;
+    watcher.on('ready', () => (scanned = true));
 
     watcher.on('add', (filePath) => {
       const filename = path.basename(filePath);
@@ -52,14 +179,16 @@ export class SegmentManager {
       // For segments, they are created and then closed.
       if (ext !== '.mp4' && ext !== '.wav') return;
 
-      const type = ext === '.mp4' ? 'video' : 'audio';
+      const type: SegmentType =
+        ext === '.wav' ? 'audio' : path.dirname(filePath) === this.proxyDir ? 'proxy' : 'video';
       let timestamp = this.extractTimestamp(filename);
 
-      // Fallback to file creation/modification time if timestamp extraction fails (e.g. GStreamer files)
+      // Fallback to the file's times if timestamp extraction fails (e.g. GStreamer files):
+      // a just-opened segment's mtime is its start, a finished one's is its end
       if (!timestamp) {
         try {
           const stats = fs.statSync(filePath);
-          timestamp = stats.mtimeMs;
+          timestamp = scanned ? stats.mtimeMs : finishedSegmentStart(stats, type);
         } catch (err) {
           console.error(`Failed to get stats for ${filePath}:`, err);
           return;
@@ -73,8 +202,8 @@ export class SegmentManager {
   }
 
   private extractTimestamp(filename: string): number | null {
-    // Format: YYYYMMDD_HHMMSS.ext
-    const match = filename.match(/^(\d{8}_\d{6})/);
+    // Format: YYYYMMDD_HHMMSS.ext, or proxy_YYYYMMDD_HHMMSS.mp4
+    const match = filename.match(/^(?:proxy_)?(\d{8}_\d{6})/);
     if (!match) return null;
 
     const tsStr = match[1];
@@ -88,12 +217,61 @@ export class SegmentManager {
     return new Date(year, month, day, hour, min, sec).getTime();
   }
 
-  private registerSegment(filename: string, type: 'video' | 'audio', timestamp: number) {
+  private registerSegment(filename: string, type: SegmentType, timestamp: number) {
     const stmt = this.db.prepare(`
             INSERT OR IGNORE INTO segments (filename, type, timestamp)
             VALUES (?, ?, ?)
         `);
-    stmt.run(filename, type, timestamp);
+    if (stmt.run(filename, type, timestamp).changes > 0) {
+      this.emit('segment', filename);
+    }
+  }
+
+  /** Start time a segment was registered with, if it is tracked */
+  public getSegmentStart(filename: string): number | null {
+    const row = this.db
+      .prepare('SELECT timestamp FROM segments WHERE filename = ?')
+      .get(filename) as { timestamp: number } | undefined;
+    return row ? row.timestamp : null;
+  }
+
+  public setSpeechRatio(filename: string, ratio: number) {
+    this.db.prepare('UPDATE segments SET speech_ratio = ? WHERE filename = ?').run(ratio, filename);
+  }
+
+  /** Record a video segment's codec; false if the segment is no longer tracked */
+  public setCodec(filename: string, codec: string): boolean {
+    return this.db.prepare('UPDATE segments SET codec = ? WHERE filename = ?').run(codec, filename).changes > 0;
+  }
+
+  public getUnprobedVideo(limit = 10): Segment[] {
+    return this.db
+      .prepare(
+        `
+            SELECT * FROM segments
+            WHERE type = 'video' AND codec IS NULL
+            ORDER BY timestamp ASC
+            LIMIT ?
+        `
+      )
+      .all(limit) as Segment[];
+  }
+
+  /**
+   * Segments still in the camera's MJPEG, kept ones first (oldest first within
+   * each group). Unkept segments are only included when includeUnkept is set.
+   */
+  public getTranscodeCandidates(includeUnkept: boolean, limit = 10): Segment[] {
+    return this.db
+      .prepare(
+        `
+            SELECT * FROM segments
+            WHERE type = 'video' AND codec = 'mjpeg' AND (keep = 1 OR ?)
+            ORDER BY keep DESC, timestamp ASC
+            LIMIT ?
+        `
+      )
+      .all(includeUnkept ? 1 : 0, limit) as Segment[];
   }
 
   public markForKeeping(
@@ -114,6 +292,48 @@ export class SegmentManager {
     console.log(
       `Marked segments between ${new Date(start).toISOString()} and ${new Date(end).toISOString()} for keeping. Reason: ${reason}`
     );
+    this.emit('keep', { start, end, reason });
+  }
+
+  /** The proxy recorded alongside a full-res segment: same name, else nearest in time */
+  public findProxy(name: string, timestamp: number, toleranceMs = 2000): string | null {
+    const row = this.db
+      .prepare(
+        `
+            SELECT filename FROM segments
+            WHERE type = 'proxy' AND (filename = ? OR timestamp BETWEEN ? AND ?)
+            ORDER BY filename = ? DESC, ABS(timestamp - ?) ASC
+            LIMIT 1
+        `
+      )
+      .get(name, timestamp - toleranceMs, timestamp + toleranceMs, name, timestamp) as
+      | { filename: string }
+      | undefined;
+    return row ? row.filename : null;
+  }
+
+  /**
+   * Register a full-res segment committed from the pre-roll (already kept) and
+   * link it with its proxy both ways. Call before moving the file into the
+   * segments directory, so the watcher finds it registered.
+   */
+  public registerKept(filename: string, timestamp: number, reason: string, proxy: string | null) {
+    this.db
+      .prepare(
+        `
+            INSERT INTO segments (filename, type, timestamp, keep, reason, linked)
+            VALUES (?, 'video', ?, 1, ?, ?)
+            ON CONFLICT(filename) DO UPDATE SET keep = 1, reason = excluded.reason,
+                linked = excluded.linked
+        `
+      )
+      .run(filename, timestamp, reason, proxy);
+    if (proxy) {
+      this.db
+        .prepare("UPDATE segments SET linked = ?, keep = 1 WHERE filename = ? AND type = 'proxy'")
+        .run(filename, proxy);
+    }
+    this.emit('segment', filename);
   }
 
   private startCleanupJob() {
@@ -144,7 +364,12 @@ export class SegmentManager {
       return;
     }
 
-    const dir = oldestSegment.type === 'video' ? this.segmentsDir : this.audioDir;
+    const dir =
+      oldestSegment.type === 'video'
+        ? this.segmentsDir
+        : oldestSegment.type === 'proxy'
+          ? this.proxyDir
+          : this.audioDir;
     const filePath = path.join(dir, oldestSegment.filename);
 
     try {
@@ -162,6 +387,171 @@ export class SegmentManager {
     }
   }
 
+  public addTranscript(
+    source: string | null,
+    start: number,
+    end: number,
+    text: string,
+    words: TranscriptWord[] = []
+  ) {
+    const offsets = words.map((w) => [w.start - start, w.end - start, w.text]);
+    this.db
+      .prepare(
+        `
+            INSERT INTO transcripts (source, start, end, text, words)
+            VALUES (?, ?, ?, ?, ?)
+        `
+      )
+      .run(source, Math.round(start), Math.round(end), text, JSON.stringify(offsets));
+  }
+
+  /**
+   * Full-text search over transcripts, newest first. Plain words must all
+   * match (a trailing * matches a prefix); a "quoted query" matches the phrase.
+   */
+  public searchTranscripts(query: string, limit = 50): TranscriptMatch[] {
+    const phrase = /^\s*".*"\s*$/.test(query);
+    const terms = query.toLowerCase().match(/[\p{L}\p{N}]+\*?/gu) || [];
+    if (terms.length === 0) return [];
+
+    // Quote every term so user input can never be parsed as FTS syntax
+    const quote = (t: string) => (t.endsWith('*') ? `"${t.slice(0, -1)}"*` : `"${t}"`);
+    const ftsQuery = phrase ? `"${terms.map((t) => t.replace('*', '')).join(' ')}"` : terms.map(quote).join(' ');
+
+    const rows = this.db
+      .prepare(
+        `
+            SELECT t.id, t.source, t.start, t.end, t.text, t.words
+            FROM transcripts_fts f JOIN transcripts t ON t.id = f.rowid
+            WHERE transcripts_fts MATCH ?
+            ORDER BY t.start DESC
+            LIMIT ?
+        `
+      )
+      .all(ftsQuery, limit) as {
+      id: number;
+      source: string | null;
+      start: number;
+      end: number;
+      text: string;
+      words: string | null;
+    }[];
+
+    const findSegment = this.db.prepare(`
+            SELECT filename, timestamp FROM segments
+            WHERE type = 'video' AND timestamp <= ? AND timestamp > ?
+            ORDER BY timestamp DESC
+            LIMIT 1
+        `);
+
+    return rows.map((row) => {
+      const words: TranscriptWord[] = JSON.parse(row.words || '[]').map(
+        ([s, e, text]: [number, number, string]) => ({ start: row.start + s, end: row.start + e, text })
+      );
+      const matches = this.matchWords(words, terms, phrase);
+
+      const at = matches.length > 0 ? matches[0].start : row.start;
+      const video = findSegment.get(at, at - MAX_SEGMENT_MS) as
+        | { filename: string; timestamp: number }
+        | undefined;
+
+      return {
+        id: row.id,
+        source: row.source,
+        start: row.start,
+        end: row.end,
+        text: row.text,
+        matches,
+        segment: video ? { filename: video.filename, offsetMs: at - video.timestamp } : null,
+      };
+    });
+  }
+
+  // Locate query terms in the word timings for exact offsets
+  private matchWords(words: TranscriptWord[], terms: string[], phrase: boolean): TranscriptWord[] {
+    const normalize = (s: string) =>
+      s
+        .normalize('NFD')
+        .replace(/\p{M}/gu, '')
+        .toLowerCase()
+        .replace(/[^\p{L}\p{N}]/gu, '');
+    const keys = words.map((w) => normalize(w.text));
+    const hit = (key: string, term: string) =>
+      term.endsWith('*') ? key.startsWith(normalize(term)) : key === normalize(term);
+
+    const matches: TranscriptWord[] = [];
+    if (phrase) {
+      for (let i = 0; i + terms.length <= words.length; i++) {
+        if (terms.every((t, j) => hit(keys[i + j], t))) {
+          const last = words[i + terms.length - 1];
+          const text = words
+            .slice(i, i + terms.length)
+            .map((w) => w.text)
+            .join(' ');
+          matches.push({ start: words[i].start, end: last.end, text });
+        }
+      }
+    } else {
+      words.forEach((w, i) => {
+        if (terms.some((t) => hit(keys[i], t))) matches.push(w);
+      });
+    }
+    return matches;
+  }
+
+  /** Start a recording gap; returns its id for closeGap() */
+  public openGap(start: number, reason: string): number {
+    const result = this.db
+      .prepare('INSERT INTO capture_gaps (start, reason) VALUES (?, ?)')
+      .run(Math.round(start), reason);
+    return Number(result.lastInsertRowid);
+  }
+
+  public closeGap(id: number, end: number) {
+    this.db.prepare('UPDATE capture_gaps SET end = ? WHERE id = ?').run(Math.round(end), id);
+  }
+
+  public getRecentGaps(limit = 20): CaptureGap[] {
+    return this.db
+      .prepare('SELECT * FROM capture_gaps ORDER BY start DESC LIMIT ?')
+      .all(limit) as CaptureGap[];
+  }
+
+  /** Store a profile blob under a name, replacing any profile of that name */
+  public saveProfile(name: string, data: Buffer) {
+    // Blob header: "OBPF", format version, product type
+    this.db
+      .prepare(
+        `
+            INSERT OR REPLACE INTO profiles (name, version, product_type, created, data)
+            VALUES (?, ?, ?, ?, ?)
+        `
+      )
+      .run(name, data[4], data[5], Date.now(), data);
+  }
+
+  public getProfile(name: string): CameraProfile | undefined {
+    return this.db.prepare('SELECT * FROM profiles WHERE name = ?').get(name) as
+      | CameraProfile
+      | undefined;
+  }
+
+  /** Profiles without their data, plus its size in bytes */
+  public listProfiles() {
+    return this.db
+      .prepare(
+        `
+            SELECT name, version, product_type, created, length(data) AS size
+            FROM profiles ORDER BY name
+        `
+      )
+      .all();
+  }
+
+  public deleteProfile(name: string): boolean {
+    return this.db.prepare('DELETE FROM profiles WHERE name = ?').run(name).changes > 0;
+  }
+
   public getRecentSegments(limit = 20) {
     return this.db
       .prepare(
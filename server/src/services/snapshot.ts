@@ -0,0 +1,94 @@
+import * as fs from 'fs';
+import * as path from 'path';
+import { frameTapService, TappedFrame } from './frameTap';
+
+/**
+ * Snapshots straight from the camera's MJPEG stream: the original JPEG bytes
+ * are served or written as-is, with the capture time added in a COM marker,
+ * so no frame is ever decoded or re-encoded.
+ */
+export class SnapshotService {
+  private enabled = process.env.ENABLE_SNAPSHOTS !== 'false';
+  private snapshotsDir = path.join(process.cwd(), 'recordings', 'snapshots');
+  private intervalMs = parseInt(process.env.SNAPSHOT_INTERVAL_MS || '10000'); // 0 = on-demand only
+  private maxFiles = parseInt(process.env.SNAPSHOT_MAX_FILES || '360');
+  private lastSaved = 0;
+
+  constructor() {
+    if (!this.enabled || !frameTapService.start()) return;
+
+    if (this.intervalMs > 0) {
+      fs.mkdirSync(this.snapshotsDir, { recursive: true });
+      frameTapService.on('frame', (frame: TappedFrame) => this.onFrame(frame));
+      console.log(`[Snapshot] Saving a frame every ${this.intervalMs / 1000}s`);
+    }
+  }
+
+  /**
+   * Latest camera frame, waiting for the next one if the last is older than
+   * maxAgeMs. Resolves null if no frame arrives in time.
+   */
+  public capture(maxAgeMs = 1000, timeoutMs = 2000): Promise<TappedFrame | null> {
+    const latest = frameTapService.latest;
+    if (latest && Date.now() - latest.timestamp <= maxAgeMs) {
+      return Promise.resolve(this.stamp(latest));
+    }
+    if (!this.enabled) return Promise.resolve(null);
+
+    return new Promise((resolve) => {
+      const onFrame = (frame: TappedFrame) => {
+        clearTimeout(timer);
+        resolve(this.stamp(frame));
+      };
+      const timer = setTimeout(() => {
+        frameTapService.off('frame', onFrame);
+        resolve(null);
+      }, timeoutMs);
+      frameTapService.once('frame', onFrame);
+    });
+  }
+
+  // Insert a COM segment after SOI: cheap byte splice, image data untouched
+  private stamp(frame: TappedFrame): TappedFrame {
+    const { jpeg, timestamp } = frame;
+    if (jpeg.length < 2 || jpeg[0] !== 0xff || jpeg[1] !== 0xd8) return frame;
+
+    const text = Buffer.from(`obsbot-remote ${new Date(timestamp).toISOString()}`);
+    const marker = Buffer.from([0xff, 0xfe, 0, 0]);
+    marker.writeUInt16BE(text.length + 2, 2);
+
+    return { jpeg: Buffer.concat([jpeg.subarray(0, 2), marker, text, jpeg.subarray(2)]), timestamp };
+  }
+
+  private onFrame(frame: TappedFrame) {
+    if (frame.timestamp - this.lastSaved < this.intervalMs) return;
+    this.lastSaved = frame.timestamp;
+
+    // Format: snap_YYYYMMDD_HHMMSS_mmm.jpg (UTC)
+    const name = new Date(frame.timestamp)
+      .toISOString()
+      .replace(/[-:]/g, '')
+      .replace('T', '_')
+      .replace('.', '_')
+      .replace('Z', '');
+    const filePath = path.join(this.snapshotsDir, `snap_${name}.jpg`);
+
+    fs.promises
+      .writeFile(filePath, this.stamp(frame).jpeg)
+      .then(() => this.prune())
+      .catch((error) => console.error(`[Snapshot] Failed to write ${filePath}:`, error.message));
+  }
+
+  // Keep only the newest maxFiles periodic snapshots
+  private async prune() {
+    const files = (await fs.promises.readdir(this.snapshotsDir))
+      .filter((f) => f.startsWith('snap_') && f.endsWith('.jpg'))
+      .sort();
+
+    for (const file of files.slice(0, Math.max(0, files.length - this.maxFiles))) {
+      await fs.promises.unlink(path.join(this.snapshotsDir, file)).catch(() => {});
+    }
+  }
+}
+
+export const snapshotService = new SnapshotService();
@@ -0,0 +1,203 @@
+import { WebSocketServer, WebSocket } from 'ws';
+import type { IncomingMessage } from 'http';
+import type { Duplex } from 'stream';
+import { cameraService } from './camera';
+import { segmentManager } from './segmentManager';
+
+function isObject(value: any): boolean {
+  return value !== null && typeof value === 'object' && !Array.isArray(value);
+}
+
+// JSON merge patch (RFC 7386) taking prev to next; undefined when nothing changed
+function mergePatch(prev: any, next: any): any {
+  if (!isObject(prev) || !isObject(next)) {
+    return JSON.stringify(prev) === JSON.stringify(next) ? undefined : next;
+  }
+  const patch: Record<string, any> = {};
+  let changed = false;
+  for (const key of Object.keys(next)) {
+    const value = mergePatch(prev[key], next[key]);
+    if (value !== undefined) {
+      patch[key] = value;
+      changed = true;
+    }
+  }
+  for (const key of Object.keys(prev)) {
+    if (!(key in next)) {
+      patch[key] = null;
+      changed = true;
+    }
+  }
+  return changed ? patch : undefined;
+}
+
+/**
+ * Status push on /ws/status. A client gets one full snapshot when it
+ * connects, then only what changed: the camera state as a JSON merge patch
+ * (changed keys only, null removes a key, arrays replaced whole) and
+ * segments as the rows that are new or changed. Most changes cost no camera
+ * read: statuses the camera pushes are applied as they arrive, and zoom
+ * comes from the native shadow register, checked every
+ * STATUS_STREAM_INTERVAL_MS. The full state is re-read on the native
+ * settings thread, never the JS thread, when a command has marked it stale
+ * or STATUS_STREAM_REFRESH_MS has passed, one read at a time. Segments are
+ * re-read only when the database registers or keeps one. Every viewer gets
+ * the same message, so any number of them cost one read.
+ */
+export class StatusStreamService {
+  private intervalMs = parseInt(process.env.STATUS_STREAM_INTERVAL_MS || '200');
+  private refreshMs = parseInt(process.env.STATUS_STREAM_REFRESH_MS || '2000');
+  private wss = new WebSocketServer({ noServer: true });
+  private clients: Set<WebSocket> = new Set();
+  private timer: NodeJS.Timeout | null = null;
+
+  private state: any = null;
+  private segments: any[] = [];
+  private sentRows = new Map<string, string>(); // filename -> row as last sent
+  private stale = true;
+  private segmentsStale = true;
+  private reading = false;
+  private lastRead = 0;
+  private pushed: { at: number; status: any } | null = null; // last status the camera pushed
+  private seq = 0;
+
+  private reads = 0;
+  private pushes = 0;
+  private messages = 0;
+  private bytesSent = 0;
+
+  constructor() {
+    this.wss.on('connection', (ws: WebSocket) => this.onConnection(ws));
+    segmentManager.on('segment', () => (this.segmentsStale = true));
+    segmentManager.on('keep', () => (this.segmentsStale = true));
+    cameraService.on('warm', () => (this.stale = true));
+    cameraService.on('status', (status: any) => this.onPushedStatus(status));
+  }
+
+  public handleUpgrade(req: IncomingMessage, socket: Duplex, head: Buffer) {
+    this.wss.handleUpgrade(req, socket, head, (ws) => this.wss.emit('connection', ws, req));
+  }
+
+  /** The camera state may have changed (a command went out); re-read on the next tick */
+  public invalidate() {
+    this.stale = true;
+  }
+
+  // Pushed statuses carry no gesture settings, so they're merged over the last state
+  private onPushedStatus(status: any) {
+    this.pushed = { at: Date.now(), status };
+    this.pushes++;
+    if (this.clients.size === 0 || !this.state?.camera?.status) return;
+    const camera = { ...this.state.camera, status: { ...this.state.camera.status, ...status } };
+    this.publishState({ ...this.state, camera });
+  }
+
+  private onConnection(ws: WebSocket) {
+    if (this.clients.size === 0) {
+      // Nobody was watching, so nothing was read; catch up. Segments make the
+      // snapshot, the camera read lands as a delta right after it
+      this.stale = true;
+      this.segmentsStale = true;
+      this.tick();
+      this.timer = setInterval(() => this.tick(), this.intervalMs);
+    }
+    this.clients.add(ws);
+    this.send([ws], {
+      type: 'snapshot',
+      seq: this.seq,
+      payload: { state: this.state, segments: this.segments },
+    });
+
+    ws.on('close', () => {
+      this.clients.delete(ws);
+      if (this.clients.size === 0 && this.timer) {
+        clearInterval(this.timer);
+        this.timer = null;
+      }
+    });
+  }
+
+  private tick() {
+    const payload: { state?: any; segments?: any[] } = {};
+
+    if (!this.reading && (this.stale || Date.now() - this.lastRead >= this.refreshMs)) {
+      this.readState();
+    }
+
+    const zoom = cameraService.getKnownZoom();
+    if (zoom !== null && this.state?.camera && 'zoom' in this.state.camera) {
+      const patch = this.setState({ ...this.state, camera: { ...this.state.camera, zoom } });
+      if (patch !== undefined) payload.state = patch;
+    }
+
+    if (this.segmentsStale) {
+      this.segmentsStale = false;
+      this.segments = segmentManager.getRecentSegments();
+      const rows = new Map(this.segments.map((s) => [s.filename, JSON.stringify(s)]));
+      const changed = this.segments.filter(
+        (s) => this.sentRows.get(s.filename) !== rows.get(s.filename)
+      );
+      this.sentRows = rows;
+      if (changed.length > 0) payload.segments = changed;
+    }
+
+    if (payload.state === undefined && payload.segments === undefined) return;
+    this.seq++;
+    this.send(this.clients, { type: 'delta', seq: this.seq, payload });
+  }
+
+  private async readState() {
+    this.reading = true;
+    this.stale = false;
+    const started = (this.lastRead = Date.now());
+    this.reads++;
+    try {
+      const next = await cameraService.readState();
+      // A status pushed while the read was out is newer than what it returned
+      if (this.pushed && this.pushed.at >= started && next.camera?.status) {
+        next.camera.status = { ...next.camera.status, ...this.pushed.status };
+      }
+      this.publishState(next);
+    } finally {
+      this.reading = false;
+    }
+  }
+
+  // Replace the state; returns the merge patch, undefined when nothing changed
+  private setState(next: any) {
+    const patch = mergePatch(this.state, next);
+    this.state = next;
+    return patch;
+  }
+
+  private publishState(next: any) {
+    const patch = this.setState(next);
+    if (patch === undefined) return;
+    this.seq++;
+    this.send(this.clients, { type: 'delta', seq: this.seq, payload: { state: patch } });
+  }
+
+  private send(targets: Iterable<WebSocket>, message: any) {
+    const data = JSON.stringify(message);
+    for (const ws of targets) {
+      if (ws.readyState !== WebSocket.OPEN) continue;
+      ws.send(data);
+      this.messages++;
+      this.bytesSent += data.length;
+    }
+  }
+
+  public getStats() {
+    return {
+      clients: this.clients.size,
+      intervalMs: this.intervalMs,
+      seq: this.seq,
+      reads: this.reads,
+      pushes: this.pushes,
+      messages: this.messages,
+      bytesSent: this.bytesSent,
+    };
+  }
+}
+
+export const statusStreamService = new StatusStreamService();
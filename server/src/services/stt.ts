@@ -1,40 +1,213 @@
-import { exec } from 'child_process';
+import { exec, spawnSync } from 'child_process';
+import { EventEmitter } from 'events';
+import * as net from 'net';
 import * as path from 'path';
 import * as fs from 'fs';
 import * as chokidar from 'chokidar';
-import { segmentManager } from './segmentManager';
+import { segmentManager, finishedSegmentStart, TranscriptWord } from './segmentManager';
+import { keywordService } from './keywords';
+import { obsbot } from './native';
 
-export class STTService {
+export interface TranscriptEvent {
+  type: 'partial' | 'final';
+  utterance: number;
+  text: string;
+  start: number; // epoch ms
+  end: number;
+  words?: TranscriptWord[]; // finals only
+  elapsedMs: number;
+}
+
+export class STTService extends EventEmitter {
   private audioDir = path.join(process.cwd(), 'recordings', 'audio');
   private whisperPath = process.env.WHISPER_PATH || './whisper.cpp';
   private whisperModel = process.env.WHISPER_MODEL || 'models/ggml-base.bin';
+  private whisperThreads = parseInt(process.env.WHISPER_THREADS || '4');
+  private queueSize = parseInt(process.env.STT_QUEUE_SIZE || '4');
+  private worker: any = null;
+  // Segments with less voiced audio than this are not transcribed
+  private minSpeechRatio = parseFloat(process.env.STT_MIN_SPEECH_RATIO || '0.05');
+
+  // Live PCM path: the capture pipeline writes 16 kHz mono S16LE into this FIFO
+  private streamEnabled = process.env.STT_STREAM === 'true';
+  private pcmFifo = process.env.STT_PCM_FIFO || '/tmp/obsbot-stt.pcm';
+  private pcmSocket: net.Socket | null = null;
+  private streaming = false; // the worker transcribes the FIFO instead of finished files
+  private triggeredUtterance = -1;
 
   constructor() {
+    super();
     if (process.env.ENABLE_STT === 'true') {
+      this.startWorker();
+      // Streaming replaces per-file transcription when the native worker is
+      // available; finished WAVs are still scored for speech either way.
+      if (this.streamEnabled && this.worker) {
+        this.startStreaming();
+      }
       this.startWatching();
     }
   }
 
+  /** FIFO the capture service should write live PCM into, if streaming is active */
+  public get pcmOutput(): string | undefined {
+    return this.streaming ? this.pcmFifo : undefined;
+  }
+
+  private startWorker() {
+    // The native worker keeps the model loaded; it only exists when the addon
+    // was built against whisper.cpp (WHISPER_DIR). Otherwise use the CLI.
+    if (!obsbot?.SttWorker) {
+      console.log('[STT] Native worker not available, using whisper CLI');
+      return;
+    }
+
+    try {
+      this.worker = new obsbot.SttWorker({
+        model: this.whisperModel,
+        threads: this.whisperThreads,
+        queueSize: this.queueSize,
+      });
+      console.log(
+        `[STT] Native worker started (${this.whisperThreads} threads, queue ${this.queueSize})`
+      );
+    } catch (error) {
+      console.error('[STT] Failed to start native worker, using whisper CLI:', error);
+      this.worker = null;
+    }
+  }
+
+  private ensureFifo(): boolean {
+    try {
+      if (fs.existsSync(this.pcmFifo)) {
+        if (fs.statSync(this.pcmFifo).isFIFO()) return true;
+        fs.unlinkSync(this.pcmFifo);
+      }
+      return spawnSync('mkfifo', [this.pcmFifo]).status === 0;
+    } catch (error) {
+      console.error(`[STT] Failed to create FIFO ${this.pcmFifo}:`, error);
+      return false;
+    }
+  }
+
+  private startStreaming(): boolean {
+    if (!this.ensureFifo()) return false;
+
+    // Opening read-write never blocks and keeps the FIFO alive across capture
+    // restarts, so the writer's open() succeeds even before we read.
+    const fd = fs.openSync(this.pcmFifo, fs.constants.O_RDWR | fs.constants.O_NONBLOCK);
+    this.pcmSocket = new net.Socket({ fd, readable: true, writable: false });
+
+    let leftover: Buffer | null = null;
+    this.pcmSocket.on('data', (chunk: Buffer) => {
+      if (!this.streaming) return; // drained only
+      // Keep sample alignment across reads
+      const data = leftover ? Buffer.concat([leftover, chunk]) : chunk;
+      const even = data.length & ~1;
+      leftover = even < data.length ? data.subarray(even) : null;
+      this.worker.pushPcm(data.subarray(0, even), Date.now());
+    });
+
+    this.pcmSocket.on('error', (error) => {
+      console.error('[STT] PCM stream error:', error.message);
+    });
+
+    this.streaming = true;
+    console.log(`[STT] Streaming live PCM from ${this.pcmFifo}`);
+    this.startStreamWhenLoaded();
+    return true;
+  }
+
+  // The model loads on the worker thread and the stream needs it; PCM that
+  // arrives before then is dropped by pushPcm
+  private startStreamWhenLoaded() {
+    if (!this.worker) return;
+    const stats = this.worker.getStats();
+    if (stats.error) {
+      // Without a model the worker can't transcribe files either; fall back to
+      // the whisper CLI per file. The FIFO stays open and is only drained, since
+      // a capture pipeline may already be writing into it.
+      console.error(`[STT] ${stats.error}, live transcription disabled, using whisper CLI`);
+      this.streaming = false;
+      this.worker.close();
+      this.worker = null;
+      return;
+    }
+    if (!stats.loaded) {
+      setTimeout(() => this.startStreamWhenLoaded(), 250);
+      return;
+    }
+    this.worker.startStream(
+      {
+        windowMs: parseInt(process.env.STT_WINDOW_MS || '5000'),
+        stepMs: parseInt(process.env.STT_STEP_MS || '1000'),
+      },
+      (event: TranscriptEvent) => this.handleStreamEvent(event)
+    );
+  }
+
+  private handleStreamEvent(event: TranscriptEvent) {
+    this.emit(event.type, event);
+
+    if (event.type === 'final') {
+      console.log(`[STT] Final (${Math.round(event.elapsedMs)} ms): "${event.text}"`);
+      segmentManager.addTranscript(null, event.start, event.end, event.text, event.words);
+    }
+
+    // Partials let a trigger fire while the speaker is still talking; each
+    // utterance marks segments at most once.
+    if (event.utterance === this.triggeredUtterance) return;
+    if (this.checkTriggers(event.text, event.start)) {
+      this.triggeredUtterance = event.utterance;
+    }
+  }
+
   private startWatching() {
     const watcher = chokidar.watch(this.audioDir, {
       ignored: /(^|[\/\\])\../,
       persistent: true,
       ignoreInitial: true,
+      // Segments are written for their whole duration; score the finished file
+      awaitWriteFinish: {
+        stabilityThreshold: 1000,
+        pollInterval: 250,
+      },
     });
 
     watcher.on('add', (filePath) => {
       if (path.extname(filePath) === '.wav') {
-        // For GStreamer, the file might be renamed or completed.
-        // We Wait for a bit to ensure it's written.
-        setTimeout(() => {
-          this.processAudio(filePath);
-        }, 1000);
+        this.processAudio(filePath);
       }
     });
   }
 
+  /** Score a segment with the native VAD and record its speech ratio */
+  private hasSpeech(filePath: string): boolean {
+    if (!obsbot?.analyzeVoiceActivity) return true;
+
+    const vad = obsbot.analyzeVoiceActivity(filePath);
+    if (!vad) return true;
+
+    const filename = path.basename(filePath);
+    segmentManager.setSpeechRatio(filename, vad.speechRatio);
+
+    if (vad.speechRatio < this.minSpeechRatio) {
+      console.log(
+        `[STT] Skipping ${filename}: ${(vad.speechRatio * 100).toFixed(1)}% speech (${Math.round(vad.elapsedUs)} us)`
+      );
+      return false;
+    }
+    return true;
+  }
+
   private async processAudio(filePath: string) {
-    const command = `${this.whisperPath} -m ${this.whisperModel} -f ${filePath} -otxt`;
+    if (!this.hasSpeech(filePath) || this.streaming) return;
+
+    if (this.worker) {
+      return this.processWithWorker(filePath);
+    }
+
+    // One word per JSON entry gives word-level timestamps for the index
+    const command = `${this.whisperPath} -m ${this.whisperModel} -f ${filePath} -oj -ml 1 -sow`;
 
     console.log(`[STT] Processing ${path.basename(filePath)}...`);
 
@@ -44,46 +217,89 @@ export class STTService {
         return;
       }
 
-      // Read the generated .txt file
-      const txtPath = filePath + '.txt';
-      if (fs.existsSync(txtPath)) {
-        const transcript = fs.readFileSync(txtPath, 'utf-8').trim();
-        console.log(`[STT] Transcript for ${path.basename(filePath)}: "${transcript}"`);
+      // Read the generated .json file
+      const jsonPath = filePath + '.json';
+      if (fs.existsSync(jsonPath)) {
+        try {
+          const output = JSON.parse(fs.readFileSync(jsonPath, 'utf-8'));
+          const words: TranscriptWord[] = (output.transcription || [])
+            .map((entry: any) => ({
+              start: entry.offsets.from,
+              end: entry.offsets.to,
+              text: String(entry.text).trim(),
+            }))
+            .filter((w: TranscriptWord) => w.text);
+          const transcript = words.map((w) => w.text).join(' ');
+          console.log(`[STT] Transcript for ${path.basename(filePath)}: "${transcript}"`);
 
-        // Clean up the .txt file
-        fs.unlinkSync(txtPath);
+          this.handleTranscript(transcript, filePath, words);
+        } catch (err) {
+          console.error(`[STT] Failed to parse ${jsonPath}:`, err);
+        }
 
-        // Here we could trigger a callback or emit an event
-        this.handleTranscript(transcript, filePath);
+        // Clean up the .json file
+        fs.unlinkSync(jsonPath);
       }
     });
   }
 
-  private handleTranscript(transcript: string, filePath: string) {
-    if (!transcript) return;
+  private async processWithWorker(filePath: string) {
+    console.log(`[STT] Processing ${path.basename(filePath)}...`);
+
+    try {
+      const result = await this.worker.transcribe(filePath);
+      console.log(
+        `[STT] Transcript for ${path.basename(filePath)} (${Math.round(result.elapsedMs)} ms): "${result.text}"`
+      );
+      const words = result.segments.flatMap((seg: any) => seg.words);
+      this.handleTranscript(result.text, filePath, words);
+    } catch (error: any) {
+      // Includes "STT queue full" when segments arrive faster than we can transcribe
+      console.error(`[STT] Error processing ${filePath}:`, error.message);
+    }
+  }
 
-    // Simple trigger logic: if transcript contains "look" or "amazing", mark for keeping
-    const keywords = ['look', 'amazing', 'god', 'wow', 'baby', 'dancing'];
-    const found = keywords.some((kw) => transcript.toLowerCase().includes(kw));
+  /** words are relative to the start of the file */
+  private handleTranscript(transcript: string, filePath: string, words: TranscriptWord[]) {
+    if (!transcript) return;
 
-    if (found) {
-      const filename = path.basename(filePath);
-      let ts = this.extractTimestamp(filename);
+    const filename = path.basename(filePath);
+    // Files without a timestamp in their name use the start they were registered with
+    let ts = this.extractTimestamp(filename) ?? segmentManager.getSegmentStart(filename);
 
-      if (!ts) {
-        try {
-          ts = fs.statSync(filePath).mtimeMs;
-        } catch (err) {
-          console.error(`[STT] Failed to get stats for ${filePath}:`, err);
-        }
+    if (!ts) {
+      try {
+        ts = finishedSegmentStart(fs.statSync(filePath), 'audio');
+      } catch (err) {
+        console.error(`[STT] Failed to get stats for ${filePath}:`, err);
       }
+    }
 
-      if (ts) {
-        segmentManager.markForKeeping(ts, `Audio Trigger: "${transcript}"`);
-      }
+    if (ts) {
+      const start = ts;
+      const absolute = words.map((w) => ({ ...w, start: start + w.start, end: start + w.end }));
+      const end = absolute.length > 0 ? absolute[absolute.length - 1].end : start;
+      segmentManager.addTranscript(filename, start, end, transcript, absolute);
+
+      this.checkTriggers(transcript, ts);
     }
   }
 
+  private checkTriggers(transcript: string, timestamp: number): boolean {
+    const hits = keywordService.match(transcript, timestamp);
+
+    for (const { rule, phrase } of hits) {
+      console.log(`[STT] Rule "${rule.name}" matched "${phrase}"`);
+      segmentManager.markForKeeping(
+        timestamp,
+        `${rule.reason}: "${transcript}"`,
+        rule.bufferBeforeMs,
+        rule.bufferAfterMs
+      );
+    }
+    return hits.length > 0;
+  }
+
   private extractTimestamp(filename: string): number | null {
     const match = filename.match(/^(\d{8}_\d{6})/);
     if (!match) return null;
@@ -96,6 +312,17 @@ export class STTService {
     const sec = parseInt(tsStr.substring(13, 15));
     return new Date(year, month, day, hour, min, sec).getTime();
   }
+
+  public close() {
+    if (this.pcmSocket) {
+      this.pcmSocket.destroy();
+      this.pcmSocket = null;
+    }
+    if (this.worker) {
+      this.worker.close();
+      this.worker = null;
+    }
+  }
 }
 
 export const sttService = new STTService();
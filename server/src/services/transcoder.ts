@@ -0,0 +1,311 @@
+import { spawn, spawnSync, execFile, ChildProcess } from 'child_process';
+import * as os from 'os';
+import * as path from 'path';
+import * as fs from 'fs';
+import { segmentManager, Segment } from './segmentManager';
+
+// Segments are finalized well within this after their last write
+const SETTLE_MS = 15000;
+// Throttle resolution; the encoder is paused and resumed at this granularity
+const TICK_MS = 250;
+// /proc/<pid>/stat times are in clock ticks (USER_HZ)
+const CLOCK_TICKS = 100;
+// ffprobe runs at once, so a backlog of segments doesn't fork a burst of them
+const PROBE_CONCURRENCY = 2;
+
+interface TranscodeJob {
+  segment: Segment;
+  process: ChildProcess;
+  tmpPath: string;
+  idleOnly: boolean; // unkept segment, only worked on while the host is idle
+  started: number;
+  cpuTicks: number; // encoder CPU at the last tick
+  debt: number; // CPU-seconds used beyond the budget
+  stopped: boolean;
+}
+
+/**
+ * Converts segments recorded as raw camera MJPEG (RECORD_MODE=raw) to HEVC
+ * after the fact. Kept segments are always converted; the rest only while the
+ * host is otherwise idle, since most are deleted unwatched. The encoder runs
+ * at nice 19 in the idle I/O class, and is paused with SIGSTOP whenever it
+ * gets ahead of TRANSCODE_CPU_BUDGET cores.
+ */
+export class TranscoderService {
+  private enabled = process.env.ENABLE_TRANSCODER
+    ? process.env.ENABLE_TRANSCODER === 'true'
+    : process.env.RECORD_MODE === 'raw';
+  private segmentsDir = path.join(process.cwd(), 'recordings', 'segments');
+  private encoder = process.env.TRANSCODE_ENCODER || 'libx265';
+  private preset = process.env.TRANSCODE_PRESET || 'fast';
+  private crf = process.env.TRANSCODE_CRF || '26';
+  private cpuBudget = parseFloat(process.env.TRANSCODE_CPU_BUDGET || '1'); // cores
+  private idleCpu = parseFloat(process.env.TRANSCODE_IDLE_CPU || '0.3'); // busy fraction
+  private pollMs = parseInt(process.env.TRANSCODE_POLL_MS || '10000');
+
+  private job: TranscodeJob | null = null;
+  private failed = new Set<string>();
+  private probing = new Set<string>(); // segments with an ffprobe running
+  private hasIonice = false;
+  private lastCpu = this.sampleCpu();
+  private hostBusy = 0; // busy fraction of all cores, excluding the encoder
+  private pollTimer: NodeJS.Timeout | null = null;
+  private tickTimer: NodeJS.Timeout | null = null;
+  private stats = { transcoded: 0, failed: 0, bytesIn: 0, bytesOut: 0 };
+
+  constructor() {
+    if (!this.enabled) return;
+
+    this.hasIonice = spawnSync('ionice', ['--version'], { stdio: 'ignore' }).status === 0;
+    this.pollTimer = setInterval(() => this.poll(), this.pollMs);
+    this.tickTimer = setInterval(() => this.tick(), TICK_MS);
+    console.log(
+      `[Transcoder] Converting MJPEG segments to HEVC (${this.encoder}, budget ${this.cpuBudget} cores)`
+    );
+  }
+
+  private poll() {
+    this.probeNewSegments();
+    if (this.job) return;
+
+    const idle = this.hostBusy < this.idleCpu;
+    const next = segmentManager
+      .getTranscodeCandidates(idle, 10)
+      .find((s) => !this.failed.has(s.filename));
+    if (next) this.startJob(next, !next.keep);
+  }
+
+  // Codec of every finished video segment, so only camera MJPEG is queued.
+  // ffprobe runs asynchronously; its result is stored when it exits.
+  private probeNewSegments() {
+    for (const segment of segmentManager.getUnprobedVideo(10)) {
+      if (this.probing.size >= PROBE_CONCURRENCY) return;
+      if (this.probing.has(segment.filename)) continue;
+      const filePath = path.join(this.segmentsDir, segment.filename);
+      let mtime: number;
+      try {
+        mtime = fs.statSync(filePath).mtimeMs;
+      } catch {
+        continue; // deleted or renamed; the row goes with it
+      }
+      if (Date.now() - mtime < SETTLE_MS) continue;
+
+      this.probing.add(segment.filename);
+      execFile(
+        'ffprobe',
+        ['-v', 'error', '-select_streams', 'v:0', '-show_entries', 'stream=codec_name', '-of', 'csv=p=0', filePath],
+        { encoding: 'utf8' },
+        (err, stdout) => {
+          this.probing.delete(segment.filename);
+          if (!this.pollTimer) return; // closed meanwhile
+          const codec = err ? '' : stdout.trim();
+          segmentManager.setCodec(segment.filename, codec || 'unknown');
+          this.probeNewSegments();
+        }
+      );
+    }
+  }
+
+  private startJob(segment: Segment, idleOnly: boolean) {
+    const input = path.join(this.segmentsDir, segment.filename);
+    // Hidden name: ignored by the segment watchers until renamed over the original
+    const tmpPath = path.join(this.segmentsDir, `.${segment.filename}.transcode`);
+
+    const encoderArgs =
+      this.encoder === 'libx265'
+        ? [
+            '-preset',
+            this.preset,
+            '-crf',
+            this.crf,
+            // Size x265's thread pool to the budget rather than the whole machine
+            '-x265-params',
+            `pools=${Math.max(1, Math.ceil(this.cpuBudget))}:frame-threads=1:log-level=error`,
+          ]
+        : ['-cq', this.crf];
+
+    const args = [
+      '-hide_banner',
+      '-loglevel',
+      'error',
+      '-y',
+      '-i',
+      input,
+      '-map',
+      '0',
+      '-c:v',
+      this.encoder,
+      ...encoderArgs,
+      '-pix_fmt',
+      'yuv420p',
+      '-tag:v',
+      'hvc1', // playable in Safari/QuickTime
+      '-c:a',
+      'copy', // already AAC
+      '-movflags',
+      '+faststart',
+      '-f',
+      'mp4',
+      tmpPath,
+    ];
+
+    const child = this.hasIonice
+      ? spawn('ionice', ['-c', '3', 'ffmpeg', ...args]) // ionice execs ffmpeg, same pid
+      : spawn('ffmpeg', args);
+    try {
+      if (child.pid) os.setPriority(child.pid, 19);
+    } catch {}
+
+    const job: TranscodeJob = {
+      segment,
+      process: child,
+      tmpPath,
+      idleOnly,
+      started: Date.now(),
+      cpuTicks: 0,
+      debt: 0,
+      stopped: false,
+    };
+    this.job = job;
+
+    let stderr = '';
+    child.stderr?.on('data', (data) => {
+      stderr = (stderr + data.toString()).slice(-2000);
+    });
+    child.on('error', (err) => {
+      console.error('[Transcoder] Failed to start ffmpeg:', err.message);
+    });
+    child.on('close', (code) => this.finishJob(job, code, stderr));
+  }
+
+  private finishJob(job: TranscodeJob, code: number | null, stderr: string) {
+    if (this.job === job) this.job = null;
+    const { filename } = job.segment;
+    const filePath = path.join(this.segmentsDir, filename);
+
+    if (code !== 0) {
+      fs.rmSync(job.tmpPath, { force: true });
+      if (code !== null) {
+        // Killed by close() is not a failure; anything else is not retried
+        this.failed.add(filename);
+        this.stats.failed++;
+        console.error(`[Transcoder] ${filename} failed (exit ${code}): ${stderr.trim()}`);
+      }
+      return;
+    }
+
+    try {
+      const before = fs.statSync(filePath).size;
+      const after = fs.statSync(job.tmpPath).size;
+
+      // Cleanup may have dropped the segment while it was being converted
+      if (!segmentManager.setCodec(filename, 'hevc')) {
+        fs.rmSync(job.tmpPath, { force: true });
+        return;
+      }
+      fs.renameSync(job.tmpPath, filePath);
+
+      this.stats.transcoded++;
+      this.stats.bytesIn += before;
+      this.stats.bytesOut += after;
+      const seconds = ((Date.now() - job.started) / 1000).toFixed(1);
+      console.log(
+        `[Transcoder] ${filename}: ${(before / 1e6).toFixed(1)} MB -> ${(after / 1e6).toFixed(1)} MB in ${seconds}s`
+      );
+    } catch (error: any) {
+      fs.rmSync(job.tmpPath, { force: true });
+      console.error(`[Transcoder] Failed to replace ${filename}:`, error.message);
+    }
+  }
+
+  /**
+   * Measures host load and enforces the CPU budget as a leaky bucket: CPU
+   * time used beyond the budget is paid back by keeping the encoder stopped.
+   * Idle-only jobs are also held while the rest of the host is busy.
+   */
+  private tick() {
+    const cpu = this.sampleCpu();
+    const busyMs = cpu.busy - this.lastCpu.busy; // summed over all cores
+    const totalMs = cpu.total - this.lastCpu.total;
+    this.lastCpu = cpu;
+
+    const job = this.job;
+    let encoderMs = 0;
+    if (job?.process.pid) {
+      const ticks = this.readProcessTicks(job.process.pid);
+      if (ticks !== null) {
+        if (job.cpuTicks > 0) encoderMs = ((ticks - job.cpuTicks) * 1000) / CLOCK_TICKS;
+        job.cpuTicks = ticks;
+      }
+    }
+
+    if (totalMs > 0) {
+      // Smooth over a few seconds so a single spike doesn't flip the state
+      const hostBusy = Math.max(0, busyMs - encoderMs) / totalMs;
+      this.hostBusy = 0.9 * this.hostBusy + 0.1 * hostBusy;
+    }
+
+    if (!job) return;
+
+    job.debt = Math.max(0, job.debt + encoderMs / 1000 - (this.cpuBudget * TICK_MS) / 1000);
+    const hold = job.debt > 0 || (job.idleOnly && this.hostBusy >= this.idleCpu);
+    if (hold !== job.stopped) {
+      job.stopped = hold;
+      job.process.kill(hold ? 'SIGSTOP' : 'SIGCONT');
+    }
+  }
+
+  // Busy and total CPU time in ms, summed over all cores
+  private sampleCpu() {
+    let busy = 0;
+    let total = 0;
+    for (const { times } of os.cpus()) {
+      total += times.user + times.nice + times.sys + times.irq + times.idle;
+      busy += times.user + times.nice + times.sys + times.irq;
+    }
+    return { busy, total };
+  }
+
+  // utime + stime of a process (fields 14 and 15 of /proc/<pid>/stat)
+  private readProcessTicks(pid: number): number | null {
+    try {
+      const stat = fs.readFileSync(`/proc/${pid}/stat`, 'utf8');
+      const fields = stat.slice(stat.lastIndexOf(')') + 2).split(' ');
+      return parseInt(fields[11]) + parseInt(fields[12]);
+    } catch {
+      return null;
+    }
+  }
+
+  public getStats() {
+    if (!this.enabled) return null;
+    return {
+      ...this.stats,
+      hostBusy: Math.round(this.hostBusy * 100) / 100,
+      current: this.job
+        ? {
+            filename: this.job.segment.filename,
+            keep: !!this.job.segment.keep,
+            paused: this.job.stopped,
+            elapsedMs: Date.now() - this.job.started,
+          }
+        : null,
+    };
+  }
+
+  public close() {
+    if (this.pollTimer) clearInterval(this.pollTimer);
+    if (this.tickTimer) clearInterval(this.tickTimer);
+    this.pollTimer = this.tickTimer = null;
+
+    const job = this.job;
+    if (job) {
+      this.job = null;
+      if (job.stopped) job.process.kill('SIGCONT');
+      job.process.kill('SIGKILL');
+      fs.rmSync(job.tmpPath, { force: true });
+    }
+  }
+}
+
+export const transcoderService = new TranscoderService();